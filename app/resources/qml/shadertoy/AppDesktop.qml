@@ -96,6 +96,9 @@ Desktop {
     function loadShader(shader) {
         console.log("Got shader data " + shader )
         currentShader = shader;
+        if (shader) {
+            shadertoyCache.setActiveShader(shader.info.id);
+        }
         renderer.setShader(shader);
         renderer.build();
     }
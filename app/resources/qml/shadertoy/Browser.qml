@@ -62,7 +62,8 @@ Window {
                 id: searchField
                 anchors { top: parent.top; left: parent.left; right: queryParams.left; rightMargin: 16 }
                 placeholderText: "Search"
-                onTextChanged: { refreshTimer.interval = 1500;  refreshTimer.restart(); }
+                // Offline queries are answered from the local search index, so they can keep up with typing
+                onTextChanged: { refreshTimer.interval = shadertoy.api.offline ? 100 : 1500;  refreshTimer.restart(); }
                 onAccepted: { refreshTimer.interval = 100;  refreshTimer.restart(); }
                 Timer {
                     id: refreshTimer
@@ -112,11 +113,13 @@ Window {
                     model: shaderModel
                     delegate: ShaderPreview {
                         width: flow.width
-                        shader: modelShader
+                        shaderInfo: modelInfo
                         shaderId: modelShaderId
-                        Component.onCompleted: console.log("Shader " + shader + " shader id " + shaderId);
+                        Component.onCompleted: console.log("Shader " + shaderId);
                         MouseArea {
                             anchors.fill: parent;
+                            hoverEnabled: true
+                            onEntered: shaderModel.prefetch(index);
                             onDoubleClicked: {
                                 root.selectedShader(parent.shaderId);
                                 root.visible = false;
@@ -14,13 +14,16 @@ Rectangle {
 
     property var shaderId;
     property var shader;
+    // Browsing information from the shader catalog, avoids loading the full shader
+    property var shaderInfo: shader ? shader.info : null
 
     function updateShader() {
-        if (shaderId && !shader) {
+        if (shaderId && !shaderInfo) {
             console.debug("Fetching shader information for " + shaderId);
             shadertoy.api.fetchShader(root.shaderId, function(shader) {
                 console.log("Shader fetched for " + shaderId);
                 root.shader = shader;
+                root.shaderInfo = shader ? shader.info : null;
             });
         }
     }
@@ -33,7 +36,7 @@ Rectangle {
         anchors { left: parent.left; top: parent.top; margins: 4; leftMargin: 8}
         font.pointSize: 12
         font.bold: true
-        text: shader ? shader.info.name : "Unknown"
+        text: shaderInfo ? shaderInfo.name : "Unknown"
     }
 
     Image {
@@ -53,7 +56,7 @@ Rectangle {
 
     ShaderInfo {
         id: shaderInfoBox
-        shaderInfo: root.shader ? root.shader.info : null
+        shaderInfo: root.shaderInfo
         anchors { top: image.top; bottom: image.bottom; left: image.right; leftMargin: 4; right: parent.right; rightMargin: 8 }
     }
 
@@ -10,8 +10,15 @@
 #include <QtCore/QDebug>
 #include <QtCore/QSettings>
 
+#include <SharedUtil.h>
+
+#include "shadertoy/OfflineRenderer.h"
+
 int main(int argc, const char* argv[]) {
     QSettings::setDefaultFormat(QSettings::IniFormat);
+    if (shadertoy::OfflineRenderer::isRequested(argc, argv)) {
+        return shadertoy::OfflineRenderer().exec(argc, argv);
+    }
     int exitCode = Application(argc, const_cast<char**>(argv)).exec();
     qDebug("Normal exit.");
     return exitCode;
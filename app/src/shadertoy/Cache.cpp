@@ -1,5 +1,7 @@
 #include "Cache.h"
 
+#include <algorithm>
+
 #include <QtCore/QRegularExpression>
 #include <QtCore/QStandardPaths>
 #include <QtCore/QJsonDocument>
@@ -11,15 +13,37 @@
 
 #include <shared/JSONHelpers.h>
 #include <FileUtils.h>
+#include <Platform.h>
 
 #include "types/Shader.h"
+#include "Prefetcher.h"
 
 using namespace shadertoy;
 
+const size_t Cache::DEFAULT_MEMORY_BUDGET = 32 * 1024 * 1024;
+
 Cache::Cache(QObject* parent) : QObject(parent), _basePath(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/shadertoys/") {
     if (QFile::exists(_basePath + "/shadertoys.json")) {
         setShaderList(FileUtils::readFileToString(_basePath + "/shadertoys.json"));
     }
+    _catalog.update(_basePath);
+    _prefetcher = new Prefetcher(_catalog, _basePath, thread());
+    _prefetcher->initialize(true, QThread::LowPriority);
+    Platform::addShutdownHook([this] {
+        if (_prefetcher) {
+            _prefetcher->terminate();
+        }
+    });
+}
+
+Cache::~Cache() {
+    if (_prefetcher) {
+        _prefetcher->terminate();
+        // Parsed but never collected, so not parented to the cache
+        qDeleteAll(_prefetcher->takeParsed());
+        delete _prefetcher;
+        _prefetcher = nullptr;
+    }
 }
 
 QStringList Cache::getShaderList() const {
@@ -33,142 +57,228 @@ void Cache::setShaderList(const QString& shaderListJson) {
     for (auto jsonId : jsonIds) {
         _shaderIds << jsonId.toString();
     }
+    _shaderIdSet = QSet<QString>::fromList(_shaderIds);
     qDebug() << "Loaded " << _shaderIds.size() << "Shader IDs";
 }
 
 bool Cache::hasShader(const QString& shaderId) const {
-    return _shaderIds.contains(shaderId);
+    return _shaderIdSet.contains(shaderId);
 }
 
 QVariant Cache::getShader(const QString& shaderId) const {
-    if (!_shaderIds.contains(shaderId)) {
+    if (!_shaderIdSet.contains(shaderId) && !_shadersById.contains(shaderId) && !_catalog.contains(shaderId)) {
         return QVariant();
     }
 
-    if (!_shadersById.contains(shaderId)) {
+    auto shader = const_cast<Cache*>(this)->fetchShader(shaderId);
+    return shader ? QVariant::fromValue(shader) : QVariant();
+}
+
+Shader* Cache::fetchShader(const QString& shaderId) {
+    collectPrefetched();
+
+    auto itr = _shadersById.find(shaderId);
+    if (itr != _shadersById.end()) {
+        auto& entry = itr.value();
+        ++_hits;
+        if (entry.prefetched && !entry.requested) {
+            ++_prefetchUsed;
+        }
+        entry.requested = true;
+        _lru.splice(_lru.begin(), _lru, entry.lru);
+        return entry.shader;
+    }
+
+    ++_misses;
+    Shader* shader = nullptr;
+    auto catalogIndex = _catalog.indexOf(shaderId);
+    if (catalogIndex >= 0) {
+        auto doc = QJsonDocument::fromJson(_catalog.shaderJson(catalogIndex));
+        shader = parseShader(doc.object());
+    } else {
         const QString fileName = _basePath + "/" + shaderId + ".json";
         if (QFile::exists(fileName)) {
-            return const_cast<Cache*>(this)->setShader(shaderId, FileUtils::readFileToString(fileName));
+            auto doc = jsonFromString(FileUtils::readFileToString(fileName));
+            shader = parseShader(doc.object().value("Shader").toObject());
         }
     }
 
-    if (_shadersById.contains(shaderId)) {
-        return QVariant::fromValue(_shadersById[shaderId]);
+    if (shader) {
+        insert(shader, true, false);
+        _shadersById[shader->info->id].requested = true;
     }
-
-    return QVariant();
+    return shader;
 }
 
 QVariant Cache::setShader(const QString& shaderId, const QString& shaderJson) {
-    auto shader = new Shader(this);
     auto doc = jsonFromString(shaderJson);
-    if (!shader->parse(doc.object().value("Shader"))) {
-        delete shader;
+    auto shader = parseShader(doc.object().value("Shader").toObject());
+    if (!shader) {
         return QVariant();
     }
-    _shadersById[shader->info->id] = shader;
+    // Shaders from the network aren't written to disk, so they can't be reloaded once evicted
+    const auto& id = shader->info->id;
+    bool reloadable = _catalog.contains(id) || QFile::exists(_basePath + "/" + id + ".json");
+    insert(shader, reloadable, false);
+    _shadersById[id].requested = true;
     return QVariant::fromValue(shader);
 }
 
-//QStringList Cache::queryShaders(const QString& query, const QVariantMap& parameters) const {
-//    qDebug() << "Queried for " << query << " and parameters " << parameters;
-//    QString sort = parameters["sort"].toString();
-//    if (!_sortedIds.contains(sort)) {
-//        sort = "";
-//    }
-//    QStringList keys = _sortedIds[sort];
-//    qDebug() << "Starting size " << keys.size() << " items";
-//
-//    auto forwardIterator = keys.begin();
-//    //const QString filter = parameters["filter"].toString();
-//    //if (!filter.isEmpty() && filter != "none") {
-//    //    forwardIterator = std::remove_if(forwardIterator, keys.end(), [&](const QString& shaderId){
-//    //        return _shaders[shaderId].matchFilter(filter);
-//    //    });
-//    //}
-//
-//    //if (!query.isEmpty()) {
-//    //    QRegularExpression queryRe("\\b" + query, QRegularExpression::CaseInsensitiveOption);
-//    //    forwardIterator = std::remove_if(forwardIterator, keys.end(), [&](const QString& shaderId){
-//    //        return _shaders[shaderId].matchQuery(queryRe);
-//    //    });
-//    //}
-//
-//    const int max = parameters["num"].toInt();
-//
-//    QStringList resultSet;
-//    while (forwardIterator != keys.end() && resultSet.size() < max) {
-//        QString key = *forwardIterator;
-//        resultSet << key;
-//        ++forwardIterator;
-//    }
-//    qDebug() << "Result size " << resultSet.size() << " items";
-//    return resultSet;
-//}
-//struct Item {
-//    Item(const QString& id = "");
-//    Item(const Item& o);
-//    Item& operator=(const Item& o);
-//    bool load(const QString& basePath);
-
-//    bool matchQuery(const QRegularExpression& re) const;
-//    bool matchFilter(const QString& filter) const;
-
-//    QString id;
-//    QVariant shader;
-//    QVariant info;
-//    QString textSearch;
-//    QSet<QString> tags;
-//};
-
-//Cache::Item::Item(const QString& id) : id(id) {}
-//Cache::Item::Item(const Cache::Item& o) { *this = o; }
-//
-//Cache::Item& Cache::Item::operator=(const Cache::Item& o) {
-//    id = o.id;
-//    info = o.info;
-//    tags = o.tags;
-//    shader = o.shader;
-//    textSearch = o.textSearch;
-//    return *this;
-//}
-//
-//bool Cache::Item::load(const QString& basePath) {
-//    auto json = fromFile(basePath + "/" + id + ".json");
-//    auto shaderValue = json.object().value("Shader");
-//    if (!shaderValue.isObject()) {
-//        return false;
-//    }
-//
-//    auto shaderJson = shaderValue.toObject();
-//    shader = shaderJson.toVariantMap();
-//
-//
-//    auto infoValue = shaderJson.value("info");
-//    if (!infoValue.isObject()) {
-//        return false;
-//    }
-//
-//    auto infoObject = infoValue.toObject();
-//    info = infoObject.toVariantMap();
-//    textSearch += infoObject.value("name").toString().toLower() + "\n";
-//    textSearch += infoObject.value("description").toString() + "\n";
-//    textSearch += infoObject.value("username").toString() + "\n";
-//    auto tagsJson = infoObject.value("tags").toArray();
-//    for (const auto& tagJson : tagsJson) {
-//        tags.insert(tagJson.toString());
-//    }
-//    return true;
-//}
-//
-//bool Cache::Item::matchQuery(const QRegularExpression& re) const {
-//    auto matches = re.globalMatch(textSearch);
-//    return matches.hasNext();
-//}
-//
-//bool Cache::Item::matchFilter(const QString& filter) const {
-//    return tags.contains(filter);
-//}
-//Shader* Cache::parseShader(const QString& shader) {
-//    return processShaderJson(fromString(shader));
-//}
+Shader* Cache::parseShader(const QJsonObject& shaderObject) {
+    auto shader = new Shader(this);
+    if (!shader->parse(shaderObject.toVariantMap())) {
+        delete shader;
+        return nullptr;
+    }
+    return shader;
+}
+
+static size_t estimateSize(const Shader* shader) {
+    // Rough per QObject cost, including the meta object data and list storage
+    static const size_t OBJECT_OVERHEAD = 256;
+    size_t result = OBJECT_OVERHEAD * 2;
+    const auto info = shader->info;
+    result += (info->id.size() + info->name.size() + info->username.size() + info->description.size()) * sizeof(QChar);
+    for (const auto& tag : info->tags) {
+        result += tag.size() * sizeof(QChar);
+    }
+    for (const auto pass : shader->_renderpass) {
+        result += OBJECT_OVERHEAD + pass->code.size() * sizeof(QChar);
+        for (const auto input : pass->_inputs) {
+            result += OBJECT_OVERHEAD + input->src.size() * sizeof(QChar);
+        }
+    }
+    return result;
+}
+
+void Cache::insert(Shader* shader, bool reloadable, bool prefetched) {
+    const QString id = shader->info->id;
+    auto existing = _shadersById.find(id);
+    if (existing != _shadersById.end()) {
+        if (existing.value().shader != shader) {
+            // Replace the old version, which might still be referenced from QML until it's collected
+            existing.value().shader->deleteLater();
+        }
+        _residentBytes -= existing.value().bytes;
+        _lru.erase(existing.value().lru);
+        _shadersById.erase(existing);
+    }
+
+    _lru.push_front(id);
+    Entry entry;
+    entry.shader = shader;
+    entry.bytes = estimateSize(shader);
+    entry.lru = _lru.begin();
+    entry.reloadable = reloadable;
+    entry.prefetched = prefetched;
+    _shadersById[id] = entry;
+    _residentBytes += entry.bytes;
+    evict();
+}
+
+void Cache::evict() {
+    auto itr = _lru.end();
+    while (_residentBytes > _memoryBudget && itr != _lru.begin()) {
+        --itr;
+        // Never evict the most recently used shader, it's the one being returned
+        if (itr == _lru.begin()) {
+            break;
+        }
+        const auto& entry = _shadersById[*itr];
+        if (*itr == _activeShaderId || !entry.reloadable) {
+            continue;
+        }
+        _residentBytes -= entry.bytes;
+        // QML may still hold a reference, let the current event finish with it
+        entry.shader->deleteLater();
+        _shadersById.remove(*itr);
+        itr = _lru.erase(itr);
+        ++_evictions;
+    }
+}
+
+void Cache::collectPrefetched() {
+    for (const auto& id : _prefetcher->takeDropped()) {
+        _prefetchPending.remove(id);
+    }
+    for (auto shader : _prefetcher->takeParsed()) {
+        const auto& id = shader->info->id;
+        _prefetchPending.remove(id);
+        if (_shadersById.contains(id)) {
+            // Parsed synchronously while the prefetch was in flight
+            delete shader;
+            continue;
+        }
+        shader->setParent(this);
+        ++_prefetched;
+        insert(shader, true, true);
+    }
+}
+
+void Cache::prefetch(const QStringList& shaderIds) {
+    collectPrefetched();
+    for (const auto& shaderId : shaderIds) {
+        if (_shadersById.contains(shaderId) || _prefetchPending.contains(shaderId)) {
+            continue;
+        }
+        _prefetchPending.insert(shaderId);
+        _prefetcher->queueItem(shaderId);
+    }
+}
+
+void Cache::setActiveShader(const QString& shaderId) {
+    _activeShaderId = shaderId;
+}
+
+void Cache::setMemoryBudget(int bytes) {
+    _memoryBudget = (size_t)std::max(bytes, 0);
+    evict();
+}
+
+QVariantMap Cache::getStats() const {
+    const_cast<Cache*>(this)->collectPrefetched();
+    QVariantMap result;
+    auto requests = _hits + _misses;
+    result["resident"] = _shadersById.size();
+    result["bytes"] = (qulonglong)_residentBytes;
+    result["budget"] = (qulonglong)_memoryBudget;
+    result["hits"] = (qulonglong)_hits;
+    result["misses"] = (qulonglong)_misses;
+    result["evictions"] = (qulonglong)_evictions;
+    result["hitRatio"] = requests ? (double)_hits / requests : 0.0;
+    result["prefetched"] = (qulonglong)_prefetched;
+    result["prefetchUsed"] = (qulonglong)_prefetchUsed;
+    // The fraction of prefetched shaders which were later requested
+    result["prefetchAccuracy"] = _prefetched ? (double)_prefetchUsed / _prefetched : 0.0;
+    return result;
+}
+
+QVariantMap Cache::getShaderInfo(const QString& shaderId) const {
+    auto catalogIndex = _catalog.indexOf(shaderId);
+    if (catalogIndex >= 0) {
+        return _catalog.info(catalogIndex);
+    }
+
+    // Shaders fetched from the network since the catalog was built
+    auto shader = qvariant_cast<Shader*>(getShader(shaderId));
+    if (!shader) {
+        return QVariantMap();
+    }
+    QVariantMap result;
+    result["id"] = shader->info->id;
+    result["name"] = shader->info->name;
+    result["username"] = shader->info->username;
+    result["description"] = shader->info->description;
+    result["tags"] = shader->info->tags;
+    result["likes"] = shader->info->likes;
+    result["viewed"] = shader->info->viewed;
+    result["date"] = shader->info->date;
+    return result;
+}
+
+QStringList Cache::queryShaders(const QString& query, const QVariantMap& parameters) const {
+    if (!_searchIndex.isBuilt()) {
+        _searchIndex.build(_catalog);
+    }
+    return _searchIndex.query(query, parameters);
+}
@@ -1,30 +1,90 @@
 #pragma once
 
+#include <list>
+
 #include <QtCore/QObject>
 #include <QtCore/QHash>
 #include <QtCore/QStringList>
 #include <QtCore/QVariant>
 #include <QtCore/QSet>
+#include <QtCore/QJsonObject>
 
 #include "types/Shader.h"
+#include "Catalog.h"
+#include "SearchIndex.h"
 
 namespace shadertoy {
 
+    class Prefetcher;
+
     class Cache : public QObject {
         Q_OBJECT
     public:
+        static const size_t DEFAULT_MEMORY_BUDGET;
+
         Cache(QObject* parent = nullptr);
+        ~Cache();
 
         Q_INVOKABLE QStringList getShaderList() const;
         Q_INVOKABLE void setShaderList(const QString& shaderListJson);
         Q_INVOKABLE bool hasShader(const QString& shaderId) const;
         Q_INVOKABLE QVariant getShader(const QString& shaderId) const;
         Q_INVOKABLE QVariant setShader(const QString& shaderId, const QString& shaderJson);
+        // Browsing information for a shader, without parsing the shader itself if it's in the catalog
+        Q_INVOKABLE QVariantMap getShaderInfo(const QString& shaderId) const;
+        // Offline equivalent of the shadertoy.com query API, see SearchIndex
+        Q_INVOKABLE QStringList queryShaders(const QString& query, const QVariantMap& parameters) const;
+
+        // Parse the given shaders in the background, ahead of them being requested
+        Q_INVOKABLE void prefetch(const QStringList& shaderIds);
+        // The active shader is never evicted, since the renderer and editor refer to it
+        Q_INVOKABLE void setActiveShader(const QString& shaderId);
+        // Approximate number of bytes of parsed shaders to keep resident
+        Q_INVOKABLE void setMemoryBudget(int bytes);
+        // Resident count, bytes, hit ratio and prefetch accuracy
+        Q_INVOKABLE QVariantMap getStats() const;
+
+        const Catalog& catalog() const { return _catalog; }
 
     private:
+        using LruList = std::list<QString>;
+        struct Entry {
+            Shader* shader { nullptr };
+            size_t bytes { 0 };
+            LruList::iterator lru;
+            // Whether the shader can be parsed again from the catalog or disk after eviction
+            bool reloadable { true };
+            bool prefetched { false };
+            bool requested { false };
+        };
+
+        Shader* fetchShader(const QString& shaderId);
+        Shader* parseShader(const QJsonObject& shaderObject);
+        void insert(Shader* shader, bool reloadable, bool prefetched);
+        void collectPrefetched();
+        void evict();
+
         const QString _basePath;
-        QHash<QString, Shader*> _shadersById;
+        Catalog _catalog;
+        // Built on the first query
+        mutable SearchIndex _searchIndex;
+        QHash<QString, Entry> _shadersById;
+        // Most recently used at the front
+        LruList _lru;
+        size_t _residentBytes { 0 };
+        size_t _memoryBudget { DEFAULT_MEMORY_BUDGET };
+        QString _activeShaderId;
         QStringList _shaderIds;
+        QSet<QString> _shaderIdSet;
+
+        Prefetcher* _prefetcher { nullptr };
+        QSet<QString> _prefetchPending;
+
+        uint64_t _hits { 0 };
+        uint64_t _misses { 0 };
+        uint64_t _evictions { 0 };
+        uint64_t _prefetched { 0 };
+        uint64_t _prefetchUsed { 0 };
     };
 
-}
\ No newline at end of file
+}
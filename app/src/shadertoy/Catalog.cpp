@@ -0,0 +1,377 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "Catalog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <FileUtils.h>
+
+using namespace shadertoy;
+
+static const char CATALOG_MAGIC[4] = { 'S', 'T', 'C', 'T' };
+// Bumped whenever the record layout changes, forcing a full rebuild
+static const uint32_t CATALOG_VERSION = 1;
+static const QString CATALOG_FILE = "catalog.bin";
+// Files in the cache directory which aren't individual shaders
+static const QString SHADER_LIST_FILE = "shadertoys.json";
+
+Catalog::~Catalog() {
+    unmap();
+}
+
+bool Catalog::map(const QString& fileName) {
+    unmap();
+    _file.setFileName(fileName);
+    if (!_file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    auto fileSize = _file.size();
+    if (fileSize < (qint64)sizeof(Header)) {
+        _file.close();
+        return false;
+    }
+
+    _data = _file.map(0, fileSize);
+    if (!_data) {
+        _file.close();
+        return false;
+    }
+
+    const Header& header = *(const Header*)_data;
+    bool valid = 0 == memcmp(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) && header.version == CATALOG_VERSION;
+    valid = valid && (header.recordsOffset + (qint64)header.count * sizeof(Record)) <= (quint64)fileSize;
+    valid = valid && ((qint64)header.stringsOffset + header.stringsSize) <= fileSize;
+    valid = valid && header.blobOffset <= (quint64)fileSize && header.blobSize <= (quint64)fileSize - header.blobOffset;
+    if (valid) {
+        // Every lookup trusts the records, so check them all once here rather than on each read
+        auto records = (const Record*)(_data + header.recordsOffset);
+        auto strings = (const char*)(_data + header.stringsOffset);
+        auto inStrings = [&](const StringRef& ref) {
+            return ref.offset <= header.stringsSize && ref.size <= header.stringsSize - ref.offset;
+        };
+        for (uint32_t i = 0; valid && i < header.count; ++i) {
+            const auto& r = records[i];
+            valid = inStrings(r.id) && inStrings(r.name) && inStrings(r.username) && inStrings(r.description) && inStrings(r.tags);
+            valid = valid && r.codeOffset <= header.blobSize && r.codeSize <= header.blobSize - r.codeOffset;
+            // indexOf() searches by id
+            if (valid && i > 0) {
+                const auto& previous = records[i - 1].id;
+                valid = !(QByteArray::fromRawData(strings + r.id.offset, r.id.size) <
+                    QByteArray::fromRawData(strings + previous.offset, previous.size));
+            }
+        }
+    }
+    if (!valid) {
+        qWarning() << "Discarding invalid shader catalog" << fileName;
+        unmap();
+        return false;
+    }
+
+    _count = header.count;
+    _records = (const Record*)(_data + header.recordsOffset);
+    _strings = (const char*)(_data + header.stringsOffset);
+    _blob = (const char*)(_data + header.blobOffset);
+    return true;
+}
+
+void Catalog::unmap() {
+    if (_data) {
+        _file.unmap(const_cast<uchar*>(_data));
+    }
+    if (_file.isOpen()) {
+        _file.close();
+    }
+    _data = nullptr;
+    _records = nullptr;
+    _strings = nullptr;
+    _blob = nullptr;
+    _count = 0;
+}
+
+QByteArray Catalog::bytes(const StringRef& ref) const {
+    return QByteArray::fromRawData(_strings + ref.offset, ref.size);
+}
+
+QString Catalog::string(const StringRef& ref) const {
+    return QString::fromUtf8(_strings + ref.offset, ref.size);
+}
+
+int Catalog::indexOf(const QString& shaderId) const {
+    if (!_count) {
+        return -1;
+    }
+    const QByteArray key = shaderId.toUtf8();
+    auto end = _records + _count;
+    auto itr = std::lower_bound(_records, end, key, [&](const Record& record, const QByteArray& key) {
+        return bytes(record.id) < key;
+    });
+    if (itr == end || bytes(itr->id) != key) {
+        return -1;
+    }
+    return (int)(itr - _records);
+}
+
+QString Catalog::id(int index) const {
+    return string(record(index).id);
+}
+
+QString Catalog::name(int index) const {
+    return string(record(index).name);
+}
+
+QString Catalog::username(int index) const {
+    return string(record(index).username);
+}
+
+QString Catalog::description(int index) const {
+    return string(record(index).description);
+}
+
+QStringList Catalog::tags(int index) const {
+    const auto& ref = record(index).tags;
+    if (!ref.size) {
+        return QStringList();
+    }
+    return string(ref).split('\n');
+}
+
+QVariantMap Catalog::info(int index) const {
+    QVariantMap result;
+    const auto& r = record(index);
+    result["id"] = string(r.id);
+    result["name"] = string(r.name);
+    result["username"] = string(r.username);
+    result["description"] = string(r.description);
+    result["tags"] = tags(index);
+    result["likes"] = r.likes;
+    result["viewed"] = r.viewed;
+    result["date"] = QDateTime::fromTime_t(r.date);
+    return result;
+}
+
+QByteArray Catalog::shaderJson(int index) const {
+    const auto& r = record(index);
+    return QByteArray::fromRawData(_blob + r.codeOffset, r.codeSize);
+}
+
+namespace {
+    // A record under construction, along with the data it refers to
+    struct PendingRecord {
+        QByteArray id;
+        QByteArray name;
+        QByteArray username;
+        QByteArray description;
+        QByteArray tags;
+        QByteArray json;
+        Catalog::Record record;
+    };
+
+    bool parseShaderFile(const QFileInfo& fileInfo, PendingRecord& result) {
+        auto doc = QJsonDocument::fromJson(FileUtils::readFileToByteArray(fileInfo.absoluteFilePath()));
+        auto shader = doc.object().value("Shader").toObject();
+        auto info = shader.value("info").toObject();
+        if (info.isEmpty()) {
+            return false;
+        }
+        QStringList tags;
+        for (const auto& tag : info.value("tags").toArray()) {
+            tags << tag.toString();
+        }
+        result.id = info.value("id").toString().toUtf8();
+        if (result.id.isEmpty()) {
+            result.id = fileInfo.completeBaseName().toUtf8();
+        }
+        result.name = info.value("name").toString().toUtf8();
+        result.username = info.value("username").toString().toUtf8();
+        result.description = info.value("description").toString().toUtf8();
+        result.tags = tags.join('\n').toUtf8();
+        result.json = QJsonDocument(shader).toJson(QJsonDocument::Compact);
+        result.record.likes = info.value("likes").toInt();
+        result.record.viewed = info.value("viewed").toInt();
+        result.record.date = info.value("date").toString().toUInt();
+        return true;
+    }
+}
+
+void Catalog::update(const QString& basePath) {
+    QElapsedTimer timer;
+    timer.start();
+
+    const QString catalogFileName = basePath + "/" + CATALOG_FILE;
+    map(catalogFileName);
+
+    QHash<QString, int> existing;
+    for (uint32_t i = 0; i < _count; ++i) {
+        existing[id(i)] = i;
+    }
+
+    auto files = QDir(basePath).entryInfoList(QStringList("*.json"), QDir::Files);
+    std::vector<PendingRecord> records;
+    records.reserve(files.size());
+    size_t reused = 0, parsed = 0;
+    for (const auto& fileInfo : files) {
+        if (fileInfo.fileName() == SHADER_LIST_FILE) {
+            continue;
+        }
+
+        PendingRecord pending;
+        memset(&pending.record, 0, sizeof(Record));
+        auto modified = fileInfo.lastModified().toMSecsSinceEpoch();
+        auto existingItr = existing.find(fileInfo.completeBaseName());
+        if (existingItr != existing.end()) {
+            const auto& r = record(existingItr.value());
+            if (r.sourceModified == modified && r.sourceSize == fileInfo.size()) {
+                // Deep copy, since the mapping goes away before the new file is written
+                auto copy = [&](const StringRef& ref) {
+                    return QByteArray(_strings + ref.offset, ref.size);
+                };
+                pending.id = copy(r.id);
+                pending.name = copy(r.name);
+                pending.username = copy(r.username);
+                pending.description = copy(r.description);
+                pending.tags = copy(r.tags);
+                pending.json = QByteArray(_blob + r.codeOffset, r.codeSize);
+                pending.record = r;
+                records.push_back(pending);
+                ++reused;
+                continue;
+            }
+        }
+
+        if (!parseShaderFile(fileInfo, pending)) {
+            continue;
+        }
+        pending.record.sourceModified = modified;
+        pending.record.sourceSize = fileInfo.size();
+        records.push_back(pending);
+        ++parsed;
+    }
+
+    // Nothing added, changed or removed
+    if (!parsed && reused == _count) {
+        qDebug() << "Shader catalog up to date with" << _count << "shaders in" << timer.elapsed() << "ms";
+        return;
+    }
+
+    std::sort(records.begin(), records.end(), [](const PendingRecord& a, const PendingRecord& b) {
+        return a.id < b.id;
+    });
+    // Guard against duplicate ids from differently named files
+    records.erase(std::unique(records.begin(), records.end(), [](const PendingRecord& a, const PendingRecord& b) {
+        return a.id == b.id;
+    }), records.end());
+
+    QByteArray strings;
+    QByteArray blob;
+    std::vector<Record> packed;
+    packed.reserve(records.size());
+    auto addString = [&](const QByteArray& value) {
+        StringRef ref;
+        ref.offset = strings.size();
+        ref.size = value.size();
+        strings.append(value);
+        return ref;
+    };
+    for (const auto& pending : records) {
+        Record r = pending.record;
+        r.id = addString(pending.id);
+        r.name = addString(pending.name);
+        r.username = addString(pending.username);
+        r.description = addString(pending.description);
+        r.tags = addString(pending.tags);
+        r.codeOffset = blob.size();
+        r.codeSize = pending.json.size();
+        blob.append(pending.json);
+        packed.push_back(r);
+    }
+
+    Header header;
+    memcpy(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+    header.version = CATALOG_VERSION;
+    header.count = (uint32_t)packed.size();
+    header.recordsOffset = sizeof(Header);
+    header.stringsOffset = header.recordsOffset + (uint32_t)(packed.size() * sizeof(Record));
+    header.stringsSize = strings.size();
+    header.blobOffset = header.stringsOffset + header.stringsSize;
+    header.blobSize = blob.size();
+
+    // Written in full while the existing catalog stays mapped, so a failure leaves it usable
+    const QString tempFileName = catalogFileName + ".tmp";
+    {
+        QFile out(tempFileName);
+        bool written = out.open(QFile::WriteOnly | QFile::Truncate);
+        auto write = [&](const char* data, qint64 size) {
+            written = written && out.write(data, size) == size;
+        };
+        write((const char*)&header, sizeof(Header));
+        write((const char*)packed.data(), (qint64)(packed.size() * sizeof(Record)));
+        write(strings.constData(), strings.size());
+        write(blob.constData(), blob.size());
+        written = written && out.flush();
+        if (!written) {
+            qWarning() << "Unable to write shader catalog" << tempFileName;
+            out.close();
+            QFile::remove(tempFileName);
+            return;
+        }
+    }
+
+    // The existing file can't be replaced while it's mapped.  It's moved aside rather
+    // than removed, so it can be restored if the new one can't be moved into place.
+    unmap();
+    const QString oldFileName = catalogFileName + ".old";
+    QFile::remove(oldFileName);
+    bool hadCatalog = QFile::exists(catalogFileName);
+    if (hadCatalog && !QFile::rename(catalogFileName, oldFileName)) {
+        qWarning() << "Unable to replace shader catalog" << catalogFileName;
+        QFile::remove(tempFileName);
+        map(catalogFileName);
+        return;
+    }
+    if (!QFile::rename(tempFileName, catalogFileName)) {
+        qWarning() << "Unable to replace shader catalog" << catalogFileName;
+        QFile::remove(tempFileName);
+        if (hadCatalog) {
+            QFile::rename(oldFileName, catalogFileName);
+        }
+        map(catalogFileName);
+        return;
+    }
+    QFile::remove(oldFileName);
+
+    if (!map(catalogFileName)) {
+        qWarning() << "Unable to map the rebuilt shader catalog" << catalogFileName;
+        return;
+    }
+    qDebug() << "Shader catalog rebuilt with" << _count << "shaders," << parsed << "parsed," << reused << "reused in" << timer.elapsed() << "ms";
+}
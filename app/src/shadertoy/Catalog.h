@@ -0,0 +1,117 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVariantMap>
+
+namespace shadertoy {
+
+    // A packed, memory mapped index of the shaders in the local cache directory.
+    //
+    // Holds the information needed to browse the shader list (id, name, author,
+    // tags, likes, views and date) along with the compact JSON of each shader in
+    // a single blob, so that the list can be displayed without opening or parsing
+    // the individual shader files.  The catalog is rebuilt incrementally at
+    // startup, only re-reading the JSON files which have changed since the last
+    // build.
+    class Catalog {
+    public:
+        struct StringRef {
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        struct Record {
+            StringRef id;
+            StringRef name;
+            StringRef username;
+            StringRef description;
+            // Newline separated
+            StringRef tags;
+            int32_t likes;
+            int32_t viewed;
+            uint32_t date;
+            uint32_t codeSize;
+            uint64_t codeOffset;
+            // Modification time and size of the source file, used to detect changes
+            int64_t sourceModified;
+            int64_t sourceSize;
+        };
+
+        ~Catalog();
+
+        // Map the existing catalog in the given directory and bring it up to date
+        // with the shader JSON files there
+        void update(const QString& basePath);
+
+        int size() const { return (int)_count; }
+        // Records are sorted by shader id, returns -1 if not found
+        int indexOf(const QString& shaderId) const;
+        bool contains(const QString& shaderId) const { return indexOf(shaderId) >= 0; }
+
+        QString id(int index) const;
+        QString name(int index) const;
+        QString username(int index) const;
+        QString description(int index) const;
+        QStringList tags(int index) const;
+        int likes(int index) const { return record(index).likes; }
+        int viewed(int index) const { return record(index).viewed; }
+        uint32_t date(int index) const { return record(index).date; }
+
+        // Same keys as the ShaderInfo properties, for use in QML
+        QVariantMap info(int index) const;
+
+        // The compact JSON of the 'Shader' object.  Refers directly to the mapped
+        // file, so must not outlive the catalog.
+        QByteArray shaderJson(int index) const;
+
+    private:
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint32_t count;
+            uint32_t recordsOffset;
+            uint32_t stringsOffset;
+            uint32_t stringsSize;
+            uint64_t blobOffset;
+            uint64_t blobSize;
+        };
+
+        bool map(const QString& fileName);
+        void unmap();
+        const Record& record(int index) const { return _records[index]; }
+        QByteArray bytes(const StringRef& ref) const;
+        QString string(const StringRef& ref) const;
+
+        QFile _file;
+        const uchar* _data { nullptr };
+        const Record* _records { nullptr };
+        const char* _strings { nullptr };
+        const char* _blob { nullptr };
+        uint32_t _count { 0 };
+    };
+
+}
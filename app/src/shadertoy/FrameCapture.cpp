@@ -0,0 +1,113 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "FrameCapture.h"
+
+#include <algorithm>
+
+#include <QtCore/QDebug>
+
+using namespace shadertoy;
+
+// Generous, since software rasterizers can take a long time over a frame
+static const GLuint64 FENCE_TIMEOUT_NSECS = 10ULL * 1000 * 1000 * 1000;
+
+FrameCapture::FrameCapture(const Handler& handler, int depth) : _handler(handler), _slots(std::max(depth, 1)) {
+}
+
+FrameCapture::~FrameCapture() {
+    Q_ASSERT(!_slots.front().buffer);
+}
+
+void FrameCapture::resize(const uvec2& size) {
+    if (size == _size) {
+        return;
+    }
+    flush();
+    _size = size;
+    const GLsizeiptr bufferSize = (GLsizeiptr)size.x * size.y * 4;
+    for (auto& slot : _slots) {
+        if (!slot.buffer) {
+            glGenBuffers(1, &slot.buffer);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameCapture::capture(GLuint framebuffer, int frame) {
+    auto& slot = _slots[_next];
+    _next = (_next + 1) % _slots.size();
+    // The slot being reused always holds the oldest outstanding frame
+    retire(slot);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, _size.x, _size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frame = frame;
+}
+
+void FrameCapture::flush() {
+    for (size_t i = 0; i < _slots.size(); ++i) {
+        retire(_slots[(_next + i) % _slots.size()]);
+    }
+}
+
+void FrameCapture::destroy() {
+    flush();
+    for (auto& slot : _slots) {
+        if (slot.buffer) {
+            glDeleteBuffers(1, &slot.buffer);
+            slot.buffer = 0;
+        }
+    }
+    _size = uvec2();
+}
+
+void FrameCapture::retire(Slot& slot) {
+    if (slot.frame < 0) {
+        return;
+    }
+
+    if (GL_WAIT_FAILED == glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NSECS)) {
+        qWarning() << "Failed waiting for readback of frame" << slot.frame;
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    const GLsizeiptr bufferSize = (GLsizeiptr)_size.x * _size.y * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    auto pixels = (const uchar*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bufferSize, GL_MAP_READ_BIT);
+    if (pixels) {
+        // GL rows run bottom to top, and mirrored() makes the deep copy we need before unmapping
+        QImage image = QImage(pixels, _size.x, _size.y, QImage::Format_RGBA8888).mirrored(false, true);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        _handler(slot.frame, image);
+    } else {
+        qWarning() << "Failed to map readback buffer for frame" << slot.frame;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.frame = -1;
+}
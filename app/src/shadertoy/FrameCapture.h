@@ -0,0 +1,70 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <QtGui/QImage>
+
+#include <gl/Config.h>
+#include <GLMHelpers.h>
+
+namespace shadertoy {
+
+    // Reads rendered frames back through a ring of pixel buffer objects.
+    //
+    // glReadPixels into a bound pack buffer returns immediately, so each frame's
+    // pixels are only mapped once the slot comes around again, by which time the
+    // GPU has long since finished with it and rendering never stalls waiting on
+    // the copy.  Frames are handed to the handler in the order they were captured.
+    // All calls must be made with the rendering context current.
+    class FrameCapture {
+    public:
+        using Handler = std::function<void(int frame, const QImage& image)>;
+        static const int DEFAULT_DEPTH = 3;
+
+        FrameCapture(const Handler& handler, int depth = DEFAULT_DEPTH);
+        ~FrameCapture();
+
+        void resize(const uvec2& size);
+        // Queue a copy of the color attachment of the given framebuffer
+        void capture(GLuint framebuffer, int frame);
+        // Deliver all outstanding frames
+        void flush();
+        // Release the GL objects, must be called before the context goes away
+        void destroy();
+
+    private:
+        struct Slot {
+            GLuint buffer { 0 };
+            GLsync fence { nullptr };
+            int frame { -1 };
+        };
+
+        void retire(Slot& slot);
+
+        const Handler _handler;
+        std::vector<Slot> _slots;
+        size_t _next { 0 };
+        uvec2 _size;
+    };
+
+}
@@ -18,6 +18,9 @@ limitations under the License.
 ************************************************************************************/
 
 #include "Model.h"
+
+#include <algorithm>
+
 #include <QDebug>
 #include <QNetworkAccessManager>
 
@@ -38,23 +41,51 @@ void Model::setShaderIds(const QStringList& ids) {
     endResetModel();
 }
 
+// Rows after and before the previewed one to parse as well, the likely next choices
+static const int PREFETCH_AHEAD = 2;
+static const int PREFETCH_BEHIND = 1;
+
+void Model::prefetch(int row) const {
+    if (row < 0 || row >= _currentIds.size()) {
+        return;
+    }
+    auto first = std::max(0, row - PREFETCH_BEHIND);
+    auto last = std::min(_currentIds.size() - 1, row + PREFETCH_AHEAD);
+    QStringList ids;
+    // The previewed row first, as it's the most likely to be selected
+    ids << _currentIds[row];
+    for (int i = first; i <= last; ++i) {
+        if (i != row) {
+            ids << _currentIds[i];
+        }
+    }
+    _cache->prefetch(ids);
+}
+
 int Model::rowCount(const QModelIndex & parent) const {
     return _currentIds.size();
 }
 
 QVariant Model::data(const QModelIndex & index, int role) const {
     const auto& id = _currentIds[index.row()];
-    auto shaderVar = _cache->getShader(id);
-    Shader* shader = qvariant_cast<Shader*>(shaderVar);
     switch (role) {
     case IdRole:
         return id;
-    case ShaderRole:
-        return shaderVar;
+    case ShaderRole: {
+        // Requires a full parse of the shader, browsing should use InfoRole
+        auto shader = _cache->getShader(id);
+        // Now the row is resident only its neighbours are queued
+        prefetch(index.row());
+        return shader;
+    }
+    case InfoRole: {
+        auto info = _cache->getShaderInfo(id);
+        return info.isEmpty() ? QVariant() : QVariant(info);
+    }
     default:
     case NameRole:
     case SearchRole:
-        return shader->info->name;
+        return _cache->getShaderInfo(id).value("name");
     }
 }
 
@@ -64,5 +95,6 @@ QHash<int, QByteArray> Model::roleNames() const {
     roles[ShaderRole] = "modelShader";
     roles[SearchRole] = "modelSearch";
     roles[NameRole] = "modelName";
+    roles[InfoRole] = "modelInfo";
     return roles;
 }
@@ -32,11 +32,15 @@ namespace shadertoy  {
             ShaderRole,
             SearchRole,
             NameRole,
+            InfoRole,
         };
 
         Model();
         void setShaderIds(const QStringList& ids);
         QStringList shaderIds();
+        // Parse the shader in the given row and its neighbours in the background, for
+        // when it's previewed.  Browsing the list only reads the catalog, so doesn't.
+        Q_INVOKABLE void prefetch(int row) const;
 
     protected:
         int rowCount(const QModelIndex & parent = QModelIndex()) const override;
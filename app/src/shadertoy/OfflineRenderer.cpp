@@ -0,0 +1,428 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OfflineRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTextStream>
+#include <QtGui/QGuiApplication>
+
+#include <gl/Config.h>
+#include <gl/OffscreenGLCanvas.h>
+#include <gl/OglplusHelpers.h>
+#include <FileUtils.h>
+#include <MatrixStack.h>
+#include <NumericalConstants.h>
+#include <Platform.h>
+#include <SharedUtil.h>
+
+#include "Cache.h"
+#include "FrameCapture.h"
+#include "Renderer.h"
+#include "types/Shader.h"
+
+using namespace shadertoy;
+
+const char* const OfflineRenderer::RENDER_OPTION = "--render";
+const char* const OfflineRenderer::BENCHMARK_OPTION = "--benchmark";
+
+static const uvec2 DEFAULT_SIZE { 1280, 720 };
+static const int DEFAULT_FRAMES = 60;
+static const float DEFAULT_TIMESTEP = 1.0f / 60.0f;
+static const QString DEFAULT_OUTPUT = "frames";
+static const int DEFAULT_BENCHMARK_FRAMES = 120;
+static const int DEFAULT_WARMUP_FRAMES = 10;
+static const QString DEFAULT_SCALES = "0.25,0.5,1.0";
+static const QString DEFAULT_REPORT = "benchmark.json";
+static const char* const PASS_NAMES[PassTimer::MAX_PASSES] = { "image", "buffer_a", "buffer_b", "buffer_c", "buffer_d" };
+
+// Q_INIT_RESOURCE can't be used from within a namespace
+static void initResources() {
+    Q_INIT_RESOURCE(ShadertoyVR);
+}
+
+static uvec2 parseSize(const char* value) {
+    if (!value) {
+        return DEFAULT_SIZE;
+    }
+    auto parts = QString(value).split('x');
+    if (parts.size() != 2 || !parts[0].toUInt() || !parts[1].toUInt()) {
+        qWarning() << "Invalid size" << value << ", expected <width>x<height>";
+        return DEFAULT_SIZE;
+    }
+    return uvec2(parts[0].toUInt(), parts[1].toUInt());
+}
+
+static int intOption(int argc, const char* argv[], const char* option, int defaultValue) {
+    const char* value = getCmdOption(argc, argv, option);
+    return value ? QString(value).toInt() : defaultValue;
+}
+
+static QString stringOption(int argc, const char* argv[], const char* option, const QString& defaultValue) {
+    const char* value = getCmdOption(argc, argv, option);
+    return value ? QString(value) : defaultValue;
+}
+
+// Accepts either a full API response, or just the "Shader" object
+static Shader* loadShaderFile(const QString& fileName) {
+    auto object = QJsonDocument::fromJson(FileUtils::readFileToByteArray(fileName)).object();
+    if (object.contains("Shader")) {
+        object = object.value("Shader").toObject();
+    }
+    auto shader = new Shader();
+    if (!shader->parse(object.toVariantMap())) {
+        delete shader;
+        return nullptr;
+    }
+    return shader;
+}
+
+// Nearest rank percentiles of the samples, in milliseconds
+static QJsonObject summarize(std::vector<double> samples) {
+    QJsonObject result;
+    if (samples.empty()) {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        size_t rank = (size_t)std::ceil(p * samples.size());
+        return samples[std::min(std::max(rank, (size_t)1), samples.size()) - 1];
+    };
+    double total = 0.0;
+    for (auto sample : samples) {
+        total += sample;
+    }
+    result["mean"] = total / samples.size();
+    result["p50"] = percentile(0.50);
+    result["p90"] = percentile(0.90);
+    result["p99"] = percentile(0.99);
+    result["max"] = samples.back();
+    return result;
+}
+
+bool OfflineRenderer::isRequested(int argc, const char* argv[]) {
+    return cmdOptionExists(argc, argv, RENDER_OPTION) || cmdOptionExists(argc, argv, BENCHMARK_OPTION);
+}
+
+OfflineRenderer::OfflineRenderer() {
+}
+
+OfflineRenderer::~OfflineRenderer() {
+}
+
+int OfflineRenderer::exec(int argc, const char* argv[]) {
+    _argc = argc;
+    if (!initialize(argv)) {
+        return -1;
+    }
+    int result = cmdOptionExists(argc, argv, BENCHMARK_OPTION) ? benchmark(argc, argv) : renderFrames(argc, argv);
+    shutdown();
+    return result;
+}
+
+// Picks a Qt platform which can create GL contexts without a window, unless one was given
+static void selectHeadlessPlatform() {
+    if (!qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        return;
+    }
+#ifdef Q_OS_LINUX
+    // The offscreen platform creates its contexts through GLX, so it still needs an X
+    // server.  Without one, use EGL with no native display, which Mesa supports for
+    // both hardware render nodes and llvmpipe.  Offscreen surfaces on eglfs are
+    // pbuffers, or surfaceless where EGL_KHR_surfaceless_context is available.
+    if (qgetenv("DISPLAY").isEmpty() && qgetenv("WAYLAND_DISPLAY").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "eglfs");
+        if (qgetenv("QT_QPA_EGLFS_INTEGRATION").isEmpty()) {
+            qputenv("QT_QPA_EGLFS_INTEGRATION", "none");
+        }
+        if (qgetenv("EGL_PLATFORM").isEmpty()) {
+            qputenv("EGL_PLATFORM", "surfaceless");
+        }
+        return;
+    }
+#endif
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+}
+
+bool OfflineRenderer::initialize(const char* argv[]) {
+    selectHeadlessPlatform();
+    _app.reset(new QGuiApplication(_argc, const_cast<char**>(argv)));
+    initResources();
+    QCoreApplication::setApplicationName("ShadertoyVR");
+    QCoreApplication::setOrganizationName("Saint Andreas");
+    QCoreApplication::setOrganizationDomain("saintandreas.org");
+
+    _canvas.reset(new OffscreenGLCanvas());
+    if (!_canvas->create() || !_canvas->makeCurrent()) {
+        qWarning() << "Unable to create an OpenGL context for offline rendering";
+        return false;
+    }
+    glewExperimental = true;
+    // Under EGL the GLX part of GLEW's initialization fails, after the GL entry points are loaded
+    glewInit();
+    glGetError();
+    return true;
+}
+
+void OfflineRenderer::shutdown() {
+    if (_canvas) {
+        _canvas->makeCurrent();
+        Platform::runShutdownHooks();
+        _canvas->doneCurrent();
+    }
+}
+
+Shader* OfflineRenderer::loadShader(const QString& source) {
+    if (QFileInfo(source).isFile()) {
+        auto shader = loadShaderFile(source);
+        if (shader) {
+            _fileShaders.emplace_back(shader);
+        }
+        return shader;
+    }
+    if (!_cache) {
+        _cache.reset(new Cache());
+    }
+    return qvariant_cast<Shader*>(_cache->getShader(source));
+}
+
+void OfflineRenderer::createRenderer(const uvec2& size) {
+    _renderer.reset(new Renderer());
+    QObject::connect(_renderer.get(), &Renderer::compileError, [](const QString& error) {
+        qWarning().noquote() << error;
+    });
+    _renderer->setFixedTimestep(DEFAULT_TIMESTEP);
+    _renderer->setupHeadless(size, _canvas.get());
+}
+
+bool OfflineRenderer::buildShader(Shader* shader) {
+    _renderer->setShader(shader);
+    _renderer->build();
+    return _renderer->waitForBuild();
+}
+
+int OfflineRenderer::renderFrames(int argc, const char* argv[]) {
+    const QString source = getCmdOption(argc, argv, RENDER_OPTION);
+    const uvec2 size = parseSize(getCmdOption(argc, argv, "--size"));
+    const int frames = intOption(argc, argv, "--frames", DEFAULT_FRAMES);
+    const float timestep = stringOption(argc, argv, "--timestep", QString::number(DEFAULT_TIMESTEP)).toFloat();
+    const QString output = stringOption(argc, argv, "--output", DEFAULT_OUTPUT);
+    if (source.isEmpty() || frames <= 0 || timestep <= 0.0f) {
+        qWarning() << "Usage:" << argv[0] << RENDER_OPTION << "<shader id | file.json> [--size WxH] [--frames N] [--timestep S] [--output DIR]";
+        return -1;
+    }
+    if (!QDir().mkpath(output)) {
+        qWarning() << "Unable to create output directory" << output;
+        return -1;
+    }
+
+    auto shader = loadShader(source);
+    if (!shader) {
+        qWarning() << "Unable to load shader" << source;
+        return -1;
+    }
+
+    createRenderer(size);
+    _renderer->setScale(1.0f);
+    _renderer->setFixedTimestep(timestep);
+    if (!buildShader(shader)) {
+        qWarning() << "Unable to build shader" << source;
+        return -1;
+    }
+
+    int written = 0;
+    FrameCapture capture([&](int frame, const QImage& image) {
+        auto fileName = QString("%1/%2.png").arg(output).arg(frame, 5, 10, QChar('0'));
+        if (!image.save(fileName)) {
+            qWarning() << "Unable to write" << fileName;
+            return;
+        }
+        ++written;
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    Stacks::modelview().top() = mat4();
+    for (int frame = 0; frame < frames; ++frame) {
+        _renderer->render();
+        capture.resize(_renderer->renderResolution());
+        capture.capture(oglplus::GetName(*_renderer->imageFramebuffer()), frame);
+    }
+    capture.destroy();
+    qDebug() << "Rendered" << frames << "frames at" << size.x << "x" << size.y << "in" << timer.elapsed() << "ms";
+    return written == frames ? 0 : -1;
+}
+
+int OfflineRenderer::benchmark(int argc, const char* argv[]) {
+    const QString shaderList = getCmdOption(argc, argv, BENCHMARK_OPTION);
+    const uvec2 size = parseSize(getCmdOption(argc, argv, "--size"));
+    const int frames = intOption(argc, argv, "--frames", DEFAULT_BENCHMARK_FRAMES);
+    const int warmup = std::max(intOption(argc, argv, "--warmup", DEFAULT_WARMUP_FRAMES), 0);
+    const QString report = stringOption(argc, argv, "--report", DEFAULT_REPORT);
+    std::vector<float> scales;
+    for (const auto& scale : stringOption(argc, argv, "--scales", DEFAULT_SCALES).split(',', QString::SkipEmptyParts)) {
+        if (scale.toFloat() > 0.0f) {
+            scales.push_back(scale.toFloat());
+        }
+    }
+
+    QStringList sources;
+    if (QFileInfo(shaderList).isFile() && !shaderList.endsWith(".json")) {
+        for (auto line : FileUtils::readFileToString(shaderList).split('\n')) {
+            line = line.trimmed();
+            if (!line.isEmpty() && !line.startsWith('#')) {
+                sources << line;
+            }
+        }
+    } else {
+        sources = shaderList.split(',', QString::SkipEmptyParts);
+    }
+    if (sources.isEmpty() || frames <= 0 || scales.empty()) {
+        qWarning() << "Usage:" << argv[0] << BENCHMARK_OPTION << "<id,id,... | list file> [--size WxH] [--frames N] [--warmup N] [--scales S,S,...] [--report FILE]";
+        return -1;
+    }
+
+    createRenderer(size);
+    _renderer->setPassTiming(true);
+    auto& passTimer = _renderer->passTimer();
+    Stacks::modelview().top() = mat4();
+
+    QJsonArray results;
+    int failures = 0;
+    for (const auto& source : sources) {
+        auto shader = loadShader(source);
+        if (!shader || !buildShader(shader)) {
+            qWarning() << "Unable to load or build shader" << source;
+            QJsonObject failure;
+            failure["shader"] = source;
+            failure["error"] = shader ? "build" : "load";
+            results.append(failure);
+            ++failures;
+            continue;
+        }
+
+        for (auto scale : scales) {
+            _renderer->setScale(scale);
+            for (int i = 0; i < warmup; ++i) {
+                _renderer->render();
+            }
+            passTimer.finish();
+            PassTimer::Frame frameTimes;
+            while (passTimer.takeResult(frameTimes)) {
+            }
+
+            std::vector<double> cpuTimes;
+            cpuTimes.reserve(frames);
+            QElapsedTimer cpuTimer;
+            for (int i = 0; i < frames; ++i) {
+                cpuTimer.start();
+                _renderer->render();
+                cpuTimes.push_back((double)cpuTimer.nsecsElapsed() / NSECS_PER_USEC / USECS_PER_MSEC);
+            }
+            passTimer.finish();
+
+            std::vector<double> gpuTimes;
+            std::vector<double> passTimes[PassTimer::MAX_PASSES];
+            while (passTimer.takeResult(frameTimes)) {
+                gpuTimes.push_back((double)frameTimes.totalNSecs / NSECS_PER_USEC / USECS_PER_MSEC);
+                for (int pass = 0; pass < PassTimer::MAX_PASSES; ++pass) {
+                    if (frameTimes.passMask & (1 << pass)) {
+                        passTimes[pass].push_back((double)frameTimes.passNSecs[pass] / NSECS_PER_USEC / USECS_PER_MSEC);
+                    }
+                }
+            }
+
+            QJsonObject result;
+            result["shader"] = source;
+            result["name"] = shader->info ? shader->info->name : QString();
+            result["scale"] = scale;
+            auto resolution = _renderer->renderResolution();
+            result["width"] = (int)resolution.x;
+            result["height"] = (int)resolution.y;
+            result["frames"] = frames;
+            result["cpu"] = summarize(cpuTimes);
+            result["gpu"] = summarize(gpuTimes);
+            QJsonObject passes;
+            for (int pass = 0; pass < PassTimer::MAX_PASSES; ++pass) {
+                if (!passTimes[pass].empty()) {
+                    passes[PASS_NAMES[pass]] = summarize(passTimes[pass]);
+                }
+            }
+            result["passes"] = passes;
+            results.append(result);
+            qDebug() << source << "at scale" << scale << "gpu p50" << result["gpu"].toObject()["p50"].toDouble()
+                << "ms, cpu p50" << result["cpu"].toObject()["p50"].toDouble() << "ms";
+        }
+    }
+
+    QFile reportFile(report);
+    if (!reportFile.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+        qWarning() << "Unable to write benchmark report" << report;
+        return -1;
+    }
+    QTextStream out(&reportFile);
+    if (report.endsWith(".csv", Qt::CaseInsensitive)) {
+        static const char* const STATS[] = { "mean", "p50", "p90", "p99", "max" };
+        out << "shader,scale,width,height,metric";
+        for (auto stat : STATS) {
+            out << "," << stat;
+        }
+        out << "\n";
+        for (const auto& value : results) {
+            auto result = value.toObject();
+            if (result.contains("error")) {
+                out << result["shader"].toString() << ",,,,error:" << result["error"].toString() << "\n";
+                continue;
+            }
+            auto writeRow = [&](const QString& metric, const QJsonObject& summary) {
+                out << result["shader"].toString() << "," << result["scale"].toDouble() << ","
+                    << result["width"].toInt() << "," << result["height"].toInt() << "," << metric;
+                for (auto stat : STATS) {
+                    out << "," << summary[stat].toDouble();
+                }
+                out << "\n";
+            };
+            writeRow("cpu", result["cpu"].toObject());
+            writeRow("gpu", result["gpu"].toObject());
+            auto passes = result["passes"].toObject();
+            for (auto itr = passes.begin(); itr != passes.end(); ++itr) {
+                writeRow("gpu_" + itr.key(), itr.value().toObject());
+            }
+        }
+    } else {
+        QJsonObject document;
+        document["vendor"] = QString((const char*)glGetString(GL_VENDOR));
+        document["renderer"] = QString((const char*)glGetString(GL_RENDERER));
+        document["version"] = QString((const char*)glGetString(GL_VERSION));
+        document["results"] = results;
+        out << QJsonDocument(document).toJson(QJsonDocument::Indented);
+    }
+    qDebug() << "Wrote benchmark report" << report;
+    return failures ? -1 : 0;
+}
@@ -0,0 +1,94 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <QtCore/QString>
+
+#include <glm/glm.hpp>
+
+class QGuiApplication;
+class OffscreenGLCanvas;
+class Shader;
+
+namespace shadertoy {
+
+    class Cache;
+    class Renderer;
+
+    // Runs the renderer without a window, display plugin or UI, for render
+    // nodes which only have a software GL implementation (e.g. Mesa llvmpipe
+    // with LIBGL_ALWAYS_SOFTWARE=1).  Shaders are given as cached shader ids or
+    // as shadertoy.com API JSON files.  Output is deterministic: the shader clock
+    // is driven by the frame number and the mouse, keyboard and date inputs are
+    // left at zero.
+    //
+    // With no X or Wayland display on Linux, contexts are created through EGL
+    // on the eglfs platform, with no native display.  Set QT_QPA_PLATFORM to
+    // choose another platform.
+    //
+    // Render a shader to a numbered PNG sequence:
+    //   --render <shader>          required
+    //   --size <width>x<height>    default 1280x720
+    //   --frames <count>           default 60
+    //   --timestep <seconds>       default 1/60, iGlobalTime is frame * timestep
+    //   --output <directory>       default "frames"
+    //
+    // Measure the cost of a list of shaders at several render scales, reporting
+    // CPU submit time and per-pass GPU time percentiles:
+    //   --benchmark <shaders>      required, comma separated or a file with one per line
+    //   --size <width>x<height>    default 1280x720
+    //   --frames <count>           default 120 measured frames per scale
+    //   --warmup <count>           default 10 frames per scale
+    //   --scales <s1,s2,...>       default 0.25,0.5,1.0
+    //   --report <file>            default "benchmark.json", CSV if the name ends in .csv
+    class OfflineRenderer {
+    public:
+        static const char* const RENDER_OPTION;
+        static const char* const BENCHMARK_OPTION;
+
+        static bool isRequested(int argc, const char* argv[]);
+
+        OfflineRenderer();
+        ~OfflineRenderer();
+
+        int exec(int argc, const char* argv[]);
+
+    private:
+        bool initialize(const char* argv[]);
+        void shutdown();
+        Shader* loadShader(const QString& source);
+        void createRenderer(const glm::uvec2& size);
+        bool buildShader(Shader* shader);
+        int renderFrames(int argc, const char* argv[]);
+        int benchmark(int argc, const char* argv[]);
+
+        int _argc { 0 };
+        std::unique_ptr<QGuiApplication> _app;
+        std::unique_ptr<OffscreenGLCanvas> _canvas;
+        // Created on demand, since it scans the shader directory
+        std::unique_ptr<Cache> _cache;
+        std::vector<std::unique_ptr<Shader>> _fileShaders;
+        std::unique_ptr<Renderer> _renderer;
+    };
+
+}
@@ -0,0 +1,147 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "PassTimer.h"
+
+#include <algorithm>
+
+#include <QtCore/QtGlobal>
+
+using namespace shadertoy;
+
+PassTimer::~PassTimer() {
+    Q_ASSERT(!_initialized);
+}
+
+void PassTimer::beginFrame(int32_t frame) {
+    if (!_initialized) {
+        for (auto& slot : _slots) {
+            glGenQueries(MAX_SPANS * 2, slot.queries);
+        }
+        _initialized = true;
+    }
+
+    // The slot about to be reused holds the oldest frame, which has to be read
+    // back now.  Collect any newer frames which are already done, in order.
+    for (int i = 0; i < FRAME_DEPTH; ++i) {
+        auto& slot = _slots[(_current + i) % FRAME_DEPTH];
+        if (slot.pending && !collect(slot, i == 0)) {
+            break;
+        }
+    }
+
+    auto& slot = _slots[_current];
+    slot.frame = frame;
+    slot.spans = 0;
+    _recording = true;
+}
+
+void PassTimer::beginPass(Renderpass::Output pass) {
+    auto& slot = _slots[_current];
+    if (!_recording || slot.spans >= MAX_SPANS) {
+        return;
+    }
+    slot.passes[slot.spans] = pass;
+    glQueryCounter(slot.queries[slot.spans * 2], GL_TIMESTAMP);
+}
+
+void PassTimer::endPass() {
+    auto& slot = _slots[_current];
+    if (!_recording || slot.spans >= MAX_SPANS) {
+        return;
+    }
+    glQueryCounter(slot.queries[slot.spans * 2 + 1], GL_TIMESTAMP);
+    ++slot.spans;
+}
+
+void PassTimer::endFrame() {
+    if (!_recording) {
+        return;
+    }
+    _recording = false;
+    auto& slot = _slots[_current];
+    if (!slot.spans) {
+        return;
+    }
+    slot.pending = true;
+    _current = (_current + 1) % FRAME_DEPTH;
+}
+
+bool PassTimer::collect(Slot& slot, bool wait) {
+    if (!wait) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(slot.queries[slot.spans * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            return false;
+        }
+    }
+
+    Frame result;
+    result.frame = slot.frame;
+    GLuint64 first = 0, last = 0;
+    for (int i = 0; i < slot.spans; ++i) {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(slot.queries[i * 2], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(slot.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+        auto pass = slot.passes[i];
+        result.passMask |= 1 << pass;
+        result.passNSecs[pass] += end > begin ? end - begin : 0;
+        first = i ? std::min(first, begin) : begin;
+        last = std::max(last, end);
+    }
+    result.totalNSecs = last > first ? last - first : 0;
+    slot.pending = false;
+
+    _results.push_back(result);
+    while (_results.size() > MAX_RESULTS) {
+        _results.pop_front();
+    }
+    return true;
+}
+
+bool PassTimer::takeResult(Frame& result) {
+    if (_results.empty()) {
+        return false;
+    }
+    result = _results.front();
+    _results.pop_front();
+    return true;
+}
+
+void PassTimer::finish() {
+    for (int i = 0; i < FRAME_DEPTH; ++i) {
+        auto& slot = _slots[(_current + i) % FRAME_DEPTH];
+        if (slot.pending) {
+            collect(slot, true);
+        }
+    }
+}
+
+void PassTimer::destroy() {
+    if (!_initialized) {
+        return;
+    }
+    for (auto& slot : _slots) {
+        glDeleteQueries(MAX_SPANS * 2, slot.queries);
+        slot = Slot();
+    }
+    _results.clear();
+    _recording = false;
+    _initialized = false;
+}
@@ -0,0 +1,88 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#pragma once
+
+#include <deque>
+
+#include <gl/Config.h>
+
+#include "types/Renderpass.h"
+
+namespace shadertoy {
+
+    // GPU time spent in each shadertoy pass, from timestamp queries.
+    //
+    // Results are read back a few frames late so that timing never stalls the
+    // pipeline; only when the GPU falls more than FRAME_DEPTH frames behind does
+    // beginFrame() block on the oldest outstanding frame.  Passes rendered more
+    // than once in a frame (once per eye in VR) are accumulated.  All calls must
+    // be made with the rendering context current.
+    class PassTimer {
+    public:
+        // Buffer A-D and the image pass
+        static const int MAX_PASSES = Renderpass::SOUND;
+        static const int FRAME_DEPTH = 4;
+        // Completed frames held for the consumer before the oldest are dropped
+        static const size_t MAX_RESULTS = 256;
+
+        struct Frame {
+            int32_t frame { -1 };
+            // Bit per Renderpass::Output which was rendered
+            uint32_t passMask { 0 };
+            uint64_t passNSecs[MAX_PASSES] {};
+            // From the start of the first pass to the end of the last
+            uint64_t totalNSecs { 0 };
+        };
+
+        ~PassTimer();
+
+        void beginFrame(int32_t frame);
+        void beginPass(Renderpass::Output pass);
+        void endPass();
+        void endFrame();
+
+        // Oldest completed frame first
+        bool takeResult(Frame& result);
+        // Wait for every outstanding frame to complete
+        void finish();
+        void destroy();
+
+    private:
+        // Every pass, for both eyes
+        static const int MAX_SPANS = MAX_PASSES * 2;
+
+        struct Slot {
+            GLuint queries[MAX_SPANS * 2] {};
+            Renderpass::Output passes[MAX_SPANS];
+            int spans { 0 };
+            int32_t frame { -1 };
+            bool pending { false };
+        };
+
+        bool collect(Slot& slot, bool wait);
+
+        Slot _slots[FRAME_DEPTH];
+        int _current { 0 };
+        bool _recording { false };
+        bool _initialized { false };
+        std::deque<Frame> _results;
+    };
+
+}
@@ -0,0 +1,110 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "Prefetcher.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <FileUtils.h>
+
+#include "Catalog.h"
+#include "types/Shader.h"
+
+using namespace shadertoy;
+
+Prefetcher::Prefetcher(const Catalog& catalog, const QString& basePath, QThread* ownerThread)
+    : _catalog(catalog), _basePath(basePath), _ownerThread(ownerThread) {
+    setObjectName("Shader Prefetch");
+}
+
+void Prefetcher::queueItemInternal(const QString& shaderId) {
+    _items.removeAll(shaderId);
+    _items.push_back(shaderId);
+    if (_items.size() > MAX_QUEUED) {
+        QMutexLocker locker(&_parsedMutex);
+        while (_items.size() > MAX_QUEUED) {
+            _dropped.push_back(_items.front());
+            _items.pop_front();
+        }
+    }
+}
+
+bool Prefetcher::processQueueItems(const Queue& items) {
+    // Most recent requests first
+    for (int i = items.size() - 1; i >= 0; --i) {
+        if (!isStillRunning()) {
+            break;
+        }
+        auto shader = parse(items[i]);
+        if (shader) {
+            shader->moveToThread(_ownerThread);
+        }
+        QMutexLocker locker(&_parsedMutex);
+        if (shader) {
+            _parsed.push_back(shader);
+        }
+        // The cache tracks the parsed shader by its own id, so the request is done with if that differs
+        if (!shader || shader->info->id != items[i]) {
+            _dropped.push_back(items[i]);
+        }
+    }
+    return isStillRunning();
+}
+
+void Prefetcher::terminating() {
+    // Don't wait out the queue timeout
+    _hasItems.wakeAll();
+}
+
+QList<Shader*> Prefetcher::takeParsed() {
+    QList<Shader*> result;
+    QMutexLocker locker(&_parsedMutex);
+    result.swap(_parsed);
+    return result;
+}
+
+QStringList Prefetcher::takeDropped() {
+    QStringList result;
+    QMutexLocker locker(&_parsedMutex);
+    result.swap(_dropped);
+    return result;
+}
+
+Shader* Prefetcher::parse(const QString& shaderId) const {
+    QJsonObject shaderObject;
+    auto catalogIndex = _catalog.indexOf(shaderId);
+    if (catalogIndex >= 0) {
+        shaderObject = QJsonDocument::fromJson(_catalog.shaderJson(catalogIndex)).object();
+    } else {
+        const QString fileName = _basePath + "/" + shaderId + ".json";
+        if (!QFile::exists(fileName)) {
+            return nullptr;
+        }
+        shaderObject = QJsonDocument::fromJson(FileUtils::readFileToByteArray(fileName)).object().value("Shader").toObject();
+    }
+
+    auto shader = new Shader();
+    if (!shader->parse(shaderObject.toVariantMap())) {
+        delete shader;
+        return nullptr;
+    }
+    return shader;
+}
@@ -0,0 +1,68 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#pragma once
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+
+#include <GenericQueueThread.h>
+
+class Shader;
+
+namespace shadertoy {
+
+    class Catalog;
+
+    // Parses shaders on a worker thread ahead of them being requested.
+    //
+    // Parsed shaders are created without a parent and moved to the thread that
+    // owns the cache, which collects them with takeParsed().  Only the most
+    // recent requests are kept, since the rows they were made for scroll out of
+    // view quickly.  Requests which are dropped or fail to parse are reported
+    // with takeDropped(), so the cache can forget them.
+    class Prefetcher : public GenericQueueThread<QString> {
+    public:
+        static const int MAX_QUEUED = 64;
+
+        Prefetcher(const Catalog& catalog, const QString& basePath, QThread* ownerThread);
+
+        QList<Shader*> takeParsed();
+        QStringList takeDropped();
+        void terminating() override;
+
+    protected:
+        void queueItemInternal(const QString& shaderId) override;
+        bool processQueueItems(const Queue& items) override;
+
+    private:
+        Shader* parse(const QString& shaderId) const;
+
+        const Catalog& _catalog;
+        const QString _basePath;
+        QThread* const _ownerThread;
+        // Guards both results
+        QMutex _parsedMutex;
+        QList<Shader*> _parsed;
+        QStringList _dropped;
+    };
+
+}
@@ -0,0 +1,252 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "ProgramCache.h"
+
+#include <iterator>
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QStandardPaths>
+
+using namespace shadertoy;
+
+static const QString PROGRAM_CACHE_DIR = "programs";
+static const QString PROGRAM_CACHE_INDEX = "index.json";
+static const QString PROGRAM_FILE_EXTENSION = ".bin";
+// Bumped whenever the on-disk entry format changes
+static const quint32 PROGRAM_CACHE_VERSION = 1;
+
+const uint64_t ProgramCache::DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+ProgramCache& ProgramCache::instance() {
+    static ProgramCache instance;
+    return instance;
+}
+
+ProgramCache::ProgramCache() : _basePath(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/shadertoys/" + PROGRAM_CACHE_DIR + "/") {
+    QDir().mkpath(_basePath);
+    readIndex();
+}
+
+ProgramCache::~ProgramCache() {
+    writeIndex();
+}
+
+QByteArray ProgramCache::key(const QString& vertexSource, const QString& fragmentSource) {
+    Lock lock(_mutex);
+    if (_driverIdentity.isEmpty()) {
+        _driverIdentity.append((const char*)glGetString(GL_VENDOR)).append('\n');
+        _driverIdentity.append((const char*)glGetString(GL_RENDERER)).append('\n');
+        _driverIdentity.append((const char*)glGetString(GL_VERSION)).append('\n');
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(_driverIdentity);
+    hash.addData(vertexSource.toUtf8());
+    hash.addData(fragmentSource.toUtf8());
+    return hash.result().toHex();
+}
+
+QString ProgramCache::fileName(const QByteArray& key) const {
+    return _basePath + QString::fromLatin1(key) + PROGRAM_FILE_EXTENSION;
+}
+
+bool ProgramCache::load(const QByteArray& key, GLuint program) {
+    QByteArray binary;
+    GLenum binaryFormat = 0;
+    {
+        Lock lock(_mutex);
+        auto itr = _entriesByKey.find(key);
+        if (itr == _entriesByKey.end()) {
+            ++_misses;
+            return false;
+        }
+
+        QFile file(fileName(key));
+        if (!file.open(QFile::ReadOnly)) {
+            remove(key);
+            ++_misses;
+            return false;
+        }
+
+        QDataStream stream(&file);
+        quint32 version, format;
+        stream >> version >> format >> binary;
+        if (stream.status() != QDataStream::Ok || version != PROGRAM_CACHE_VERSION || binary.isEmpty()) {
+            file.close();
+            remove(key);
+            ++_misses;
+            return false;
+        }
+        binaryFormat = format;
+        touch(itr.value());
+    }
+
+    glProgramBinary(program, binaryFormat, binary.data(), binary.size());
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        // The driver can reject a binary even with a matching identity string,
+        // for instance after a change in hardware configuration
+        qDebug() << "Discarding stale program binary" << key;
+        Lock lock(_mutex);
+        remove(key);
+        ++_misses;
+        return false;
+    }
+
+    ++_hits;
+    return true;
+}
+
+void ProgramCache::store(const QByteArray& key, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    QByteArray binary(length, 0);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+    binary.resize(length);
+
+    Lock lock(_mutex);
+    if (_entriesByKey.contains(key)) {
+        remove(key);
+    }
+
+    QFile file(fileName(key));
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        qWarning() << "Unable to write program binary" << file.fileName();
+        return;
+    }
+    {
+        QDataStream stream(&file);
+        stream << PROGRAM_CACHE_VERSION << (quint32)binaryFormat << binary;
+    }
+    Entry entry;
+    entry.key = key;
+    entry.size = (uint64_t)file.size();
+    file.close();
+
+    _entries.push_front(entry);
+    _entriesByKey[key] = _entries.begin();
+    _totalBytes += entry.size;
+    evict();
+    writeIndex();
+}
+
+void ProgramCache::setMaxBytes(uint64_t maxBytes) {
+    Lock lock(_mutex);
+    _maxBytes = maxBytes;
+    evict();
+    writeIndex();
+}
+
+ProgramCache::Stats ProgramCache::getStats() const {
+    Stats result;
+    result.hits = _hits;
+    result.misses = _misses;
+    result.evictions = _evictions;
+    Lock lock(_mutex);
+    result.entries = _entries.size();
+    result.bytes = _totalBytes;
+    return result;
+}
+
+// Must be called with the mutex held
+void ProgramCache::touch(EntryList::iterator itr) {
+    _entries.splice(_entries.begin(), _entries, itr);
+}
+
+// Must be called with the mutex held
+void ProgramCache::remove(const QByteArray& key) {
+    auto itr = _entriesByKey.find(key);
+    if (itr == _entriesByKey.end()) {
+        return;
+    }
+    _totalBytes -= itr.value()->size;
+    _entries.erase(itr.value());
+    _entriesByKey.erase(itr);
+    QFile::remove(fileName(key));
+}
+
+// Must be called with the mutex held
+void ProgramCache::evict() {
+    while (_totalBytes > _maxBytes && !_entries.empty()) {
+        // Never evict the entry that was just stored
+        if (_entries.size() == 1) {
+            break;
+        }
+        remove(_entries.back().key);
+        ++_evictions;
+    }
+}
+
+void ProgramCache::readIndex() {
+    QFile file(_basePath + PROGRAM_CACHE_INDEX);
+    if (!file.open(QFile::ReadOnly)) {
+        return;
+    }
+
+    auto entries = QJsonDocument::fromJson(file.readAll()).array();
+    for (const auto& value : entries) {
+        auto object = value.toObject();
+        Entry entry;
+        entry.key = object.value("key").toString().toLatin1();
+        if (entry.key.isEmpty() || _entriesByKey.contains(entry.key)) {
+            continue;
+        }
+        QFileInfo info(fileName(entry.key));
+        if (!info.exists()) {
+            continue;
+        }
+        entry.size = info.size();
+        // The index is written most recently used first
+        _entries.push_back(entry);
+        _entriesByKey[entry.key] = std::prev(_entries.end());
+        _totalBytes += entry.size;
+    }
+}
+
+// Must be called with the mutex held, or from the destructor
+void ProgramCache::writeIndex() const {
+    QJsonArray entries;
+    for (const auto& entry : _entries) {
+        QJsonObject object;
+        object["key"] = QString::fromLatin1(entry.key);
+        object["size"] = (double)entry.size;
+        entries.append(object);
+    }
+
+    QFile file(_basePath + PROGRAM_CACHE_INDEX);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return;
+    }
+    file.write(QJsonDocument(entries).toJson(QJsonDocument::Compact));
+}
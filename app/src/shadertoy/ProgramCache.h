@@ -0,0 +1,108 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <mutex>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QString>
+
+#include <gl/Config.h>
+
+namespace shadertoy {
+
+    // On-disk cache of linked program binaries, so that re-opening a shader
+    // which has already been built skips the compile and link entirely.
+    //
+    // Entries are keyed on the full program source (vertex shader plus the
+    // header + code + footer fragment shader) and the identity of the GL driver,
+    // since binaries are not portable across drivers or driver versions.  The
+    // total size on disk is capped and the least recently used entries are
+    // evicted first.
+    class ProgramCache {
+    public:
+        struct Stats {
+            uint64_t hits { 0 };
+            uint64_t misses { 0 };
+            uint64_t evictions { 0 };
+            uint64_t entries { 0 };
+            uint64_t bytes { 0 };
+        };
+
+        static const uint64_t DEFAULT_MAX_BYTES;
+
+        static ProgramCache& instance();
+
+        ~ProgramCache();
+
+        // Requires a current GL context the first time it's called, in order to
+        // fetch the driver identity
+        QByteArray key(const QString& vertexSource, const QString& fragmentSource);
+
+        // Attempt to populate the program object from the cache.  Returns false
+        // on a miss or if the driver rejects the stored binary, in which case the
+        // caller must compile and link the program normally.
+        bool load(const QByteArray& key, GLuint program);
+
+        // Store a successfully linked program.  The program should have been linked
+        // with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+        void store(const QByteArray& key, GLuint program);
+
+        void setMaxBytes(uint64_t maxBytes);
+        Stats getStats() const;
+
+    private:
+        using Mutex = std::mutex;
+        using Lock = std::unique_lock<Mutex>;
+
+        struct Entry {
+            QByteArray key;
+            uint64_t size { 0 };
+        };
+        using EntryList = std::list<Entry>;
+
+        ProgramCache();
+
+        QString fileName(const QByteArray& key) const;
+        void readIndex();
+        void writeIndex() const;
+        void touch(EntryList::iterator itr);
+        void remove(const QByteArray& key);
+        void evict();
+
+        const QString _basePath;
+        QByteArray _driverIdentity;
+        uint64_t _maxBytes { DEFAULT_MAX_BYTES };
+        uint64_t _totalBytes { 0 };
+
+        mutable Mutex _mutex;
+        // Most recently used entries are at the front
+        EntryList _entries;
+        QHash<QByteArray, EntryList::iterator> _entriesByKey;
+
+        std::atomic<uint64_t> _hits { 0 };
+        std::atomic<uint64_t> _misses { 0 };
+        std::atomic<uint64_t> _evictions { 0 };
+    };
+
+}
@@ -22,15 +22,29 @@ limitations under the License.
 #include <QtGui/QOpenGLContext>
 #include <QtGui/QOpenGLFunctions>
 #include <QtCore/QRegularExpression>
+#include <QtCore/QThread>
 #include <QGLWidget>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+#include <gl/GLTraceRange.h>
 #include <gl/GLWindow.h>
+#include <gl/OffscreenGLCanvas.h>
 #include <plugins/DisplayPlugin.h>
 #include <MatrixStack.h>
 #include <FileUtils.h>
 #include <Platform.h>
+#include <SharedUtil.h>
 #include <shared/NsightHelpers.h>
 #include "../Application.h"
+#include "ProgramCache.h"
+#include "ScaleGovernor.h"
+#include "StateTracker.h"
+#include "UniformRing.h"
 
 
 enum Uniforms {
@@ -47,6 +61,9 @@ enum Bindings {
     ShadertoyVariable = 2
 };
 
+static const int MAX_PASSES = Renderpass::SOUND;
+static const float SAMPLE_RATE = 44100.0f;
+
 static const uvec2 VR_2D_RESOLUTION { 800, 450 };
 static const float VR_2D_ASPECT = (float)VR_2D_RESOLUTION.x / (float)VR_2D_RESOLUTION.y;
 
@@ -67,15 +84,19 @@ void main() {
 
 
 static const char* const SHADER_HEADER = R"SHADER(#version 450 core
-layout (binding = 1, std140) uniform Shadertoy
+layout (binding = 1, std140) uniform ShadertoyStatic
+{
+    vec3      iResolution;           // viewport resolution (in pixels)
+    float     iSampleRate;           // sound sample rate (i.e., 44100)
+    vec3      iChannelResolution[4]; // channel resolution (in pixels)
+};
+
+layout (binding = 2, std140) uniform ShadertoyVariable
 {
     float     iGlobalTime;           // shader playback time (in seconds)
     float     iTimeDelta;            // render time (in seconds)
-    float     iSampleRate;           // sound sample rate (i.e., 44100)
     int       iFrame;                // Shader playback frame
     float     iChannelTime[4];       // channel playback time (in seconds)
-    vec3      iResolution;           // viewport resolution (in pixels)
-    vec3      iChannelResolution[4]; // channel resolution (in pixels)
     vec4      iMouse;                // mouse pixel coords. xy: current (if MLB down), zw: click
     vec4      iDate;                 // (year, month, day, time in seconds)
 };
@@ -145,18 +166,22 @@ void main() {
 
 )FS";
 
-struct ShadertoyInputs {
+// Mirror the std140 layout of the uniform blocks in SHADER_HEADER
+
+// Per pass, and only changes with the resolution or the shader
+struct ShadertoyStaticInputs {
+    vec3      iResolution;           // viewport resolution (in pixels)
+    float     iSampleRate;           // sound sample rate (i.e., 44100)
+    vec4      iChannelResolution[4]; // channel resolution (in pixels)
+};
+
+// Shared by all passes, and changes every frame
+struct ShadertoyVariableInputs {
     float     iGlobalTime;           // shader playback time (in seconds)
     float     iTimeDelta;            // render time (in seconds)
-    // FIXME move to non-per-frame uniforms
-    float     iSampleRate;           // sound sample rate (i.e., 44100)
     int       iFrame;                // Shader playback frame
-    int       _padding[12];
-    float     iChannelTime[4];       // channel playback time (in seconds)
-    // FIXME move to non-per-frame uniforms
-    vec4      iResolution;           // viewport resolution (in pixels)
-    // FIXME move to non-per-frame uniforms
-    vec4      iChannelResolution[4];   // channel resolution (in pixels)
+    float     _padding;
+    vec4      iChannelTime[4];       // channel playback time (in seconds), std140 pads array elements
     vec4      iMouse;                // mouse pixel coords. xy: current (if MLB down), zw: click
     vec4      iDate;                 // (year, month, day, time in seconds)
 };
@@ -211,8 +236,13 @@ struct CachedTexture {
 
 QHash<QString, CachedTexture> cachedTextures;
 
+// Holds copies of the Input fields it needs, since the parsed shader objects
+// are owned by the cache and may be evicted while the shader is still rendering
 struct InputGL {
-    Input* input { nullptr };
+    bool valid { false };
+    Input::Type ctype { Input::NONE };
+    int channel { -1 };
+    QString src;
     vec3 resolution;
     uvec2 size;
     oglplus::TextureTarget target { oglplus::TextureTarget::_2D };
@@ -221,16 +251,17 @@ struct InputGL {
     oglplus::TextureMinFilter minFilter { oglplus::TextureMinFilter::Nearest };
     oglplus::TextureMagFilter magFilter { oglplus::TextureMagFilter::Nearest };
     oglplus::TextureWrap wrap { oglplus::TextureWrap::ClampToEdge };
+    GLuint sampler { 0 };
     bool flip { true };
     bool srgb { false };
     oglplus::PixelDataType format { oglplus::PixelDataType::Byte };
 
-    void bind(bool even) const {
-        if (!input) {
+    void bind(bool even, StateTracker& state) const {
+        if (!valid) {
             return;
         }
 
-        switch (input->ctype) {
+        switch (ctype) {
         case Input::AUDIO:
         case Input::SOUNDCLOUD:
         case Input::MIC:
@@ -240,58 +271,20 @@ struct InputGL {
         }
 
         auto& texture = even ? textures[0] : (textures[1] ? textures[1] : textures[0]);
-        if (!texture || input->channel == -1) {
+        if (!texture || channel == -1) {
             qFatal("Invalid input texture");
         }
 
-        using namespace oglplus;
-        Texture::Active(input->channel);
-        texture->Bind(target);
-        // FIXME excessive 
-        Texture::WrapS(target, wrap);
-        Texture::WrapT(target, wrap);
-        Texture::WrapR(target, wrap);
-        Texture::MinFilter(target, minFilter);
-        Texture::MagFilter(target, magFilter);
+        state.bindTexture(channel, (GLenum)target, oglplus::GetName(*texture));
+        state.bindSampler(channel, sampler);
     }
 
-    static InputGL build(Input* input, int bufferIndex = -1) {
+    static InputGL prepare(Input* input) {
         InputGL result;
-        result.input = input;
-        CachedTexture cachedTexture;
-        switch (input->ctype) {
-        case Input::TEXTURE:
-        case Input::BUFFER:
-            if (!cachedTextures.contains(input->src)) {
-                throw std::runtime_error("Could not find cached texture");
-            }
-            cachedTexture = cachedTextures[input->src];
-            break;
-
-        case Input::CUBEMAP:
-            if (!cachedTextures.contains(input->src)) {
-                throw std::runtime_error("Could not find cached texture");
-            }
-            cachedTexture = cachedTextures[input->src];
-            result.target = oglplus::TextureTarget::CubeMap;
-            break;
-
-        case Input::KEYBOARD:
-            cachedTexture = cachedTextures[KEYBOARD];
-            break;
-
-        case Input::MIC:
-            cachedTexture = cachedTextures[MIC];
-            break;
-
-        case Input::WEBCAM:
-            cachedTexture = cachedTextures[WEBCAM];
-            break;
-        }
-
-        result.textures = cachedTexture.textures;
-        result.size = cachedTexture.resolution;
-        result.resolution = vec3(result.size, 1);
+        result.valid = true;
+        result.ctype = input->ctype;
+        result.channel = input->channel;
+        result.src = input->src;
 
         using namespace oglplus;
         switch (input->wrap) {
@@ -324,22 +317,82 @@ struct InputGL {
         }
         return result;
     }
+
+    // Look up the texture in the texture cache
+    void resolve(StateTracker& state) {
+        if (!valid) {
+            return;
+        }
+        sampler = state.getSampler((GLenum)wrap, (GLenum)minFilter, (GLenum)magFilter);
+        CachedTexture cachedTexture;
+        switch (ctype) {
+        case Input::TEXTURE:
+        case Input::BUFFER:
+            if (!cachedTextures.contains(src)) {
+                throw std::runtime_error("Could not find cached texture");
+            }
+            cachedTexture = cachedTextures[src];
+            break;
+
+        case Input::CUBEMAP:
+            if (!cachedTextures.contains(src)) {
+                throw std::runtime_error("Could not find cached texture");
+            }
+            cachedTexture = cachedTextures[src];
+            target = oglplus::TextureTarget::CubeMap;
+            break;
+
+        case Input::KEYBOARD:
+            cachedTexture = cachedTextures[KEYBOARD];
+            break;
+
+        case Input::MIC:
+            cachedTexture = cachedTextures[MIC];
+            break;
+
+        case Input::WEBCAM:
+            cachedTexture = cachedTextures[WEBCAM];
+            break;
+        }
+
+        textures = cachedTexture.textures;
+        size = cachedTexture.resolution;
+        resolution = vec3(size, 1);
+    }
 };
 
 
 struct RenderpassGL {
-    Renderpass* renderpass { nullptr };
+    Renderpass::Output output { Renderpass::IMAGE };
+    // The preprocessed fragment source, including the header but not the footer
+    QString source;
+    bool vr { false };
     ProgramPtr program;
     ProgramPtr vrProgram;
     // The currently active input channels
     InputGL inputs[4];
     std::array<FramebufferPtr, 2> outputs;
+    uint64_t compileTimeUsecs { 0 };
     static VertexShaderPtr _vertexShader;
 
-    void bind(bool even) {
-        outputs[even ? 0 : 1]->Bind(oglplus::FramebufferTarget::Draw);
+    static void init() {
+        using namespace oglplus;
+        if (_vertexShader) {
+            return;
+        }
+        _vertexShader = std::make_shared<VertexShader>();
+        try {
+            _vertexShader->Source(VERTEX_SHADER);
+            _vertexShader->Compile();
+        } catch (std::runtime_error& err) {
+            qDebug() << err.what();
+        }
+    }
+
+    void bind(bool even, StateTracker& state) {
+        state.bindDrawFramebuffer(oglplus::GetName(*outputs[even ? 0 : 1]));
         for (const auto& input : inputs) {
-            input.bind(even);
+            input.bind(even, state);
         }
     }
 
@@ -348,25 +401,19 @@ struct RenderpassGL {
         QByteArray qb = source.toLocal8Bit();
         GLchar * fragmentSource = (GLchar*)qb.data();
         StrCRef src(fragmentSource);
-        if (!_vertexShader) {
-            _vertexShader = std::make_shared<VertexShader>();
-            try {
-                _vertexShader->Source(VERTEX_SHADER);
-                _vertexShader->Compile();
-            } catch (std::runtime_error& err) {
-                qDebug() << err.what();
-            }
-            Platform::addShutdownHook([&] {
-                _vertexShader.reset();
-            });
-        }
-        FragmentShaderPtr newFragmentShader(new FragmentShader());
-        newFragmentShader->Source(GLSLSource(src));
-        newFragmentShader->Compile();
+        auto& programCache = ProgramCache::instance();
+        auto cacheKey = programCache.key(VERTEX_SHADER, source);
         ProgramPtr program = std::make_shared<Program>();
-        program->AttachShader(*_vertexShader);
-        program->AttachShader(*newFragmentShader);
-        program->Link();
+        if (!programCache.load(cacheKey, GetName(*program))) {
+            FragmentShaderPtr newFragmentShader(new FragmentShader());
+            newFragmentShader->Source(GLSLSource(src));
+            newFragmentShader->Compile();
+            program->AttachShader(*_vertexShader);
+            program->AttachShader(*newFragmentShader);
+            glProgramParameteri(GetName(*program), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            program->Link();
+            programCache.store(cacheKey, GetName(*program));
+        }
         program->Bind();
         auto activeUniforms = getActiveUniforms(program);
         for (int i = 0; i < 4; ++i) {
@@ -378,10 +425,11 @@ struct RenderpassGL {
         return program;
     }
 
-    static RenderpassGL build(Renderpass* pass) {
+    // Called on the thread which owns the Shader object, so that the builder
+    // thread never touches the QObject graph
+    static RenderpassGL prepare(Renderpass* pass) {
         RenderpassGL result;
-        result.renderpass = pass;
-        using namespace oglplus;
+        result.output = pass->output;
         QString header = SHADER_HEADER;
 
         for (auto input : pass->_inputs) {
@@ -401,29 +449,44 @@ struct RenderpassGL {
             replace(QRegExp("\\bchar\\b"), "char_").
             replace(QRegExp("\\btextureCube\\b"), "texture");
         source.insert(0, header);
-        result.program = buildShader(source + FOOTER_2D);
-        
-        if (source.contains(Shadertoy::VR_MARKER)) {
-            result.vrProgram = buildShader(source + FOOTER_VR);
-        }
+        result.source = source;
+        result.vr = source.contains(Shadertoy::VR_MARKER);
 
         for (auto& input : pass->_inputs) {
-            auto channel = input->channel;
-            result.inputs[channel] = InputGL::build(input);
+            result.inputs[input->channel] = InputGL::prepare(input);
         }
         return result;
     }
+
+    // Called on any thread with a context shared with the primary rendering context
+    void compile() {
+        PROFILE_RANGE(__FUNCTION__);
+        auto start = usecTimestampNow();
+        program = buildShader(source + FOOTER_2D);
+        if (vr) {
+            vrProgram = buildShader(source + FOOTER_VR);
+        }
+        compileTimeUsecs = usecTimestampNow() - start;
+    }
+
+    // Called on the rendering thread, since the texture cache and samplers are owned by it
+    void setupInputs(StateTracker& state) {
+        for (auto& input : inputs) {
+            input.resolve(state);
+        }
+    }
 };
 
 VertexShaderPtr RenderpassGL::_vertexShader;
 
 struct ShaderGL {
     using Pointer = std::shared_ptr<ShaderGL>;
-    Shader* shader { nullptr };
+    // The cache may evict the shader while it builds.  Only read on the thread which owns it.
+    QPointer<Shader> shader;
     std::list<RenderpassGL> passes;
     bool vrShader { false };
 
-    static ShaderGL build(Shader* shader) {
+    static ShaderGL prepare(Shader* shader) {
         Renderpass* imagePass = nullptr;
         ShaderGL result;
         result.shader = shader;
@@ -436,7 +499,7 @@ struct ShaderGL {
                 continue;
             }
 
-            auto renderpass = RenderpassGL::build(pass);
+            auto renderpass = RenderpassGL::prepare(pass);
             switch (result.passes.size()) {
                 case 0: break;
                 case 1: pass->output = Renderpass::BUFFER_B; break;
@@ -444,6 +507,7 @@ struct ShaderGL {
                 case 3: pass->output = Renderpass::BUFFER_D; break;
                 default: throw std::runtime_error("Too many buffer passes");
             }
+            renderpass.output = pass->output;
             result.passes.push_back(renderpass);
         }
 
@@ -451,7 +515,7 @@ struct ShaderGL {
             throw std::runtime_error("Unable to find an image output shader");
         }
         result.vrShader = imagePass->code.contains(Shadertoy::VR_MARKER);
-        result.passes.push_back(RenderpassGL::build(imagePass));
+        result.passes.push_back(RenderpassGL::prepare(imagePass));
         return  result;
     }
 };
@@ -459,10 +523,175 @@ struct ShaderGL {
 using ShaderGLPtr = ShaderGL::Pointer;
 ShaderGLPtr currentShadertoy;
 
+namespace shadertoy {
+
+    // Compiles shaders on a context shared with the primary rendering context, so
+    // that the current shader keeps rendering while a new one builds.  Only the
+    // most recently requested shader is built; a request which arrives while a
+    // build is in flight supersedes it, and the stale build is abandoned at the
+    // next pass boundary.
+    class ShaderBuilder : public QThread {
+    public:
+        using Mutex = std::mutex;
+        using Lock = std::unique_lock<Mutex>;
+        using Condition = std::condition_variable;
+
+        struct Result {
+            ShaderGLPtr shader;
+            QString error;
+            // True if the error came from the GLSL compiler or linker
+            bool compileError { false };
+        };
+
+        ShaderBuilder(QOpenGLContext* shareContext) {
+            if (!_canvas.create(shareContext)) {
+                qWarning("Failed to create OffscreenGLCanvas for shader builder");
+                _quit = true;
+                return;
+            }
+            _canvas.getContextObject()->moveToThread(this);
+        }
+
+        void queue(const ShaderGLPtr& shader) {
+            Lock lock(_mutex);
+            if (_pending) {
+                ++_cancelledBuilds;
+            }
+            _pending = shader;
+            _condition.notify_one();
+        }
+
+        bool takeResult(Result& result) {
+            Lock lock(_mutex);
+            if (!_hasResult) {
+                return false;
+            }
+            result = _result;
+            _result = Result();
+            _hasResult = false;
+            return true;
+        }
+
+        // Wait for the current build to report a result, used for offline rendering
+        void waitForResult() {
+            Lock lock(_mutex);
+            _resultCondition.wait(lock, [&] { return _quit || _hasResult; });
+        }
+
+        void stop() {
+            {
+                Lock lock(_mutex);
+                _quit = true;
+                _pending.reset();
+                _condition.notify_one();
+                _resultCondition.notify_all();
+            }
+            wait();
+        }
+
+        uint32_t cancelledBuilds() const {
+            return _cancelledBuilds;
+        }
+
+    protected:
+        void run() override {
+            if (_quit || !_canvas.makeCurrent()) {
+                qWarning("Failed to make context current on shader builder thread");
+                return;
+            }
+
+            while (true) {
+                ShaderGLPtr shader;
+                {
+                    Lock lock(_mutex);
+                    _condition.wait(lock, [&] { return _quit || _pending; });
+                    if (_quit) {
+                        break;
+                    }
+                    shader.swap(_pending);
+                }
+                build(shader);
+            }
+
+            _canvas.doneCurrent();
+            _canvas.getContextObject()->moveToThread(QCoreApplication::instance()->thread());
+        }
+
+    private:
+        bool superseded() {
+            Lock lock(_mutex);
+            return _quit || _pending;
+        }
+
+        void build(const ShaderGLPtr& shader) {
+            Result result;
+            try {
+                for (auto& pass : shader->passes) {
+                    if (superseded()) {
+                        ++_cancelledBuilds;
+                        return;
+                    }
+                    pass.compile();
+                }
+                // Objects created on one context must be complete before they
+                // are used on another
+                glFinish();
+                result.shader = shader;
+            } catch (const oglplus::ProgramBuildError& err) {
+                result.error = QString(err.Log().c_str());
+                result.compileError = true;
+            } catch (const std::runtime_error& err) {
+                result.error = QString(err.what());
+            }
+
+            Lock lock(_mutex);
+            // Don't report the result of a build that was superseded while finishing up
+            if (_pending) {
+                ++_cancelledBuilds;
+            } else {
+                _result = result;
+                _hasResult = true;
+                _resultCondition.notify_all();
+            }
+        }
+
+        OffscreenGLCanvas _canvas;
+        Mutex _mutex;
+        Condition _condition;
+        Condition _resultCondition;
+        ShaderGLPtr _pending;
+        Result _result;
+        bool _hasResult { false };
+        bool _quit { false };
+        std::atomic<uint32_t> _cancelledBuilds { 0 };
+    };
+
+}
+
 void Renderer::setShader(const QVariant& shader) {
     _shader = qvariant_cast<::Shader*>(shader);
 }
 
+// Reallocate the color texture of a buffer framebuffer, scaling the existing
+// contents into the new storage
+static void reallocatePreserving(const FramebufferPtr& framebuffer, oglplus::Texture& texture, const uvec2& oldSize, const uvec2& newSize) {
+    using namespace oglplus;
+    Texture copy;
+    Context::Bound(TextureTarget::_2D, copy)
+        .Image2D(0, PixelDataInternalFormat::RGBA16F, oldSize.x, oldSize.y, 0, PixelDataFormat::RGBA, PixelDataType::Float, nullptr);
+    Framebuffer copyFramebuffer;
+    copyFramebuffer.Bind(FramebufferTarget::Draw);
+    copyFramebuffer.AttachTexture(FramebufferTarget::Draw, FramebufferAttachment::Color, copy, 0);
+    framebuffer->Bind(FramebufferTarget::Read);
+    Context::BlitFramebuffer(0, 0, oldSize.x, oldSize.y, 0, 0, oldSize.x, oldSize.y, BufferSelectBit::ColorBuffer, BlitFilter::Nearest);
+
+    Context::Bound(TextureTarget::_2D, texture)
+        .Image2D(0, PixelDataInternalFormat::RGBA16F, newSize.x, newSize.y, 0, PixelDataFormat::RGBA, PixelDataType::Float, nullptr);
+    copyFramebuffer.Bind(FramebufferTarget::Read);
+    framebuffer->Bind(FramebufferTarget::Draw);
+    Context::BlitFramebuffer(0, 0, oldSize.x, oldSize.y, 0, 0, newSize.x, newSize.y, BufferSelectBit::ColorBuffer, BlitFilter::Linear);
+}
+
 void Renderer::resize() {
     PROFILE_RANGE(__FUNCTION__);
     if (!_size.x || !_size.y) {
@@ -470,27 +699,36 @@ void Renderer::resize() {
     }
 
     auto oldRenderResolution = _renderResolution;
-    auto displayPlugin = qApp->getActiveDisplayPlugin();
     auto targetResolution = _size;
-    if (displayPlugin->isHmd() && !currentShadertoy->vrShader) {
-        targetResolution = uvec2(800, 450);
+    bool hmd = isHmd();
+    if (hmd && currentShadertoy && !currentShadertoy->vrShader) {
+        targetResolution = VR_2D_RESOLUTION;
         _renderScale = 1.0f;
     }
     _eyeRenderResolution = _renderResolution = uvec2(vec2(targetResolution) * _renderScale);
-    if (currentShadertoy && currentShadertoy->vrShader && displayPlugin->isHmd()) {
-        _renderScale = 0.5f;
+    if (currentShadertoy && currentShadertoy->vrShader && hmd) {
+        if (!_adaptiveScale) {
+            _renderScale = 0.5f;
+        }
         _eyeRenderResolution.x /= 2;
     }
 
-    
     using namespace oglplus;
     if (_renderResolution != oldRenderResolution) {
+        // Shaders which accumulate state in their buffers carry on from where
+        // they were, so a change of scale doesn't restart them
+        bool preserve = currentShadertoy && oldRenderResolution.x && oldRenderResolution.y;
         for (int i = 0; i < BUFFERS.size(); ++i) {
             auto& cachedTexture = cachedTextures[BUFFERS.at(i)];
             cachedTexture.resolution = _renderResolution;
             for (int j = 0; j < 2; ++j) {
-                Context::Bound(TextureTarget::_2D, *cachedTexture.textures[j])
-                    .Image2D(0, PixelDataInternalFormat::RGBA16F, _renderResolution.x, _renderResolution.y, 0, PixelDataFormat::RGBA, PixelDataType::Float, nullptr);
+                auto& texture = *cachedTexture.textures[j];
+                if (preserve) {
+                    reallocatePreserving(_bufferFramebuffers[i][j == 0 ? 1 : 0], texture, oldRenderResolution, _renderResolution);
+                } else {
+                    Context::Bound(TextureTarget::_2D, texture)
+                        .Image2D(0, PixelDataInternalFormat::RGBA16F, _renderResolution.x, _renderResolution.y, 0, PixelDataFormat::RGBA, PixelDataType::Float, nullptr);
+                }
             }
         }
 
@@ -501,27 +739,49 @@ void Renderer::resize() {
         if (currentShadertoy) {
             for (auto& pass : currentShadertoy->passes) {
                 for (auto& input : pass.inputs) {
-                    if (input.input && input.input->ctype == Input::BUFFER) {
+                    if (input.valid && input.ctype == Input::BUFFER) {
                         input.resolution = vec3(_renderResolution, 1.0f);
                     }
                 }
             }
         }
     }
-    _shaderFrame = 0;
+}
+
+void Renderer::updateRenderScale() {
+    // The 2D-in-HMD path renders at a fixed resolution
+    bool fixedResolution = isHmd() && !currentShadertoy->vrShader;
+    _governor.setTargetFrameRate(qApp->getActiveDisplayPlugin()->getTargetFrameRate());
+    bool changed = false;
+    PassTimer::Frame frame;
+    while (_passTimer.takeResult(frame)) {
+        if (!fixedResolution && _governor.update((float)frame.totalNSecs / NSECS_PER_USEC / USECS_PER_MSEC)) {
+            changed = true;
+        }
+    }
+    if (changed) {
+        setScale(_governor.scale());
+    }
 }
 
 void Renderer::render() {
+    processBuildResults();
+
     if (!currentShadertoy || !_size.x || !_size.y) {
         return;
     }
 
+    if (_adaptiveScale) {
+        updateRenderScale();
+    }
+
     if (_resolutionDirty) {
         resize();
         _resolutionDirty = false;
     }
 
-    auto displayPlugin = qApp->getActiveDisplayPlugin();
+    bool hmd = isHmd();
+    auto displayPlugin = hmd ? qApp->getActiveDisplayPlugin() : DisplayPluginPointer();
 
     // Use odd textures as buffer inputs
     bool even = 0 == (_shaderFrame % 2);
@@ -531,10 +791,19 @@ void Renderer::render() {
     auto& pr = Stacks::projection();
 
     using namespace oglplus;
+    const bool passTiming = _passTiming || _adaptiveScale;
+    if (passTiming) {
+        _passTimer.beginFrame(_shaderFrame);
+    }
+    _bindState.beginFrame();
+    // Every pass draws the skybox
+    _skybox->Use();
+    _bindState.count(1);
     {
-        PROFILE_RANGE(__FUNCTION__"Render");
+        PROFILE_RANGE("Renderer::render/Render");
+        PROFILE_GPU_RANGE_EX("Renderer::render/Render", _shaderFrame);
         using namespace oglplus;
-        if (displayPlugin->isHmd() && currentShadertoy->vrShader) {
+        if (hmd && currentShadertoy->vrShader) {
             static vec3 eyeOffsets[2];
             static vec3 transformedEyeOffsets[2];
             auto headOrientation = glm::inverse(glm::quat_cast(mv.top()));
@@ -553,15 +822,19 @@ void Renderer::render() {
                     auto origin = translation + transformedEyeOffsets[eye];
                     mv.top()[3] = vec4(0, 0, 0, 1);
                     for (auto& pass : currentShadertoy->passes) {
-                        pass.bind(even);
+                        pass.bind(even, _bindState);
+                        bindStaticUniforms(pass.output);
                         if (pass.vrProgram) {
-                            pass.vrProgram->Bind();
-                            if (pass.vrProgram) {
-                                ProgramUniform<vec3>(*pass.vrProgram, 3).TrySet(origin);
-                            }
+                            ProgramUniform<vec3>(*pass.vrProgram, 3).TrySet(origin);
                         }
                         // FIXME subdivide the view matrix and render in parts.
-                        renderGeometry(_skybox, pass.vrProgram ? pass.vrProgram : pass.program);
+                        if (passTiming) {
+                            _passTimer.beginPass(pass.output);
+                        }
+                        drawPass(pass.vrProgram ? pass.vrProgram : pass.program);
+                        if (passTiming) {
+                            _passTimer.endPass();
+                        }
                     }
                 });
             });
@@ -570,19 +843,34 @@ void Renderer::render() {
             Context::Viewport(_size.x, _size.y);
             Stacks::modelview().withIdentity([&] {
                 for (auto& pass : currentShadertoy->passes) {
-                    pass.bind(even);
-                    renderGeometry(_skybox, pass.program);
+                    pass.bind(even, _bindState);
+                    bindStaticUniforms(pass.output);
+                    if (passTiming) {
+                        _passTimer.beginPass(pass.output);
+                    }
+                    drawPass(pass.program);
+                    if (passTiming) {
+                        _passTimer.endPass();
+                    }
                 }
             });
         }
     }
+    NoVertexArray().Bind();
+    _bindState.count(1);
+    _bindState.endFrame();
+    if (passTiming) {
+        _passTimer.endFrame();
+    }
+    _variableUniforms.fence();
 
-    {
-        PROFILE_RANGE(__FUNCTION__" Transfer");
+    // Offline rendering reads the result directly from the image framebuffer
+    if (!_headlessCanvas) {
+        PROFILE_RANGE("Renderer::render/Transfer");
         qApp->restoreDefaultFramebuffer();
 
-        if (displayPlugin->isHmd() && !currentShadertoy->vrShader) {
-            PROFILE_RANGE(__FUNCTION__" Hmd");
+        if (hmd && !currentShadertoy->vrShader) {
+            PROFILE_RANGE("Renderer::render/Hmd");
             Context::Clear().ColorBuffer();
             Stacks::withIdentity([&] {
                 for_each_eye([&](Eye eye) {
@@ -597,35 +885,58 @@ void Renderer::render() {
                 });
             });
         } else {
-            PROFILE_RANGE(__FUNCTION__" Blit");
+            PROFILE_RANGE("Renderer::render/Blit");
             _imageFramebuffer->Bind(FramebufferTarget::Read);
             oglplus::Context::BlitFramebuffer(0, 0, _renderResolution.x, _renderResolution.y, 0, 0, _size.x, _size.y, BufferSelectBit::ColorBuffer, BlitFilter::Linear);
         }
     }
 
-    for (int i = 0; i < 255; ++i) {
-        _keyboardState[i + 256] = 0;
+    // Keys are only "just pressed" for a single frame
+    for (int i = 0; i < 256; ++i) {
+        if (_keyboardState[i + 256]) {
+            _keyboardState[i + 256] = 0;
+            _keyboardDirty = true;
+        }
     }
     ++_shaderFrame;
 }
 
+bool Renderer::makeContextCurrent() {
+    if (_headlessCanvas) {
+        return _headlessCanvas->makeCurrent();
+    }
+    return qApp->makePrimaryRenderingContextCurrent();
+}
+
+bool Renderer::isHmd() const {
+    return !_headlessCanvas && qApp->getActiveDisplayPlugin()->isHmd();
+}
+
+void Renderer::setupHeadless(const uvec2& size, OffscreenGLCanvas* canvas) {
+    _headlessCanvas = canvas;
+    // Offline output should be at the requested scale, not whatever keeps up
+    _adaptiveScale = false;
+    setup(size);
+}
+
 void Renderer::setup(const uvec2& size) {
-    qApp->makePrimaryRenderingContextCurrent();
+    makeContextCurrent();
     glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &_uboAlignment);
 
-    auto inputsSize = sizeof(ShadertoyInputs);
-    auto inputsUboSize = inputsSize + (_uboAlignment - (inputsSize % _uboAlignment));
-    // Maximum number of passes
-    _shadertoyInputs.resize(static_cast<int>(inputsUboSize * 5));
-    _shadertoyInputs.fill(0);
+    // Each pass's block has to start on an aligned offset
+    const size_t staticSize = sizeof(ShadertoyStaticInputs);
+    _staticStride = (int32_t)(((staticSize + _uboAlignment - 1) / _uboAlignment) * _uboAlignment);
+    _staticInputs.resize(_staticStride * MAX_PASSES);
+    _staticInputs.fill(0);
 
     compileProgram(_planeProgram, SIMPLE_TEXTURED_VS, SIMPLE_TEXTURED_FS);
     _plane = loadPlane(_planeProgram, VR_2D_ASPECT);
 
     using namespace oglplus;
-    _uniformsBuffer = std::make_shared<oglplus::Buffer>();
-    _uniformsBuffer->Bind(BufferTarget::Uniform);
-    Buffer::Data(BufferTarget::Uniform, _shadertoyInputs.size(), _shadertoyInputs.data(), BufferUsage::StreamDraw);
+    _staticUniformsBuffer = std::make_shared<oglplus::Buffer>();
+    _staticUniformsBuffer->Bind(BufferTarget::Uniform);
+    Buffer::Data(BufferTarget::Uniform, _staticInputs.size(), _staticInputs.data(), BufferUsage::DynamicDraw);
+    _variableUniforms.create(sizeof(ShadertoyVariableInputs), _uboAlignment);
     Q_ASSERT(QOpenGLContext::currentContext());
 
     initTextureCache();
@@ -660,12 +971,26 @@ void Renderer::setup(const uvec2& size) {
     //updateShader(globalModel->_cache->fetchShader("test"));
     //build();
 
+    RenderpassGL::init();
+    _builder = new ShaderBuilder(_headlessCanvas ? _headlessCanvas->getContext() : qApp->getPrimaryRenderingContext());
+    _builder->start();
+    makeContextCurrent();
+
     Platform::addShutdownHook([&] {
+        if (_builder) {
+            _builder->stop();
+            delete _builder;
+            _builder = nullptr;
+        }
         currentShadertoy.reset();
+        _passTimer.destroy();
+        _bindState.destroy();
+        RenderpassGL::_vertexShader.reset();
         _skybox.reset();
         _planeProgram.reset();
         _plane.reset();
-        _uniformsBuffer.reset();
+        _staticUniformsBuffer.reset();
+        _variableUniforms.destroy();
         for (int i = 0; i < 4; ++i) {
             for (int j = 0; j < 2; ++j) {
                 _bufferFramebuffers[i][j].reset();
@@ -709,7 +1034,8 @@ void Renderer::initTextureCache() {
         _keyboardState.resize(256 * 3);
         _keyboardState.fill(0);
         Context::Bound(TextureTarget::_2D, *cachedTexture.textures[0])
-            .Image2D(0, PixelDataInternalFormat::Red, 256, 3, 0, PixelDataFormat::Red, PixelDataType::UnsignedByte, nullptr);
+            .Image2D(0, PixelDataInternalFormat::Red, 256, 3, 0, PixelDataFormat::Red, PixelDataType::UnsignedByte, _keyboardState.constData());
+        _keyboardDirty = false;
     }
 
     //static void setOutput(Renderpass::Output output, bool even) {
@@ -731,63 +1057,180 @@ static float nsecsToSecs(uint64_t t) {
 
 void Renderer::updateUniforms() {
     using namespace oglplus;
-    static auto lastTimeNSecs = _shaderTimer.nsecsElapsed();
-    auto currentTimeNSecs = _shaderTimer.nsecsElapsed();
-    if (currentTimeNSecs < lastTimeNSecs) {
-        lastTimeNSecs = currentTimeNSecs;
+    int64_t currentTimeNSecs, deltaTimeNSecs;
+    if (_fixedTimestep > 0.0f) {
+        // Derived from the frame number rather than accumulated, so there's no drift
+        auto timestepNSecs = (int64_t)((double)_fixedTimestep * USECS_PER_SECOND * NSECS_PER_USEC);
+        currentTimeNSecs = _shaderFrame * timestepNSecs;
+        deltaTimeNSecs = _shaderFrame ? timestepNSecs : 0;
+    } else {
+        currentTimeNSecs = _shaderTimer.nsecsElapsed();
+        // The timer restarts along with the shader
+        if (!_shaderFrame || currentTimeNSecs < _lastFrameNSecs) {
+            _lastFrameNSecs = currentTimeNSecs;
+        }
+        deltaTimeNSecs = currentTimeNSecs - _lastFrameNSecs;
     }
-    auto deltaTimeNSecs = currentTimeNSecs - currentTimeNSecs;
-
+    _lastFrameNSecs = currentTimeNSecs;
+
+    auto& variable = *(ShadertoyVariableInputs*)_variableUniforms.next();
+    memset(&variable, 0, sizeof(ShadertoyVariableInputs));
+    variable.iTimeDelta = nsecsToSecs(deltaTimeNSecs);
+    variable.iGlobalTime = nsecsToSecs(currentTimeNSecs);
+    variable.iFrame = _shaderFrame;
+    variable.iMouse = _mouse;
+    _variableUniforms.bind(ShadertoyVariable);
+
+    // Only upload the blocks which actually changed
+    _staticUniformsBuffer->Bind(BufferTarget::Uniform);
     for (const auto& pass : currentShadertoy->passes) {
-        auto offset = pass.renderpass->output * _uboAlignment;
-        ShadertoyInputs& shadertoyInput = *(ShadertoyInputs*)(_shadertoyInputs.data() + offset);
+        ShadertoyStaticInputs staticInput;
+        memset(&staticInput, 0, sizeof(ShadertoyStaticInputs));
+        staticInput.iResolution = vec3(_eyeRenderResolution, 1);
+        staticInput.iSampleRate = SAMPLE_RATE;
         for (int i = 0; i < 4; ++i) {
-            shadertoyInput.iChannelResolution[i] = vec4(pass.inputs[i].resolution, 0.0f);
+            staticInput.iChannelResolution[i] = vec4(pass.inputs[i].resolution, 0.0f);
+        }
+        auto offset = pass.output * _staticStride;
+        auto current = _staticInputs.data() + offset;
+        if (memcmp(current, &staticInput, sizeof(ShadertoyStaticInputs))) {
+            memcpy(current, &staticInput, sizeof(ShadertoyStaticInputs));
+            glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(ShadertoyStaticInputs), current);
         }
-        shadertoyInput.iTimeDelta = nsecsToSecs(deltaTimeNSecs);
-        shadertoyInput.iGlobalTime = nsecsToSecs(currentTimeNSecs);
-        shadertoyInput.iFrame = _shaderFrame;
-        shadertoyInput.iMouse = _mouse;
-        shadertoyInput.iResolution = vec4(_eyeRenderResolution, 1, 0);
     }
-    _uniformsBuffer->Bind(BufferTarget::Uniform);
-    Buffer::Data(BufferTarget::Uniform, _shadertoyInputs.size(), _shadertoyInputs.data(), BufferUsage::StreamDraw);
 
-    auto& keyboardTexture = cachedTextures[KEYBOARD].textures[0];
-    Context::Bound(TextureTarget::_2D, *keyboardTexture)
-        .Image2D(0, PixelDataInternalFormat::Red, 256, 3, 0, PixelDataFormat::Red, PixelDataType::UnsignedByte, _keyboardState.data());
+    if (_keyboardDirty) {
+        auto& keyboardTexture = cachedTextures[KEYBOARD].textures[0];
+        glBindTexture(GL_TEXTURE_2D, GetName(*keyboardTexture));
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 3, GL_RED, GL_UNSIGNED_BYTE, _keyboardState.constData());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        _keyboardDirty = false;
+    }
+}
+
+void Renderer::bindStaticUniforms(Renderpass::Output output) {
+    _bindState.bindUniformRange(ShadertoyStatic, GetName(*_staticUniformsBuffer), output * _staticStride, sizeof(ShadertoyStaticInputs));
+}
+
+void Renderer::drawPass(const ProgramPtr& program) {
+    _bindState.useProgram(GetName(*program));
+    glUniformMatrix4fv(Projection, 1, GL_FALSE, &Stacks::projection().top()[0][0]);
+    glUniformMatrix4fv(ModelView, 1, GL_FALSE, &Stacks::modelview().top()[0][0]);
+    _skybox->Draw();
+    _bindState.count(3);
+}
+
+QVariantMap Renderer::bindStats() const {
+    const auto& stats = _bindState.getLastFrameStats();
+    QVariantMap result;
+    result["issued"] = stats.issued;
+    result["saved"] = stats.saved;
+    return result;
+}
+
+QVariantMap Renderer::programCacheStats() const {
+    const auto stats = ProgramCache::instance().getStats();
+    QVariantMap result;
+    result["hits"] = (qulonglong)stats.hits;
+    result["misses"] = (qulonglong)stats.misses;
+    result["evictions"] = (qulonglong)stats.evictions;
+    result["entries"] = (qulonglong)stats.entries;
+    result["bytes"] = (qulonglong)stats.bytes;
+    return result;
+}
+
+QVariantMap Renderer::presentStats(int windowSeconds) const {
+    if (_headlessCanvas) {
+        return QVariantMap();
+    }
+    return qApp->getActiveDisplayPlugin()->presentStats((uint32_t)std::max(windowSeconds, 1));
 }
 
 void Renderer::build() {
-    using namespace oglplus;
+    if (!_shader) {
+        return;
+    }
     try {
-        currentShadertoy = std::make_shared<ShaderGL>(ShaderGL::build(_shader));
-        if (!_skybox) {
-            const auto& passes = currentShadertoy->passes;
-            _skybox = loadSkybox(passes.begin()->program);
+        auto shadertoy = std::make_shared<ShaderGL>(ShaderGL::prepare(_shader));
+        _builder->queue(shadertoy);
+        _buildPending = true;
+    } catch (const std::runtime_error & err) {
+        qWarning() << err.what();
+        emit compileFailure(QString(err.what()));
+    }
+}
+
+bool Renderer::processBuildResults() {
+    ShaderBuilder::Result result;
+    if (!_builder->takeResult(result)) {
+        return false;
+    }
+    _buildPending = false;
+
+    if (!result.shader) {
+        qWarning() << result.error;
+        if (result.compileError) {
+            emit compileError(result.error);
+        } else {
+            emit compileFailure(result.error);
         }
+        return false;
+    }
 
-        for (auto& pass : currentShadertoy->passes) {
-            if (pass.renderpass->output != Renderpass::IMAGE) {
-                auto baseIndex = pass.renderpass->output - Renderpass::BUFFER_A;
-                // Use odd framebuffers as output on even frames
-                pass.outputs = _bufferFramebuffers[baseIndex];
-            } else {
-                pass.outputs[0] = pass.outputs[1] = _imageFramebuffer;
-            }
-            auto offset = pass.renderpass->output * _uboAlignment;
-            glBindBufferRange(GL_UNIFORM_BUFFER, 1, GetName(*_uniformsBuffer), offset, sizeof(ShadertoyInputs));
+    auto newShadertoy = result.shader;
+    if (!newShadertoy->shader) {
+        // Evicted from the cache while it was building, so nothing refers to it any more
+        return false;
+    }
+    try {
+        for (auto& pass : newShadertoy->passes) {
+            pass.setupInputs(_bindState);
         }
-        resize();
-        restart();
-        emit compileSuccess();
-    } catch (const ProgramBuildError & err) {
-        qWarning() << err.Log().c_str();
-        emit compileError(QString(err.Log().c_str()));
     } catch (const std::runtime_error & err) {
         qWarning() << err.what();
         emit compileFailure(QString(err.what()));
+        return false;
+    }
+
+    if (!_skybox) {
+        const auto& passes = newShadertoy->passes;
+        _skybox = loadSkybox(passes.begin()->program);
+    }
+
+    _compileTimes.clear();
+    for (auto& pass : newShadertoy->passes) {
+        if (pass.output != Renderpass::IMAGE) {
+            auto baseIndex = pass.output - Renderpass::BUFFER_A;
+            // Use odd framebuffers as output on even frames
+            pass.outputs = _bufferFramebuffers[baseIndex];
+        } else {
+            pass.outputs[0] = pass.outputs[1] = _imageFramebuffer;
+        }
+        _compileTimes.append((float)pass.compileTimeUsecs / USECS_PER_MSEC);
+    }
+
+    currentShadertoy = newShadertoy;
+    _governor.reset(_renderScale);
+    resize();
+    restart();
+    emit compileSuccess();
+    return true;
+}
+
+bool Renderer::waitForBuild() {
+    if (!_buildPending) {
+        return false;
     }
+    _builder->waitForResult();
+    return processBuildResults();
+}
+
+QVariantList Renderer::compileTimes() const {
+    return _compileTimes;
+}
+
+int Renderer::cancelledBuilds() const {
+    return _builder ? (int)_builder->cancelledBuilds() : 0;
 }
 
 void Renderer::setSize(const QSize& size) {
@@ -799,7 +1242,19 @@ void Renderer::setSize(const QSize& size) {
     }
 }
 
+void Renderer::setFixedTimestep(float seconds) {
+    _fixedTimestep = seconds;
+}
+
+void Renderer::setAdaptiveScale(bool enabled) {
+    if (enabled != _adaptiveScale) {
+        _adaptiveScale = enabled;
+        _governor.reset(_renderScale);
+    }
+}
+
 void Renderer::setScale(float scale) {
+    _governor.reset(scale);
     if (scale != _renderScale) {
         _renderScale = scale;
         _resolutionDirty = true;
@@ -818,6 +1273,9 @@ void Renderer::setShader(Shader* newShader) {
 }
 
 void Renderer::setShaderCode(Renderpass::Output output, const QString& code) {
+    if (!_shader) {
+        return;
+    }
     for (auto& pass : _shader->_renderpass) {
         if (pass && pass->output == output) {
             pass->code = code;
@@ -828,6 +1286,8 @@ void Renderer::setShaderCode(Renderpass::Output output, const QString& code) {
 void Renderer::keyPressed(int key) {
     switch (key) {
         case Qt::Key_F1:
+            qApp->saveTrace();
+            qApp->saveDisplayStats();
             break;
         case Qt::Key_F2:
             qApp->getActiveDisplayPlugin()->resetSensors();
@@ -848,12 +1308,17 @@ void Renderer::keyPressed(int key) {
         _keyboardState[key] = 255;
         _keyboardState[key + 256] = 255;
         _keyboardState[key + 512] = 255 - _keyboardState[key + 512];
+        _keyboardDirty = true;
     }
 }
 
 void Renderer::keyReleased(int key) {
-    _keyboardState[key] = 0;
-    _keyboardState[key + 256] = 0;
+    // Qt key codes for modifiers and function keys are well outside the texture
+    if (key >= 0 && key < 256) {
+        _keyboardState[key] = 0;
+        _keyboardState[key + 256] = 0;
+        _keyboardDirty = true;
+    }
 }
 
 static vec2 relativeMousePosition(const QPoint& point) {
@@ -20,16 +20,24 @@ limitations under the License.
 #pragma once
 #include <QtCore/QObject>
 #include <QtCore/QElapsedTimer>
+#include <QtCore/QVariant>
+#include <QtCore/QPointer>
 
 #include <gl/OglplusHelpers.h>
 #include <GLMHelpers.h>
 
 #include "Shadertoy.h"
+#include "PassTimer.h"
+#include "ScaleGovernor.h"
+#include "StateTracker.h"
+#include "UniformRing.h"
 #include "types/Input.h"
 #include "types/Shader.h"
 
+class OffscreenGLCanvas;
 
 namespace shadertoy {
+    class ShaderBuilder;
     using TexturePair = std::array<TexturePtr, 2>;
 
     class Renderer : public QObject {
@@ -58,6 +66,9 @@ namespace shadertoy {
 
     public:
         void setup(const glm::uvec2& size);
+        // Render into the image framebuffer only, without a window or display
+        // plugin, using the given context.  See OfflineRenderer.
+        void setupHeadless(const glm::uvec2& size, OffscreenGLCanvas* canvas);
         void render();
         Shader* shader();
         void setShader(Shader* newShader);
@@ -65,14 +76,61 @@ namespace shadertoy {
 
         void setSize(const QSize& size);
         void setScale(float scale);
+        // Continuously adjust the render scale to keep the GPU time of the
+        // shadertoy passes within the display's frame budget, see ScaleGovernor
+        Q_INVOKABLE void setAdaptiveScale(bool enabled);
+        // When non-zero, the shader clock advances by exactly this many seconds
+        // per frame instead of following wall time, so output is deterministic
+        void setFixedTimestep(float seconds);
+
+        // Blocks until the most recently queued build finishes and makes it
+        // current.  Returns false if it failed to build.
+        bool waitForBuild();
+
+        // Time each pass on the GPU, see PassTimer
+        void setPassTiming(bool enabled) { _passTiming = enabled; }
+        PassTimer& passTimer() { return _passTimer; }
+
+        const FramebufferPtr& imageFramebuffer() const { return _imageFramebuffer; }
+        const uvec2& renderResolution() const { return _renderResolution; }
+
+        // Per-pass compile (or program cache load) times for the current shader, in milliseconds
+        Q_INVOKABLE QVariantList compileTimes() const;
+        // Background builds dropped because a newer shader was queued before they finished
+        Q_INVOKABLE int cancelledBuilds() const;
+        // Hits, misses and evictions of the program binary cache since startup, and its current size
+        Q_INVOKABLE QVariantMap programCacheStats() const;
+        // GL binding calls made and saved in the last frame, see StateTracker
+        Q_INVOKABLE QVariantMap bindStats() const;
+        // Frame interval, latency, escrow depth and composite time percentiles from the display plugin
+        Q_INVOKABLE QVariantMap presentStats(int windowSeconds = 1) const;
 
     protected:
+        // Returns true if a newly built shader was made current
+        bool processBuildResults();
         void updateUniforms();
+        void bindStaticUniforms(Renderpass::Output output);
+        void drawPass(const ProgramPtr& program);
+        bool makeContextCurrent();
+        bool isHmd() const;
         void initTextureCache();
         void resize();
-
-        Shader* _shader{ nullptr };
+        void updateRenderScale();
+
+        // Shaders are owned by the cache, which may evict them
+        QPointer<Shader> _shader;
+        // Compiles new shaders in the background, see build()
+        ShaderBuilder* _builder { nullptr };
+        // A build has been queued and its result not yet collected
+        bool _buildPending { false };
+        QVariantList _compileTimes;
         QElapsedTimer _shaderTimer;
+        int64_t _lastFrameNSecs { 0 };
+        float _fixedTimestep { 0.0f };
+        bool _passTiming { false };
+        PassTimer _passTimer;
+        // Set for offline rendering, in which case there is no application window or display plugin
+        OffscreenGLCanvas* _headlessCanvas { nullptr };
 
         // The fragment shader used to render the shadertoy effect, as loaded
         // from a preset or created or edited by the user
@@ -86,8 +144,10 @@ namespace shadertoy {
 
         // The shadertoy rendering resolution scale.  1.0 means full resolution
         // as defined by the Oculus SDK as the ideal offscreen resolution
-        // pre-distortion
+        // pre-distortion.  This is the starting point when the scale is adaptive.
         float _renderScale { 0.5 };
+        bool _adaptiveScale { true };
+        ScaleGovernor _governor;
 
         float _hmdScale { 1.0 };
 
@@ -96,13 +156,18 @@ namespace shadertoy {
         // pre-distortion
         int32_t _shaderFrame { 0 };
         int32_t _uboAlignment { 0 };
+        int32_t _staticStride { 0 };
 
-        QByteArray _shadertoyInputs;
+        // Per pass uniforms, as last uploaded to _staticUniformsBuffer
+        QByteArray _staticInputs;
         QByteArray _keyboardState;
+        bool _keyboardDirty { true };
         vec4 _mouse { 0 };
 
-        // UBO container
-        BufferPtr _uniformsBuffer;
+        // UBO containers
+        BufferPtr _staticUniformsBuffer;
+        UniformRing _variableUniforms;
+        StateTracker _bindState;
         // Geometry for the skybox used to render the scene
         ShapeWrapperPtr _skybox;
 
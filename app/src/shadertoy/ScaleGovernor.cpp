@@ -0,0 +1,103 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "ScaleGovernor.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "PassTimer.h"
+
+using namespace shadertoy;
+
+const float ScaleGovernor::DEFAULT_MIN_SCALE = 0.25f;
+const float ScaleGovernor::DEFAULT_MAX_SCALE = 1.0f;
+const float ScaleGovernor::BUDGET_FRACTION = 0.8f;
+
+// Weight of each new sample in the moving average
+static const float AVERAGE_WEIGHT = 0.1f;
+// Hysteresis band around the budget
+static const float OVER_BUDGET = 1.05f;
+static const float UNDER_BUDGET = 0.75f;
+// Consecutive frames outside the band before acting
+static const int OVER_BUDGET_FRAMES = 5;
+static const int UNDER_BUDGET_FRAMES = 60;
+// Largest relative increase in a single step
+static const float MAX_INCREASE = 1.1f;
+static const float MIN_CHANGE = 0.05f;
+// Timing results lag the frames they measure
+static const int SETTLING_FRAMES = PassTimer::FRAME_DEPTH + 2;
+
+void ScaleGovernor::setTargetFrameRate(float framesPerSecond) {
+    if (framesPerSecond > 0.0f) {
+        _budgetMsecs = 1000.0f / framesPerSecond * BUDGET_FRACTION;
+    }
+}
+
+void ScaleGovernor::setBounds(float minScale, float maxScale) {
+    _minScale = std::min(minScale, maxScale);
+    _maxScale = std::max(minScale, maxScale);
+    _scale = std::min(std::max(_scale, _minScale), _maxScale);
+}
+
+void ScaleGovernor::reset(float scale) {
+    _scale = std::min(std::max(scale, _minScale), _maxScale);
+    _averageMsecs = 0.0f;
+    _samples = 0;
+    _overBudget = _underBudget = 0;
+    _settling = SETTLING_FRAMES;
+}
+
+bool ScaleGovernor::update(float gpuMsecs) {
+    if (_settling > 0) {
+        --_settling;
+        return false;
+    }
+
+    _averageMsecs = _samples++ ? _averageMsecs + (gpuMsecs - _averageMsecs) * AVERAGE_WEIGHT : gpuMsecs;
+    if (_averageMsecs > _budgetMsecs * OVER_BUDGET) {
+        ++_overBudget;
+        _underBudget = 0;
+    } else if (_averageMsecs < _budgetMsecs * UNDER_BUDGET) {
+        ++_underBudget;
+        _overBudget = 0;
+    } else {
+        _overBudget = _underBudget = 0;
+    }
+
+    float newScale = _scale;
+    if (_overBudget >= OVER_BUDGET_FRAMES) {
+        newScale = _scale * std::sqrt(_budgetMsecs / _averageMsecs);
+    } else if (_underBudget >= UNDER_BUDGET_FRAMES) {
+        newScale = _scale * std::min(std::sqrt(_budgetMsecs / std::max(_averageMsecs, 0.001f)), MAX_INCREASE);
+    } else {
+        return false;
+    }
+    newScale = std::min(std::max(newScale, _minScale), _maxScale);
+    _overBudget = _underBudget = 0;
+    // Small changes aren't worth reallocating for, unless they reach a bound
+    bool atBound = newScale == _minScale || newScale == _maxScale;
+    if (newScale == _scale || (std::abs(newScale - _scale) < MIN_CHANGE && !atBound)) {
+        return false;
+    }
+
+    // Average over the new scale from scratch
+    reset(newScale);
+    return true;
+}
@@ -0,0 +1,65 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#pragma once
+
+namespace shadertoy {
+
+    // Picks a render scale which keeps the GPU time of the shadertoy passes
+    // within a budget derived from the display's target frame rate.
+    //
+    // Cost is roughly proportional to the number of pixels, so the scale moves
+    // by the square root of the ratio of the budget to the measured time.  It
+    // drops quickly when frames run long, but only rises after a sustained
+    // period of headroom, and changes smaller than MIN_CHANGE are ignored so
+    // the buffers aren't reallocated for no visible benefit.
+    class ScaleGovernor {
+    public:
+        static const float DEFAULT_MIN_SCALE;
+        static const float DEFAULT_MAX_SCALE;
+        // Share of the frame period the shadertoy passes may use, leaving room
+        // for the UI, compositing and the display plugin
+        static const float BUDGET_FRACTION;
+
+        void setTargetFrameRate(float framesPerSecond);
+        void setBounds(float minScale, float maxScale);
+        // Start again from the given scale, e.g. when a new shader is loaded
+        void reset(float scale);
+
+        // Feed the GPU time of one frame at the current scale.  Returns true
+        // if the scale should change, in which case the new value is scale().
+        bool update(float gpuMsecs);
+        float scale() const { return _scale; }
+        float budgetMsecs() const { return _budgetMsecs; }
+        float averageMsecs() const { return _averageMsecs; }
+
+    private:
+        float _scale { 1.0f };
+        float _minScale { DEFAULT_MIN_SCALE };
+        float _maxScale { DEFAULT_MAX_SCALE };
+        float _budgetMsecs { 1000.0f / 60.0f * BUDGET_FRACTION };
+        float _averageMsecs { 0.0f };
+        int _samples { 0 };
+        int _overBudget { 0 };
+        int _underBudget { 0 };
+        // Frames to ignore after a change, while timings from the old scale drain
+        int _settling { 0 };
+    };
+
+}
@@ -0,0 +1,297 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "SearchIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+
+#include "Catalog.h"
+
+using namespace shadertoy;
+
+// Identifiers shorter than this are too common in shader code to be useful
+static const int MIN_CODE_TOKEN_LENGTH = 3;
+
+SearchIndex::Sort SearchIndex::toSort(const QString& sort) {
+    if (sort == "name") {
+        return NAME;
+    } else if (sort == "love") {
+        return LOVE;
+    } else if (sort == "newest") {
+        return NEWEST;
+    } else if (sort == "hot") {
+        return HOT;
+    }
+    return POPULAR;
+}
+
+uint8_t SearchIndex::toFeature(const QString& filter) {
+    if (filter == "vr") {
+        return VR;
+    } else if (filter == "soundoutput") {
+        return SOUND_OUTPUT;
+    } else if (filter == "soundinput") {
+        return SOUND_INPUT;
+    } else if (filter == "webcam") {
+        return WEBCAM;
+    } else if (filter == "multipass") {
+        return MULTIPASS;
+    } else if (filter == "musicstream") {
+        return MUSIC_STREAM;
+    }
+    return 0;
+}
+
+void SearchIndex::tokenize(const QString& text, std::vector<QByteArray>& tokens) {
+    const QString lower = text.toLower();
+    int start = -1;
+    for (int i = 0; i <= lower.size(); ++i) {
+        bool word = i < lower.size() && lower.at(i).isLetterOrNumber();
+        if (word && start < 0) {
+            start = i;
+        } else if (!word && start >= 0) {
+            tokens.push_back(lower.mid(start, i - start).toUtf8());
+            start = -1;
+        }
+    }
+}
+
+static void tokenizeCode(const QByteArray& code, std::vector<QByteArray>& tokens) {
+    int start = -1;
+    for (int i = 0; i <= code.size(); ++i) {
+        char c = i < code.size() ? code.at(i) : 0;
+        bool identifier = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (start >= 0 && c >= '0' && c <= '9');
+        if (identifier && start < 0) {
+            start = i;
+        } else if (!identifier && start >= 0) {
+            if (i - start >= MIN_CODE_TOKEN_LENGTH) {
+                tokens.push_back(code.mid(start, i - start).toLower());
+            }
+            start = -1;
+        }
+    }
+}
+
+static uint8_t detectFeatures(const QByteArray& json) {
+    // The catalog holds compact JSON, so the key/value pairs have no whitespace
+    uint8_t result = 0;
+    if (json.contains("mainVR")) {
+        result |= SearchIndex::VR;
+    }
+    if (json.contains("\"type\":\"sound\"")) {
+        result |= SearchIndex::SOUND_OUTPUT;
+    }
+    if (json.contains("\"ctype\":\"music\"") || json.contains("\"ctype\":\"mic\"")) {
+        result |= SearchIndex::SOUND_INPUT;
+    }
+    if (json.contains("\"ctype\":\"webcam\"")) {
+        result |= SearchIndex::WEBCAM;
+    }
+    if (json.contains("\"type\":\"buffer\"")) {
+        result |= SearchIndex::MULTIPASS;
+    }
+    if (json.contains("\"ctype\":\"musicstream\"")) {
+        result |= SearchIndex::MUSIC_STREAM;
+    }
+    return result;
+}
+
+void SearchIndex::build(const Catalog& catalog, bool indexCode) {
+    QElapsedTimer timer;
+    timer.start();
+
+    _catalog = &catalog;
+    const uint32_t count = catalog.size();
+    _features.assign(count, 0);
+    _tags.clear();
+    _postings.clear();
+
+    QHash<QByteArray, DocList> postings;
+    std::vector<QByteArray> tokens;
+    for (uint32_t doc = 0; doc < count; ++doc) {
+        tokens.clear();
+        tokenize(catalog.name(doc), tokens);
+        tokenize(catalog.description(doc), tokens);
+        tokenize(catalog.username(doc), tokens);
+        for (const auto& tag : catalog.tags(doc)) {
+            tokenize(tag, tokens);
+            auto& tagDocs = _tags[tag.toLower().toUtf8()];
+            if (tagDocs.empty() || tagDocs.back() != doc) {
+                tagDocs.push_back(doc);
+            }
+        }
+
+        auto json = catalog.shaderJson(doc);
+        _features[doc] = detectFeatures(json);
+        if (indexCode) {
+            tokenizeCode(json, tokens);
+        }
+
+        for (const auto& token : tokens) {
+            auto& docs = postings[token];
+            // Documents are visited in order, so this is enough to keep the lists unique
+            if (docs.empty() || docs.back() != doc) {
+                docs.push_back(doc);
+            }
+        }
+    }
+
+    _postings.reserve(postings.size());
+    for (auto itr = postings.begin(); itr != postings.end(); ++itr) {
+        _postings.push_back(Posting(itr.key(), DocList()));
+        _postings.back().second.swap(itr.value());
+    }
+    std::sort(_postings.begin(), _postings.end(), [](const Posting& a, const Posting& b) {
+        return a.first < b.first;
+    });
+
+    DocList all(count);
+    for (uint32_t doc = 0; doc < count; ++doc) {
+        all[doc] = doc;
+    }
+
+    uint32_t newest = 0;
+    for (uint32_t doc = 0; doc < count; ++doc) {
+        newest = std::max(newest, catalog.date(doc));
+    }
+    std::vector<float> hotness(count);
+    for (uint32_t doc = 0; doc < count; ++doc) {
+        // Likes, decayed with age relative to the newest shader in the catalog
+        float ageDays = (float)(newest - catalog.date(doc)) / (60.0f * 60.0f * 24.0f);
+        hotness[doc] = (float)catalog.likes(doc) / std::pow(ageDays + 2.0f, 1.5f);
+    }
+
+    std::vector<QString> names(count);
+    for (uint32_t doc = 0; doc < count; ++doc) {
+        names[doc] = catalog.name(doc).toLower();
+    }
+
+    for (int sort = 0; sort < SORT_COUNT; ++sort) {
+        _sorted[sort] = all;
+        auto& sorted = _sorted[sort];
+        switch (sort) {
+            case POPULAR:
+                std::stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) { return catalog.viewed(a) > catalog.viewed(b); });
+                break;
+            case NAME:
+                std::stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) { return names[a] < names[b]; });
+                break;
+            case LOVE:
+                std::stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) { return catalog.likes(a) > catalog.likes(b); });
+                break;
+            case NEWEST:
+                std::stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) { return catalog.date(a) > catalog.date(b); });
+                break;
+            case HOT:
+                std::stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) { return hotness[a] > hotness[b]; });
+                break;
+        }
+    }
+
+    _lastTerm.assign(count, 0);
+    _termHits.assign(count, 0);
+    _built = true;
+    qDebug() << "Built search index of" << _postings.size() << "tokens over" << count << "shaders in" << timer.elapsed() << "ms";
+}
+
+void SearchIndex::markPrefix(const QByteArray& prefix, uint16_t term) const {
+    auto itr = std::lower_bound(_postings.begin(), _postings.end(), prefix, [](const Posting& posting, const QByteArray& prefix) {
+        return posting.first < prefix;
+    });
+    for (; itr != _postings.end() && itr->first.startsWith(prefix); ++itr) {
+        for (auto doc : itr->second) {
+            // A document can match a term through several tokens, only count it once
+            if (_lastTerm[doc] != term) {
+                _lastTerm[doc] = term;
+                ++_termHits[doc];
+            }
+        }
+    }
+}
+
+SearchIndex::DocList SearchIndex::query(const QString& query, Sort sort, const QString& filter, int max) const {
+    DocList result;
+    if (!_built) {
+        return result;
+    }
+
+    std::vector<QByteArray> terms;
+    tokenize(query, terms);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+    uint8_t feature = 0;
+    const DocList* tagDocs = nullptr;
+    if (!filter.isEmpty() && filter != "none") {
+        feature = toFeature(filter);
+        if (!feature) {
+            auto itr = _tags.find(filter.toLower().toUtf8());
+            if (itr == _tags.end()) {
+                // Unknown tag, nothing can match
+                return result;
+            }
+            tagDocs = &itr.value();
+        }
+    }
+
+    uint16_t requiredHits = 0;
+    if (!terms.empty() || tagDocs) {
+        std::fill(_lastTerm.begin(), _lastTerm.end(), 0);
+        std::fill(_termHits.begin(), _termHits.end(), 0);
+        for (const auto& term : terms) {
+            markPrefix(term, ++requiredHits);
+        }
+        if (tagDocs) {
+            ++requiredHits;
+            for (auto doc : *tagDocs) {
+                ++_termHits[doc];
+            }
+        }
+    }
+
+    const auto& sorted = _sorted[sort];
+    const size_t limit = max > 0 ? (size_t)max : sorted.size();
+    for (auto doc : sorted) {
+        if (result.size() >= limit) {
+            break;
+        }
+        if (requiredHits && _termHits[doc] != requiredHits) {
+            continue;
+        }
+        if (feature && !(_features[doc] & feature)) {
+            continue;
+        }
+        result.push_back(doc);
+    }
+    return result;
+}
+
+QStringList SearchIndex::query(const QString& query, const QVariantMap& parameters) const {
+    auto docs = this->query(query, toSort(parameters["sort"].toString()), parameters["filter"].toString(), parameters["num"].toInt());
+    QStringList result;
+    result.reserve((int)docs.size());
+    for (auto doc : docs) {
+        result << _catalog->id(doc);
+    }
+    return result;
+}
@@ -0,0 +1,98 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVariantMap>
+
+namespace shadertoy {
+
+    class Catalog;
+
+    // Inverted index over the shader catalog.
+    //
+    // Tokens are taken from the name, description, username and tags of each
+    // shader (and optionally the identifiers in its code) and every term of a
+    // query is matched as a prefix.  Results can be restricted to a tag or to one
+    // of the shadertoy.com API filters, and are returned in one of the API sort
+    // orders, which are precomputed when the index is built.
+    class SearchIndex {
+    public:
+        using DocList = std::vector<uint32_t>;
+
+        enum Sort {
+            POPULAR = 0,
+            NAME,
+            LOVE,
+            NEWEST,
+            HOT,
+            SORT_COUNT,
+        };
+
+        // Properties derived from the shader code, matching the shadertoy.com API filters
+        enum Feature : uint8_t {
+            VR = 1 << 0,
+            SOUND_OUTPUT = 1 << 1,
+            SOUND_INPUT = 1 << 2,
+            WEBCAM = 1 << 3,
+            MULTIPASS = 1 << 4,
+            MUSIC_STREAM = 1 << 5,
+        };
+
+        static Sort toSort(const QString& sort);
+        static uint8_t toFeature(const QString& filter);
+
+        void build(const Catalog& catalog, bool indexCode = false);
+        bool isBuilt() const { return _built; }
+
+        // Parameters follow the shadertoy.com query API: 'sort', 'filter' and 'num'.
+        // A filter which isn't one of the API filters is treated as a tag.
+        QStringList query(const QString& query, const QVariantMap& parameters) const;
+        // Returns catalog indices
+        DocList query(const QString& query, Sort sort, const QString& filter, int max) const;
+
+    private:
+        using Posting = std::pair<QByteArray, DocList>;
+
+        static void tokenize(const QString& text, std::vector<QByteArray>& tokens);
+        // Mark every document containing a token starting with the prefix
+        void markPrefix(const QByteArray& prefix, uint16_t term) const;
+
+        const Catalog* _catalog { nullptr };
+        bool _built { false };
+        // Sorted by token, for prefix lookups
+        std::vector<Posting> _postings;
+        QHash<QByteArray, DocList> _tags;
+        std::vector<uint8_t> _features;
+        DocList _sorted[SORT_COUNT];
+
+        // Per query scratch space, sized to the document count
+        mutable std::vector<uint16_t> _lastTerm;
+        mutable std::vector<uint16_t> _termHits;
+    };
+
+}
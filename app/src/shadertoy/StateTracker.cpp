@@ -0,0 +1,153 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "StateTracker.h"
+
+#include <QtCore/QtGlobal>
+
+using namespace shadertoy;
+
+// Nothing is ever bound under this name, so it forces the first real bind through
+static const GLuint UNKNOWN = ~0u;
+
+StateTracker::~StateTracker() {
+    Q_ASSERT(_samplers.isEmpty());
+}
+
+GLuint StateTracker::getSampler(GLenum wrap, GLenum minFilter, GLenum magFilter) {
+    const quint64 key = ((quint64)wrap << 32) | ((quint64)minFilter << 16) | (quint64)magFilter;
+    auto itr = _samplers.find(key);
+    if (itr != _samplers.end()) {
+        return itr.value();
+    }
+
+    GLuint sampler = 0;
+    glGenSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrap);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrap);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, wrap);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, minFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, magFilter);
+    _samplers.insert(key, sampler);
+    return sampler;
+}
+
+bool StateTracker::track(bool changed) {
+    if (changed) {
+        ++_current.issued;
+    } else {
+        ++_current.saved;
+    }
+    return changed;
+}
+
+void StateTracker::activeTexture(GLuint unit) {
+    if (track(unit != _activeUnit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        _activeUnit = unit;
+    }
+}
+
+void StateTracker::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    Q_ASSERT(unit < MAX_UNITS);
+    auto& bound = _textures[unit][target == GL_TEXTURE_CUBE_MAP ? 1 : 0];
+    if (bound == texture) {
+        // Neither the unit switch nor the bind are needed
+        _current.saved += 2;
+        return;
+    }
+    activeTexture(unit);
+    track(true);
+    glBindTexture(target, texture);
+    bound = texture;
+}
+
+void StateTracker::bindSampler(GLuint unit, GLuint sampler) {
+    Q_ASSERT(unit < MAX_UNITS);
+    if (track(_boundSamplers[unit] != sampler)) {
+        glBindSampler(unit, sampler);
+        _boundSamplers[unit] = sampler;
+    }
+}
+
+void StateTracker::useProgram(GLuint program) {
+    if (track(_program != program)) {
+        glUseProgram(program);
+        _program = program;
+    }
+}
+
+void StateTracker::bindDrawFramebuffer(GLuint framebuffer) {
+    if (track(_drawFramebuffer != framebuffer)) {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        _drawFramebuffer = framebuffer;
+    }
+}
+
+void StateTracker::bindUniformRange(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    Q_ASSERT(binding < MAX_UNIFORM_BINDINGS);
+    auto& range = _uniformRanges[binding];
+    if (track(range.buffer != buffer || range.offset != offset || range.size != size)) {
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+        range.buffer = buffer;
+        range.offset = offset;
+        range.size = size;
+    }
+}
+
+void StateTracker::invalidate() {
+    _activeUnit = UNKNOWN;
+    for (int unit = 0; unit < MAX_UNITS; ++unit) {
+        for (int target = 0; target < TARGETS; ++target) {
+            _textures[unit][target] = UNKNOWN;
+        }
+        _boundSamplers[unit] = UNKNOWN;
+    }
+    _program = UNKNOWN;
+    _drawFramebuffer = UNKNOWN;
+    for (auto& range : _uniformRanges) {
+        range.buffer = UNKNOWN;
+    }
+}
+
+void StateTracker::beginFrame() {
+    invalidate();
+    _current = Stats();
+}
+
+void StateTracker::endFrame() {
+    for (GLuint unit = 0; unit < MAX_UNITS; ++unit) {
+        if (_boundSamplers[unit] != 0 && _boundSamplers[unit] != UNKNOWN) {
+            glBindSampler(unit, 0);
+            ++_current.issued;
+        }
+    }
+    glUseProgram(0);
+    glActiveTexture(GL_TEXTURE0);
+    _current.issued += 2;
+    _last = _current;
+    invalidate();
+}
+
+void StateTracker::destroy() {
+    for (auto sampler : _samplers) {
+        glDeleteSamplers(1, &sampler);
+    }
+    _samplers.clear();
+}
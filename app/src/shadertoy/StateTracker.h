@@ -0,0 +1,99 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <QtCore/QHash>
+
+#include <gl/Config.h>
+
+namespace shadertoy {
+
+    // Remembers the GL bindings made while rendering the shadertoy passes and
+    // skips the ones which wouldn't change anything, which is most of them,
+    // since consecutive passes and eyes share programs, framebuffers and inputs.
+    //
+    // Texture wrap and filter modes come from sampler objects, one per unique
+    // combination, rather than being set on the texture at every bind.
+    //
+    // Other code shares the context between frames, so beginFrame() forgets
+    // everything and endFrame() unbinds the samplers and program again.
+    class StateTracker {
+    public:
+        static const int MAX_UNITS = 4;
+        static const int MAX_UNIFORM_BINDINGS = 4;
+
+        struct Stats {
+            uint32_t issued { 0 };
+            // Redundant calls the tracker skipped
+            uint32_t saved { 0 };
+        };
+
+        ~StateTracker();
+
+        // Created on first use
+        GLuint getSampler(GLenum wrap, GLenum minFilter, GLenum magFilter);
+
+        void bindTexture(GLuint unit, GLenum target, GLuint texture);
+        void bindSampler(GLuint unit, GLuint sampler);
+        void useProgram(GLuint program);
+        void bindDrawFramebuffer(GLuint framebuffer);
+        void bindUniformRange(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size);
+        // Account for calls made outside of the tracker
+        void count(uint32_t issued) {
+            _current.issued += issued;
+        }
+
+        void beginFrame();
+        void endFrame();
+        const Stats& getLastFrameStats() const { return _last; }
+
+        void destroy();
+
+    private:
+        // 2D and cube map
+        static const int TARGETS = 2;
+
+        struct UniformRange {
+            GLuint buffer { 0 };
+            GLintptr offset { 0 };
+            GLsizeiptr size { 0 };
+        };
+
+        void invalidate();
+        // Returns false if the call can be skipped
+        bool track(bool changed);
+        void activeTexture(GLuint unit);
+
+        QHash<quint64, GLuint> _samplers;
+
+        GLuint _activeUnit { 0 };
+        GLuint _textures[MAX_UNITS][TARGETS];
+        GLuint _boundSamplers[MAX_UNITS];
+        GLuint _program { 0 };
+        GLuint _drawFramebuffer { 0 };
+        UniformRange _uniformRanges[MAX_UNIFORM_BINDINGS];
+
+        Stats _current;
+        Stats _last;
+    };
+
+}
@@ -0,0 +1,116 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "UniformRing.h"
+
+#include <QtCore/QDebug>
+
+using namespace shadertoy;
+
+static const GLuint64 FENCE_TIMEOUT_NSECS = 1000 * 1000 * 1000;
+
+UniformRing::~UniformRing() {
+    Q_ASSERT(!_buffer);
+}
+
+void UniformRing::create(size_t blockSize, GLint alignment) {
+    destroy();
+    _blockSize = blockSize;
+    _stride = alignment > 0 ? ((blockSize + alignment - 1) / alignment) * alignment : blockSize;
+    const GLsizeiptr size = _stride * DEPTH;
+
+    glGenBuffers(1, &_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, _buffer);
+    _persistent = GLEW_ARB_buffer_storage != 0;
+    if (_persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+        _mapped = (uint8_t*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags);
+        if (!_mapped) {
+            qWarning() << "Unable to persistently map the uniform ring, falling back to buffer updates";
+            glDeleteBuffers(1, &_buffer);
+            glGenBuffers(1, &_buffer);
+            glBindBuffer(GL_UNIFORM_BUFFER, _buffer);
+            _persistent = false;
+        }
+    }
+    if (!_persistent) {
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+        _staging.resize((int)_blockSize);
+        _staging.fill(0);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformRing::destroy() {
+    for (auto& fence : _fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (_buffer) {
+        if (_mapped) {
+            glBindBuffer(GL_UNIFORM_BUFFER, _buffer);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            _mapped = nullptr;
+        }
+        glDeleteBuffers(1, &_buffer);
+        _buffer = 0;
+    }
+    _slot = -1;
+}
+
+void* UniformRing::next() {
+    _slot = (_slot + 1) % DEPTH;
+    auto& fence = _fences[_slot];
+    if (fence) {
+        auto status = glClientWaitSync(fence, 0, 0);
+        if (GL_TIMEOUT_EXPIRED == status) {
+            ++_stalls;
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NSECS);
+        }
+        if (GL_WAIT_FAILED == status) {
+            qWarning() << "Failed waiting for uniform ring slot" << _slot;
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (_persistent) {
+        return _mapped + _slot * _stride;
+    }
+    return _staging.data();
+}
+
+void UniformRing::bind(GLuint binding) {
+    const GLintptr offset = _slot * _stride;
+    if (!_persistent) {
+        glBindBuffer(GL_UNIFORM_BUFFER, _buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, _blockSize, _staging.constData());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, _buffer, offset, _blockSize);
+}
+
+void UniformRing::fence() {
+    if (_slot >= 0 && !_fences[_slot]) {
+        _fences[_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
@@ -0,0 +1,71 @@
+/************************************************************************************
+
+Authors     :   Bradley Austin Davis <bdavis@saintandreas.org>
+Copyright   :   Copyright Bradley Austin Davis. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <QtCore/QByteArray>
+
+#include <gl/Config.h>
+
+namespace shadertoy {
+
+    // Uniform block storage which is rewritten every frame.
+    //
+    // The buffer holds DEPTH copies of the block and is persistently mapped, so
+    // a frame's values are written straight into memory the GPU reads from.  A
+    // fence after each frame's draws guards the copy against being overwritten
+    // while still in use; with three copies the CPU should never have to wait.
+    // Without ARB_buffer_storage the same ring is filled with glBufferSubData.
+    // All calls must be made with the rendering context current.
+    class UniformRing {
+    public:
+        static const int DEPTH = 3;
+
+        ~UniformRing();
+
+        void create(size_t blockSize, GLint alignment);
+        void destroy();
+
+        // Returns storage for the next frame's block, waiting if the GPU is still reading it
+        void* next();
+        // Make the block written since next() current at the given binding
+        void bind(GLuint binding);
+        // Call once the draws using the block have been issued
+        void fence();
+
+        bool isPersistent() const { return _persistent; }
+        // Number of times next() had to wait for the GPU
+        uint64_t getStalls() const { return _stalls; }
+
+    private:
+        GLuint _buffer { 0 };
+        bool _persistent { false };
+        uint8_t* _mapped { nullptr };
+        // Staging for the fallback path
+        QByteArray _staging;
+        size_t _blockSize { 0 };
+        size_t _stride { 0 };
+        int _slot { -1 };
+        GLsync _fences[DEPTH] {};
+        uint64_t _stalls { 0 };
+    };
+
+}
@@ -0,0 +1,57 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "ChannelState.h"
+
+#include <algorithm>
+
+using namespace controller;
+
+const uint16_t ChannelTable::INVALID_SLOT;
+
+void ChannelTable::build(const Input::NamedVector& inputs) {
+    for (int i = 0; i < TYPE_COUNT; ++i) {
+        _slots[i].clear();
+        _counts[i] = 0;
+    }
+    for (const auto& namedInput : inputs) {
+        const auto& input = namedInput.first;
+        int index = typeIndex(input.getType());
+        if (index < 0) {
+            continue;
+        }
+        auto& slots = _slots[index];
+        auto channel = input.getChannel();
+        if (channel >= slots.size()) {
+            slots.resize(channel + 1, INVALID_SLOT);
+        }
+        // Aliases share the slot of the first name
+        if (slots[channel] == INVALID_SLOT) {
+            slots[channel] = _counts[index]++;
+        }
+    }
+}
+
+void ChannelState::resize(const ChannelTable& table) {
+    buttons.assign(table.count(ChannelType::BUTTON), 0.0f);
+    axes.assign(table.count(ChannelType::AXIS), 0.0f);
+    poses.assign(table.count(ChannelType::POSE), Pose());
+}
+
+void ChannelState::clear() {
+    std::fill(buttons.begin(), buttons.end(), 0.0f);
+    std::fill(axes.begin(), axes.end(), 0.0f);
+    std::fill(poses.begin(), poses.end(), Pose());
+}
+
+void ChannelState::copyFrom(const ChannelState& other) {
+    std::copy(other.buttons.begin(), other.buttons.end(), buttons.begin());
+    std::copy(other.axes.begin(), other.axes.end(), axes.begin());
+    std::copy(other.poses.begin(), other.poses.end(), poses.begin());
+    timestamp = other.timestamp;
+}
@@ -0,0 +1,73 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_controllers_ChannelState_h
+#define hifi_controllers_ChannelState_h
+
+#include <stdint.h>
+#include <vector>
+
+#include "Input.h"
+#include "Pose.h"
+
+namespace controller {
+
+    // Maps each channel a device exposes to a dense slot, per channel type
+    class ChannelTable {
+    public:
+        static const uint16_t INVALID_SLOT = 0xFFFF;
+
+        void build(const Input::NamedVector& inputs);
+
+        uint16_t slot(ChannelType type, uint16_t channel) const {
+            int index = typeIndex(type);
+            if (index < 0 || channel >= _slots[index].size()) {
+                return INVALID_SLOT;
+            }
+            return _slots[index][channel];
+        }
+
+        uint16_t count(ChannelType type) const {
+            int index = typeIndex(type);
+            return index < 0 ? 0 : _counts[index];
+        }
+
+    private:
+        static const int TYPE_COUNT = 3;
+
+        static int typeIndex(ChannelType type) {
+            switch (type) {
+                case ChannelType::BUTTON: return 0;
+                case ChannelType::AXIS: return 1;
+                case ChannelType::POSE: return 2;
+                default: return -1;
+            }
+        }
+
+        std::vector<uint16_t> _slots[TYPE_COUNT];
+        uint16_t _counts[TYPE_COUNT] { 0, 0, 0 };
+    };
+
+    // The value of every channel of a device, laid out by the slots of its channel table
+    struct ChannelState {
+        std::vector<float> buttons;
+        std::vector<float> axes;
+        std::vector<Pose> poses;
+        // When the state was published, in usecs
+        uint64_t timestamp { 0 };
+
+        void resize(const ChannelTable& table);
+        void clear();
+        // Copies without reallocating, the states must share a table
+        void copyFrom(const ChannelState& other);
+    };
+
+}
+
+#endif
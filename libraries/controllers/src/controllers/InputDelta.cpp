@@ -0,0 +1,108 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "InputDelta.h"
+
+#include <atomic>
+
+using namespace controller;
+
+static int inputDeltaMetaTypeId = qRegisterMetaType<InputDelta::Pointer>();
+
+static void select(std::vector<bool>& selected, Action action) {
+    if (selected.empty()) {
+        selected.resize(toInt(Action::NUM_ACTIONS), false);
+    }
+    if (toInt(action) < toInt(Action::NUM_ACTIONS)) {
+        selected[toInt(action)] = true;
+    }
+}
+
+static bool isSelected(const std::vector<bool>& selected, uint32_t id) {
+    return id < selected.size() && selected[id];
+}
+
+void InputDelta::clear() {
+    frame = 0;
+    actions.clear();
+    poses.clear();
+    inputs.clear();
+    inputPoses.clear();
+}
+
+std::shared_ptr<InputDelta> InputDeltaPool::acquire() {
+    for (const auto& delta : _deltas) {
+        // Only the pool holds it, and only this thread can hand out new references
+        if (delta.use_count() == 1) {
+            // Pairs with the release of the last receiver's reference
+            std::atomic_thread_fence(std::memory_order_acquire);
+            delta->clear();
+            return delta;
+        }
+    }
+    auto result = std::make_shared<InputDelta>();
+    if (_deltas.size() < MAX_POOLED) {
+        _deltas.push_back(result);
+    }
+    return result;
+}
+
+InputDeltaFilter& InputDeltaFilter::action(Action action) {
+    select(_actions, action);
+    return *this;
+}
+
+InputDeltaFilter& InputDeltaFilter::pose(Action action) {
+    select(_poses, action);
+    return *this;
+}
+
+InputDeltaFilter& InputDeltaFilter::input(const Input& input) {
+    _inputs.insert(input.getID());
+    return *this;
+}
+
+InputDeltaFilter& InputDeltaFilter::allActions() {
+    _allActions = true;
+    return *this;
+}
+
+InputDeltaFilter& InputDeltaFilter::allPoses() {
+    _allPoses = true;
+    return *this;
+}
+
+InputDeltaFilter& InputDeltaFilter::allInputs() {
+    _allInputs = true;
+    return *this;
+}
+
+bool InputDeltaFilter::apply(const InputDelta& delta, InputDelta& result) const {
+    result.frame = delta.frame;
+    for (const auto& change : delta.actions) {
+        if (_allActions || isSelected(_actions, change.id)) {
+            result.actions.push_back(change);
+        }
+    }
+    for (const auto& change : delta.poses) {
+        if (_allPoses || isSelected(_poses, change.id)) {
+            result.poses.push_back(change);
+        }
+    }
+    for (const auto& change : delta.inputs) {
+        if (_allInputs || _inputs.count(change.id)) {
+            result.inputs.push_back(change);
+        }
+    }
+    for (const auto& change : delta.inputPoses) {
+        if (_allInputs || _inputs.count(change.id)) {
+            result.inputPoses.push_back(change);
+        }
+    }
+    return !result.empty();
+}
@@ -0,0 +1,111 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_controllers_InputDelta_h
+#define hifi_controllers_InputDelta_h
+
+#include <stdint.h>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include <QtCore/QObject>
+
+#include "Actions.h"
+#include "Input.h"
+#include "Pose.h"
+
+namespace controller {
+
+    // The channels which changed during one UserInputMapper::update()
+    struct InputDelta {
+        using Pointer = std::shared_ptr<const InputDelta>;
+
+        struct ValueChange {
+            uint32_t id;
+            float value;
+        };
+
+        struct PoseChange {
+            uint32_t id;
+            Pose pose;
+        };
+
+        uint64_t frame { 0 };
+        // Ids are the action index
+        std::vector<ValueChange> actions;
+        std::vector<PoseChange> poses;
+        // Ids are the standard input id
+        std::vector<ValueChange> inputs;
+        std::vector<PoseChange> inputPoses;
+
+        bool empty() const { return actions.empty() && poses.empty() && inputs.empty() && inputPoses.empty(); }
+        // Keeps the capacity, for reuse
+        void clear();
+    };
+
+    // Hands out deltas for the publishing thread to fill, recycling each one once
+    // every receiver has released it, so that publishing stops allocating once
+    // the pool and its vectors have grown to their working size.
+    class InputDeltaPool {
+    public:
+        // Deltas beyond this many in flight are allocated and freed as usual
+        static const size_t MAX_POOLED = 32;
+
+        std::shared_ptr<InputDelta> acquire();
+
+    private:
+        std::vector<std::shared_ptr<InputDelta>> _deltas;
+    };
+
+    // Selects the channels a subscription receives, which is nothing by default
+    class InputDeltaFilter {
+    public:
+        InputDeltaFilter& action(Action action);
+        InputDeltaFilter& pose(Action action);
+        InputDeltaFilter& input(const Input& input);
+        InputDeltaFilter& allActions();
+        InputDeltaFilter& allPoses();
+        InputDeltaFilter& allInputs();
+
+        // Returns false if none of the changes pass
+        bool apply(const InputDelta& delta, InputDelta& result) const;
+
+    private:
+        std::vector<bool> _actions;
+        std::vector<bool> _poses;
+        std::unordered_set<uint32_t> _inputs;
+        bool _allActions { false };
+        bool _allPoses { false };
+        bool _allInputs { false };
+    };
+
+    // Delivers the changes selected by its filter once per update, and only for
+    // updates where something it selects changed.  Connect to changed() with any
+    // connection type, the delta is shared rather than copied between receivers.
+    class InputSubscription : public QObject {
+        Q_OBJECT
+    public:
+        using Pointer = std::shared_ptr<InputSubscription>;
+
+        InputSubscription(const InputDeltaFilter& filter) : _filter(filter) {}
+        const InputDeltaFilter& getFilter() const { return _filter; }
+
+    signals:
+        void changed(controller::InputDelta::Pointer delta);
+
+    private:
+        const InputDeltaFilter _filter;
+    };
+
+}
+
+Q_DECLARE_METATYPE(controller::InputDelta::Pointer)
+
+#endif
@@ -10,6 +10,10 @@
 //
 #include "InputDevice.h"
 
+#include <algorithm>
+
+#include <SharedUtil.h>
+
 #include "Input.h"
 #include "impl/endpoints/InputEndpoint.h"
 
@@ -31,33 +35,103 @@ namespace controller {
         return InputDevice::_reticleMoveSpeed * RANGE_MULT + MIN_PIXEL_RANGE_MULT;
     }
 
+    const uint8_t InputDevice::STATE_BUFFERS;
+    const uint8_t InputDevice::STATE_INDEX_MASK;
+    const uint8_t InputDevice::FRESH_STATE;
+
     float InputDevice::getButton(int channel) const {
-        if (!_buttonPressedMap.empty()) {
-            if (_buttonPressedMap.find(channel) != _buttonPressedMap.end()) {
-                return 1.0f;
-            } else {
-                return 0.0f;
-            }
+        auto slot = _channels.slot(ChannelType::BUTTON, channel);
+        if (slot == ChannelTable::INVALID_SLOT) {
+            return 0.0f;
         }
-        return 0.0f;
+        return _states[_frontState].buttons[slot];
     }
 
     float InputDevice::getAxis(int channel) const {
-        auto axis = _axisStateMap.find(channel);
-        if (axis != _axisStateMap.end()) {
-            return (*axis).second;
-        } else {
+        auto slot = _channels.slot(ChannelType::AXIS, channel);
+        if (slot == ChannelTable::INVALID_SLOT) {
             return 0.0f;
         }
+        return _states[_frontState].axes[slot];
     }
 
     Pose InputDevice::getPose(int channel) const {
-        auto pose = _poseStateMap.find(channel);
-        if (pose != _poseStateMap.end()) {
-            return (*pose).second;
-        } else {
+        auto slot = _channels.slot(ChannelType::POSE, channel);
+        if (slot == ChannelTable::INVALID_SLOT) {
             return Pose();
         }
+        return _states[_frontState].poses[slot];
+    }
+
+    void InputDevice::setButton(int channel, bool pressed) {
+        auto slot = _channels.slot(ChannelType::BUTTON, channel);
+        if (slot != ChannelTable::INVALID_SLOT) {
+            _pendingState.buttons[slot] = pressed ? 1.0f : 0.0f;
+        }
+    }
+
+    void InputDevice::setAxis(int channel, float value) {
+        auto slot = _channels.slot(ChannelType::AXIS, channel);
+        if (slot != ChannelTable::INVALID_SLOT) {
+            _pendingState.axes[slot] = value;
+        }
+    }
+
+    void InputDevice::setPose(int channel, const Pose& value) {
+        auto slot = _channels.slot(ChannelType::POSE, channel);
+        if (slot != ChannelTable::INVALID_SLOT) {
+            _pendingState.poses[slot] = value;
+        }
+    }
+
+    void InputDevice::clearButtons() {
+        std::fill(_pendingState.buttons.begin(), _pendingState.buttons.end(), 0.0f);
+    }
+
+    void InputDevice::clearAxes() {
+        std::fill(_pendingState.axes.begin(), _pendingState.axes.end(), 0.0f);
+    }
+
+    void InputDevice::clearPoses() {
+        std::fill(_pendingState.poses.begin(), _pendingState.poses.end(), Pose());
+    }
+
+    Pose InputDevice::getPendingPose(int channel) const {
+        auto slot = _channels.slot(ChannelType::POSE, channel);
+        if (slot == ChannelTable::INVALID_SLOT) {
+            return Pose();
+        }
+        return _pendingState.poses[slot];
+    }
+
+    void InputDevice::setPendingState(const ChannelState& state) {
+        _pendingState.copyFrom(state);
+    }
+
+    void InputDevice::publishState() {
+        _pendingState.timestamp = usecTimestampNow();
+        _states[_backState].copyFrom(_pendingState);
+        _backState = _sharedState.exchange(_backState | FRESH_STATE, std::memory_order_acq_rel) & STATE_INDEX_MASK;
+    }
+
+    bool InputDevice::latchState() {
+        if (!(_sharedState.load(std::memory_order_relaxed) & FRESH_STATE)) {
+            return false;
+        }
+        _frontState = _sharedState.exchange(_frontState, std::memory_order_acq_rel) & STATE_INDEX_MASK;
+        return true;
+    }
+
+    void InputDevice::buildChannelTable() {
+        if (_channelsBuilt) {
+            return;
+        }
+        _channelsBuilt = true;
+        _channels.build(getAvailableInputs());
+        _pendingState.resize(_channels);
+        for (auto& state : _states) {
+            state.resize(_channels);
+        }
     }
 
     Input InputDevice::makeInput(controller::StandardButtonChannel button) const {
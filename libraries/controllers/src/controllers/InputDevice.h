@@ -10,14 +10,14 @@
 //
 #pragma once
 
+#include <atomic>
 #include <memory>
-#include <map>
-#include <unordered_set>
 
 #include <QtCore/QString>
 
 #include "Pose.h"
 #include "Input.h"
+#include "ChannelState.h"
 #include "StandardControls.h"
 #include "DeviceProxy.h"
 
@@ -40,11 +40,7 @@ public:
 
     using Pointer = std::shared_ptr<InputDevice>;
 
-    typedef std::unordered_set<int> ButtonPressedMap;
-    typedef std::map<int, float> AxisStateMap;
-    typedef std::map<int, Pose> PoseStateMap;
-
-    // Get current state for each channel
+    // Get current state for each channel, as of the last snapshot taken by the mapper
     float getButton(int channel) const;
     float getAxis(int channel) const;
     Pose getPose(int channel) const;
@@ -52,6 +48,8 @@ public:
     float getValue(const Input& input) const;
     float getValue(ChannelType channelType, uint16_t channel) const;
     Pose getPoseValue(uint16_t channel) const;
+    // When the current state was published by the device, in usecs
+    uint64_t getSampleTime() const { return _states[_frontState].timestamp; }
 
     const QString& getName() const { return _name; }
 
@@ -81,23 +79,61 @@ public slots:
 
 protected:
     friend class UserInputMapper;
+    friend class InputRecorder;
 
     virtual Input::NamedVector getAvailableInputs() const = 0;
     virtual QStringList getDefaultMappingConfigs() const { return QStringList() << getDefaultMappingConfig(); }
     virtual QString getDefaultMappingConfig() const { return QString(); }
     virtual EndpointPointer createEndpoint(const Input& input) const;
 
+    // Channel state is written by the device and only becomes visible to the mapper
+    // once published.  Writes to channels missing from getAvailableInputs() are dropped.
+    void setButton(int channel, bool pressed);
+    void setAxis(int channel, float value);
+    void setPose(int channel, const Pose& value);
+    void clearButtons();
+    void clearAxes();
+    void clearPoses();
+    // The pose written since the last publish
+    Pose getPendingPose(int channel) const;
+    // Replaces every pending channel value, the state must be laid out by the device's channel table
+    void setPendingState(const ChannelState& state);
+    // Publishes the pending state, stamped with the current time.  Devices polled
+    // by the input sampler publish from its thread, the mapper takes the latest.
+    void publishState();
+    // Called by the mapper on registration, before the device starts writing.  Devices
+    // whose inputs are known on construction can call it then, to take state before
+    // they're registered.  The table only depends on the channels, not the device ID,
+    // so it's built once: a device which is removed and registered again may still be
+    // writing its state from the input sampler thread.
+    void buildChannelTable();
+
     uint16_t _deviceID { Input::INVALID_DEVICE };
 
     const QString _name;
 
-    ButtonPressedMap _buttonPressedMap;
-    AxisStateMap _axisStateMap;
-    PoseStateMap _poseStateMap;
-
     static bool _lowVelocityFilter;
 
 private:
+    // Called by the mapper before reading the device, returns true if the snapshot changed
+    bool latchState();
+
+    static const uint8_t STATE_BUFFERS = 3;
+    static const uint8_t STATE_INDEX_MASK = 0x3;
+    static const uint8_t FRESH_STATE = 0x4;
+
+    ChannelTable _channels;
+    bool _channelsBuilt { false };
+    ChannelState _pendingState;
+    // Triple buffered so neither side ever waits: the device copies its pending
+    // state into the back buffer and swaps it with the shared one, while the
+    // mapper swaps the shared buffer for its front buffer when a fresh one is
+    // available.
+    ChannelState _states[STATE_BUFFERS];
+    uint8_t _backState { 0 };
+    std::atomic<uint8_t> _sharedState { 1 };
+    uint8_t _frontState { 2 };
+
     static float _reticleMoveSpeed;
 };
 
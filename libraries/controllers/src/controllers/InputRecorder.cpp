@@ -0,0 +1,205 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "InputRecorder.h"
+
+#include <thread>
+
+#include <StreamUtils.h>
+
+#include "Logging.h"
+
+using namespace controller;
+
+const quint32 InputRecorder::MAGIC = 0x52495148; // "HQIR"
+const quint32 InputRecorder::VERSION = 1;
+
+static void prepareStream(QDataStream& stream) {
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+}
+
+static void writeState(QDataStream& stream, const ChannelState& state) {
+    for (auto value : state.buttons) {
+        stream << value;
+    }
+    for (auto value : state.axes) {
+        stream << value;
+    }
+    for (const auto& pose : state.poses) {
+        stream << (quint8)(pose.valid ? 1 : 0) << pose.translation << pose.rotation << pose.velocity << pose.angularVelocity;
+    }
+}
+
+static void readState(QDataStream& stream, ChannelState& state) {
+    for (auto& value : state.buttons) {
+        stream >> value;
+    }
+    for (auto& value : state.axes) {
+        stream >> value;
+    }
+    for (auto& pose : state.poses) {
+        quint8 valid;
+        stream >> valid >> pose.translation >> pose.rotation >> pose.velocity >> pose.angularVelocity;
+        pose.valid = valid != 0;
+    }
+}
+
+InputRecorder::InputRecorder(const std::vector<InputDevice::Pointer>& devices) {
+    for (const auto& device : devices) {
+        RecordedDevice recorded;
+        recorded.device = device;
+        recorded.cleared.resize(device->_channels);
+        _devices.push_back(recorded);
+    }
+}
+
+InputRecorder::~InputRecorder() {
+    close();
+}
+
+bool InputRecorder::open(const QString& path) {
+    close();
+    _file.setFileName(path);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(controllers) << "Unable to open input recording" << path;
+        return false;
+    }
+    _stream.setDevice(&_file);
+    prepareStream(_stream);
+
+    _stream << MAGIC << VERSION << (quint32)_devices.size();
+    for (const auto& recorded : _devices) {
+        auto device = recorded.device.lock();
+        auto inputs = device->getAvailableInputs();
+        _stream << device->getName() << (quint32)inputs.size();
+        for (const auto& input : inputs) {
+            _stream << (quint16)input.first.getChannel() << (quint8)input.first.getType() << input.second;
+        }
+        const auto& state = recorded.cleared;
+        _stream << (quint32)state.buttons.size() << (quint32)state.axes.size() << (quint32)state.poses.size();
+    }
+    return _stream.status() == QDataStream::Ok;
+}
+
+void InputRecorder::close() {
+    if (_file.isOpen()) {
+        _stream.setDevice(nullptr);
+        _file.close();
+    }
+}
+
+void InputRecorder::record(float deltaTime) {
+    if (!_file.isOpen()) {
+        return;
+    }
+    _stream << deltaTime;
+    for (const auto& recorded : _devices) {
+        auto device = recorded.device.lock();
+        writeState(_stream, device ? device->_states[device->_frontState] : recorded.cleared);
+    }
+}
+
+void InputRecorder::deviceRemoved(const InputDevice::Pointer& device) {
+    for (auto& recorded : _devices) {
+        if (recorded.device.lock() == device) {
+            recorded.device.reset();
+        }
+    }
+}
+
+bool InputPlayer::open(const QString& path) {
+    close();
+    _file.setFileName(path);
+    if (!_file.open(QIODevice::ReadOnly)) {
+        qCWarning(controllers) << "Unable to open input recording" << path;
+        return false;
+    }
+    _stream.setDevice(&_file);
+    prepareStream(_stream);
+
+    quint32 magic, version, deviceCount;
+    _stream >> magic >> version >> deviceCount;
+    if (magic != InputRecorder::MAGIC || version != InputRecorder::VERSION) {
+        qCWarning(controllers) << "Not a supported input recording" << path;
+        close();
+        return false;
+    }
+
+    for (quint32 i = 0; i < deviceCount && _stream.status() == QDataStream::Ok; ++i) {
+        QString name;
+        quint32 channelCount;
+        _stream >> name >> channelCount;
+        ReplayDevice::ChannelList channels;
+        for (quint32 j = 0; j < channelCount && _stream.status() == QDataStream::Ok; ++j) {
+            ReplayDevice::Channel channel;
+            quint8 type;
+            _stream >> channel.channel >> type >> channel.name;
+            channel.type = (ChannelType)type;
+            channels.push_back(channel);
+        }
+        quint32 buttons, axes, poses;
+        _stream >> buttons >> axes >> poses;
+        ChannelState state;
+        state.buttons.resize(buttons);
+        state.axes.resize(axes);
+        state.poses.resize(poses);
+        _states.push_back(state);
+        _devices.push_back(std::make_shared<ReplayDevice>(name, channels));
+    }
+
+    if (_stream.status() != QDataStream::Ok) {
+        qCWarning(controllers) << "Truncated input recording" << path;
+        close();
+        return false;
+    }
+    _firstUpdate = _file.pos();
+    rewind();
+    return true;
+}
+
+void InputPlayer::close() {
+    if (_file.isOpen()) {
+        _stream.setDevice(nullptr);
+        _file.close();
+    }
+    _devices.clear();
+    _states.clear();
+}
+
+bool InputPlayer::step(float& deltaTime) {
+    if (!_file.isOpen() || _stream.atEnd()) {
+        return false;
+    }
+    _stream >> deltaTime;
+    for (auto& state : _states) {
+        readState(_stream, state);
+    }
+    if (_stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    if (_pacing == Pacing::REAL_TIME) {
+        _played += deltaTime;
+        std::this_thread::sleep_until(_start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(_played)));
+    }
+
+    for (size_t i = 0; i < _devices.size(); ++i) {
+        _devices[i]->play(_states[i]);
+    }
+    return true;
+}
+
+void InputPlayer::rewind() {
+    if (_file.isOpen()) {
+        _file.seek(_firstUpdate);
+        _stream.resetStatus();
+    }
+    _start = Clock::now();
+    _played = 0.0;
+}
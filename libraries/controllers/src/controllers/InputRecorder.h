@@ -0,0 +1,106 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_controllers_InputRecorder_h
+#define hifi_controllers_InputRecorder_h
+
+#include <stdint.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
+
+#include "ChannelState.h"
+#include "InputDevice.h"
+#include "ReplayDevice.h"
+
+namespace controller {
+
+    // A recording is a header followed by one record per mapper update.
+    //
+    // The header holds the magic and version, then for each recorded device its
+    // name, its channels in the order the device listed them, and its button,
+    // axis and pose counts.  Each update record holds the update's deltaTime,
+    // then for each device its button and axis values and its poses, by channel
+    // table slot.  Values are stored as single precision floats, so replaying a
+    // recording reproduces the device state exactly.
+    class InputRecorder {
+    public:
+        using Pointer = std::unique_ptr<InputRecorder>;
+
+        static const quint32 MAGIC;
+        static const quint32 VERSION;
+
+        // Devices registered after the recording starts aren't recorded, devices
+        // removed during it are recorded with every channel cleared
+        InputRecorder(const std::vector<InputDevice::Pointer>& devices);
+        ~InputRecorder();
+
+        bool open(const QString& path);
+        void close();
+        // Called by the mapper once every device's state is latched for an update
+        void record(float deltaTime);
+        // Called by the mapper when a device is removed, as the device may outlive its removal
+        void deviceRemoved(const InputDevice::Pointer& device);
+
+    private:
+        struct RecordedDevice {
+            // Reset once the device is removed from the mapper
+            std::weak_ptr<InputDevice> device;
+            // Written once the device is gone
+            ChannelState cleared;
+        };
+
+        QFile _file;
+        QDataStream _stream;
+        std::vector<RecordedDevice> _devices;
+    };
+
+    // Feeds a recording back through replay devices, one update at a time
+    class InputPlayer {
+    public:
+        enum class Pacing {
+            // Updates are played back as soon as they're asked for
+            FULL_SPEED,
+            // Updates are held back until their recorded time has passed
+            REAL_TIME,
+        };
+
+        bool open(const QString& path);
+        void close();
+
+        // Register the devices with the mapper before stepping
+        const std::vector<ReplayDevice::Pointer>& getDevices() const { return _devices; }
+
+        void setPacing(Pacing pacing) { _pacing = pacing; }
+        // Publishes the next recorded update to the devices and gives its deltaTime,
+        // returns false at the end of the recording
+        bool step(float& deltaTime);
+        // Starts again from the first update
+        void rewind();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        QFile _file;
+        QDataStream _stream;
+        qint64 _firstUpdate { 0 };
+        std::vector<ReplayDevice::Pointer> _devices;
+        std::vector<ChannelState> _states;
+        Pacing _pacing { Pacing::FULL_SPEED };
+        Clock::time_point _start;
+        // Recorded seconds played since the start
+        double _played { 0.0 };
+    };
+
+}
+
+#endif
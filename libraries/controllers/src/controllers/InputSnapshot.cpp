@@ -0,0 +1,35 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "InputSnapshot.h"
+
+using namespace controller;
+
+const uint32_t SnapshotRing::SLOTS;
+
+void SnapshotRing::resize(size_t actionCount, const ChannelTable& standardTable) {
+    for (auto& slot : _slots) {
+        slot.snapshot.actionStates.assign(actionCount, 0.0f);
+        slot.snapshot.poseStates.assign(actionCount, Pose());
+        slot.snapshot.standard.resize(standardTable);
+    }
+}
+
+InputSnapshot& SnapshotRing::beginWrite() {
+    _writing = (_latest.load(std::memory_order_relaxed) + 1) % SLOTS;
+    auto& slot = _slots[_writing];
+    slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slot.snapshot;
+}
+
+void SnapshotRing::endWrite() {
+    auto& slot = _slots[_writing];
+    slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    _latest.store(_writing, std::memory_order_release);
+}
@@ -0,0 +1,82 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_controllers_InputSnapshot_h
+#define hifi_controllers_InputSnapshot_h
+
+#include <stdint.h>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "ChannelState.h"
+#include "Pose.h"
+
+namespace controller {
+
+    // The outputs of one UserInputMapper::update()
+    struct InputSnapshot {
+        uint64_t frame { 0 };
+        std::vector<float> actionStates;
+        std::vector<Pose> poseStates;
+        // The standard channel values, laid out by the mapper's standard channel table
+        ChannelState standard;
+    };
+
+    // Publishes snapshots from the update thread to readers on any thread.
+    //
+    // Snapshots are written in turn into a ring of preallocated slots, each with
+    // a sequence number which is odd while the slot is being written.  Readers
+    // take the most recently published slot and check the sequence number is
+    // unchanged once they're done, so they never block the writer or each other.
+    // A reader only has to retry if the writer wraps around the ring onto the
+    // slot it is reading, which takes SLOTS - 1 further updates.
+    class SnapshotRing {
+    public:
+        static const uint32_t SLOTS = 4;
+
+        // Not safe against concurrent readers, size the ring before publishing anything
+        void resize(size_t actionCount, const ChannelTable& standardTable);
+
+        // Writer only
+        InputSnapshot& beginWrite();
+        void endWrite();
+        // The writer can read what it last published without checking for a wrap
+        const InputSnapshot& latest() const { return _slots[_latest.load(std::memory_order_relaxed)].snapshot; }
+
+        template <typename F>
+        auto read(F reader) const -> decltype(reader(std::declval<const InputSnapshot&>())) {
+            for (;;) {
+                const auto& slot = _slots[_latest.load(std::memory_order_acquire)];
+                auto sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence & 1) {
+                    continue;
+                }
+                auto result = reader(slot.snapshot);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+                    return result;
+                }
+            }
+        }
+
+    private:
+        struct Slot {
+            std::atomic<uint32_t> sequence { 0 };
+            InputSnapshot snapshot;
+        };
+
+        Slot _slots[SLOTS];
+        std::atomic<uint32_t> _latest { 0 };
+        uint32_t _writing { 0 };
+    };
+
+}
+
+#endif
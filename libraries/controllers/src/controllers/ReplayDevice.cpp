@@ -0,0 +1,31 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "ReplayDevice.h"
+
+using namespace controller;
+
+ReplayDevice::ReplayDevice(const QString& name, const ChannelList& channels)
+    : InputDevice(name), _channels(channels) {
+    // So the state can be played before the device is registered
+    buildChannelTable();
+}
+
+Input::NamedVector ReplayDevice::getAvailableInputs() const {
+    // In the recorded order, so the channel table matches the recorded state
+    Input::NamedVector availableInputs;
+    for (const auto& channel : _channels) {
+        availableInputs.push_back(Input::NamedPair(Input(_deviceID, channel.channel, channel.type), channel.name));
+    }
+    return availableInputs;
+}
+
+void ReplayDevice::play(const ChannelState& state) {
+    setPendingState(state);
+    publishState();
+}
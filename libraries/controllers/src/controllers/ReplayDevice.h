@@ -0,0 +1,48 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_controllers_ReplayDevice_h
+#define hifi_controllers_ReplayDevice_h
+
+#include "InputDevice.h"
+
+namespace controller {
+
+    // Stands in for a recorded device, under its name and with its channels, so
+    // the mappings of the original device apply.  The state is pushed in by an
+    // InputPlayer rather than sampled in update().
+    class ReplayDevice : public InputDevice {
+    public:
+        using Pointer = std::shared_ptr<ReplayDevice>;
+
+        struct Channel {
+            uint16_t channel;
+            ChannelType type;
+            QString name;
+        };
+        using ChannelList = std::vector<Channel>;
+
+        ReplayDevice(const QString& name, const ChannelList& channels);
+
+        virtual void update(float deltaTime, const InputCalibrationData& inputCalibrationData, bool jointsCaptured) override {}
+        virtual void focusOutEvent() override {}
+
+        // Publishes the state of one recorded update, which must be laid out by the recorded channels
+        void play(const ChannelState& state);
+
+    protected:
+        virtual Input::NamedVector getAvailableInputs() const override;
+
+    private:
+        const ChannelList _channels;
+    };
+
+}
+
+#endif
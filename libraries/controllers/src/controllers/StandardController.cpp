@@ -29,8 +29,9 @@ void StandardController::update(float deltaTime, const controller::InputCalibrat
 }
 
 void StandardController::focusOutEvent() {
-    _axisStateMap.clear();
-    _buttonPressedMap.clear();
+    clearAxes();
+    clearButtons();
+    publishState();
 };
 
 Input::NamedVector StandardController::getAvailableInputs() const {
@@ -8,7 +8,11 @@
 
 #include "UserInputMapper.h"
 
+#include <algorithm>
+#include <functional>
+#include <queue>
 #include <set>
+#include <unordered_map>
 
 #include <QtCore/QThread>
 #include <QtCore/QFile>
@@ -18,6 +22,7 @@
 #include <QtCore/QJsonArray>
 
 #include <PathUtils.h>
+#include <SharedUtil.h>
 #include <NumericalConstants.h>
 
 #include "StandardController.h"
@@ -53,6 +58,17 @@ controller::UserInputMapper::UserInputMapper() {
     registerDevice(std::make_shared<ActionsDevice>());
     registerDevice(_stateDevice = std::make_shared<StateController>());
     registerDevice(std::make_shared<StandardController>());
+
+    // The standard channels are fixed, so the published state never needs resizing
+    auto standardInputs = getStandardInputs();
+    _standardTable.build(standardInputs);
+    _standardChannels.reserve(standardInputs.size());
+    for (const auto& namedInput : standardInputs) {
+        const auto& input = namedInput.first;
+        _standardChannels.push_back({ input, endpointFor(input).get(), _standardTable.slot(input.getType(), input.getChannel()) });
+    }
+    _snapshots.resize(toInt(Action::NUM_ACTIONS), _standardTable);
+    _lastStandardState.resize(_standardTable);
 }
 
 namespace controller {
@@ -77,6 +93,7 @@ void UserInputMapper::registerDevice(InputDevice::Pointer device) {
     const auto& deviceID = device->_deviceID;
 
     recordDeviceOfType(device->getName());
+    device->buildChannelTable();
 
     qCDebug(controllers) << "Registered input device <" << device->getName() << "> deviceID = " << deviceID;
     for (const auto& inputMapping : device->getAvailableInputs()) {
@@ -101,6 +118,12 @@ void UserInputMapper::registerDevice(InputDevice::Pointer device) {
     }
 
     _registeredDevices[deviceID] = device;
+    if (deviceID == _registeredDevices.rbegin()->first) {
+        indexDeviceInputs(device);
+    } else {
+        // Devices registered under an existing ID take precedence over later devices
+        rebuildInputIndex();
+    }
     auto mapping = loadMappings(device->getDefaultMappingConfigs());
     if (mapping) {
         _mappingsByDevice[deviceID] = mapping;
@@ -126,11 +149,39 @@ void UserInputMapper::removeDevice(int deviceID) {
     }
 
     _registeredDevices.erase(proxyEntry);
+    if (_recorder) {
+        _recorder->deviceRemoved(proxy);
+    }
+    rebuildInputIndex();
+    // Compiled routes may refer to the device
+    compileRoutes();
 
     emit hardwareChanged();
 }
 
 
+bool UserInputMapper::startRecording(const QString& path) {
+    Locker locker(_lock);
+    // The mapper's own devices are outputs, or driven by the application
+    std::vector<InputDevice::Pointer> devices;
+    for (const auto& device : _registeredDevices) {
+        if (device.first != STANDARD_DEVICE && device.first != ACTIONS_DEVICE && device.first != STATE_DEVICE) {
+            devices.push_back(device.second);
+        }
+    }
+    _recorder.reset(new InputRecorder(devices));
+    if (!_recorder->open(path)) {
+        _recorder.reset();
+        return false;
+    }
+    return true;
+}
+
+void UserInputMapper::stopRecording() {
+    Locker locker(_lock);
+    _recorder.reset();
+}
+
 void UserInputMapper::loadDefaultMapping(uint16 deviceID) {
     Locker locker(_lock);
     auto proxyEntry = _registeredDevices.find(deviceID);
@@ -169,6 +220,23 @@ QString UserInputMapper::getDeviceName(uint16 deviceID) {
     return QString("unknown");
 }
 
+void UserInputMapper::indexDeviceInputs(const InputDevice::Pointer& device) {
+    const QString prefix = device->_name + ".";
+    for (const auto& input : device->getAvailableInputs()) {
+        auto name = prefix + input.second;
+        if (!_inputsByName.contains(name)) {
+            _inputsByName.insert(name, input.first);
+        }
+    }
+}
+
+void UserInputMapper::rebuildInputIndex() {
+    _inputsByName.clear();
+    for (const auto& device : _registeredDevices) {
+        indexDeviceInputs(device.second);
+    }
+}
+
 int UserInputMapper::findDevice(QString name) const {
     Locker locker(_lock);
     for (auto device : _registeredDevices) {
@@ -195,6 +263,11 @@ int UserInputMapper::findAction(const QString& actionName) const {
 
 Input UserInputMapper::findDeviceInput(const QString& inputName) const {
     Locker locker(_lock);
+    auto entry = _inputsByName.constFind(inputName);
+    if (_inputsByName.constEnd() != entry) {
+        return entry.value();
+    }
+
     // Split the full input name as such: deviceName.inputName
     auto names = inputName.split('.');
 
@@ -203,17 +276,16 @@ Input UserInputMapper::findDeviceInput(const QString& inputName) const {
         auto deviceName = names[0];
         auto inputName = names[1];
 
-        int deviceID = findDevice(deviceName);
-        if (deviceID != Input::INVALID_DEVICE) {
-            const auto& device = _registeredDevices.at(deviceID);
-            auto deviceInputs = device->getAvailableInputs();
-
-            for (auto input : deviceInputs) {
-                if (input.second == inputName) {
-                    return input.first;
-                }
+        // Anything past the input name is ignored
+        if (names.size() > 2) {
+            entry = _inputsByName.constFind(deviceName + "." + inputName);
+            if (_inputsByName.constEnd() != entry) {
+                return entry.value();
             }
+        }
 
+        int deviceID = findDevice(deviceName);
+        if (deviceID != Input::INVALID_DEVICE) {
             qCDebug(controllers) << "Couldn\'t find InputChannel named <" << inputName << "> for device <" << deviceName << ">";
 
         } else {
@@ -234,62 +306,217 @@ void fixBisectedAxis(float& full, float& negative, float& positive) {
 }
 
 void UserInputMapper::update(float deltaTime) {
-    Locker locker(_lock);
+    {
+        Locker locker(_lock);
+        ++_updateCount;
+        _frameTime += deltaTime;
+        _deltaTime = deltaTime;
+        _updateTime = usecTimestampNow();
+
+        // Take the latest published state of each device, so every route sees the same values
+        for (const auto& device : _registeredDevices) {
+            device.second->latchState();
+        }
+        if (_recorder) {
+            _recorder->record(deltaTime);
+        }
+
+        // Reset the axis state for next loop
+        for (auto& channel : _actionStates) {
+            channel = 0.0f;
+        }
+
+        for (auto& channel : _poseStates) {
+            channel = Pose();
+        }
+
+        // Run the mappings code
+        runMappings();
+
+        // merge the bisected and non-bisected axes for now
+        fixBisectedAxis(_actionStates[toInt(Action::TRANSLATE_X)], _actionStates[toInt(Action::LATERAL_LEFT)], _actionStates[toInt(Action::LATERAL_RIGHT)]);
+        fixBisectedAxis(_actionStates[toInt(Action::TRANSLATE_Y)], _actionStates[toInt(Action::VERTICAL_DOWN)], _actionStates[toInt(Action::VERTICAL_UP)]);
+        fixBisectedAxis(_actionStates[toInt(Action::TRANSLATE_Z)], _actionStates[toInt(Action::LONGITUDINAL_FORWARD)], _actionStates[toInt(Action::LONGITUDINAL_BACKWARD)]);
+        fixBisectedAxis(_actionStates[toInt(Action::TRANSLATE_CAMERA_Z)], _actionStates[toInt(Action::BOOM_IN)], _actionStates[toInt(Action::BOOM_OUT)]);
+        fixBisectedAxis(_actionStates[toInt(Action::ROTATE_Y)], _actionStates[toInt(Action::YAW_LEFT)], _actionStates[toInt(Action::YAW_RIGHT)]);
+        fixBisectedAxis(_actionStates[toInt(Action::ROTATE_X)], _actionStates[toInt(Action::PITCH_UP)], _actionStates[toInt(Action::PITCH_DOWN)]);
 
-    static uint64_t updateCount = 0;
-    ++updateCount;
+        fixBisectedAxis(_actionStates[toInt(Action::RETICLE_X)], _actionStates[toInt(Action::RETICLE_LEFT)], _actionStates[toInt(Action::RETICLE_RIGHT)]);
+        fixBisectedAxis(_actionStates[toInt(Action::RETICLE_Y)], _actionStates[toInt(Action::RETICLE_UP)], _actionStates[toInt(Action::RETICLE_DOWN)]);
+
+        for (auto i = 0; i < toInt(Action::NUM_ACTIONS); i++) {
+            _actionStates[i] *= _actionScales[i];
+        }
 
-    // Reset the axis state for next loop
-    for (auto& channel : _actionStates) {
-        channel = 0.0f;
+        publishSnapshot();
     }
-    
-    for (auto& channel : _poseStates) {
-        channel = Pose();
+
+    // Receivers of the changes may call back into the mapper, so don't hold the lock
+    publishDelta();
+}
+
+void UserInputMapper::setActionState(Action action, float value) {
+    Locker locker(_lock);
+    _actionStates[toInt(action)] = value;
+}
+
+void UserInputMapper::deltaActionState(Action action, float delta) {
+    Locker locker(_lock);
+    _actionStates[toInt(action)] += delta;
+}
+
+void UserInputMapper::setActionState(Action action, const Pose& value) {
+    Locker locker(_lock);
+    _poseStates[toInt(action)] = value;
+}
+
+void UserInputMapper::publishSnapshot() {
+    auto& snapshot = _snapshots.beginWrite();
+    snapshot.frame = _updateCount;
+    std::copy(_actionStates.begin(), _actionStates.end(), snapshot.actionStates.begin());
+    std::copy(_poseStates.begin(), _poseStates.end(), snapshot.poseStates.begin());
+    // Peek, so that taking the snapshot doesn't mark the standard endpoints as read
+    for (const auto& channel : _standardChannels) {
+        if (!channel.endpoint || channel.slot == ChannelTable::INVALID_SLOT) {
+            continue;
+        }
+        switch (channel.input.getType()) {
+            case ChannelType::BUTTON:
+                snapshot.standard.buttons[channel.slot] = channel.endpoint->peek();
+                break;
+            case ChannelType::AXIS:
+                snapshot.standard.axes[channel.slot] = channel.endpoint->peek();
+                break;
+            case ChannelType::POSE:
+                snapshot.standard.poses[channel.slot] = channel.endpoint->peekPose();
+                break;
+            default:
+                break;
+        }
     }
+    _snapshots.endWrite();
+}
 
-    // Run the mappings code
-    runMappings();
+static float standardValue(const InputSnapshot& snapshot, const ChannelTable& table, const Input& input) {
+    auto slot = table.slot(input.getType(), input.getChannel());
+    if (slot == ChannelTable::INVALID_SLOT) {
+        return 0.0f;
+    }
+    switch (input.getType()) {
+        case ChannelType::BUTTON:
+            return snapshot.standard.buttons[slot];
+        case ChannelType::AXIS:
+            return snapshot.standard.axes[slot];
+        default:
+            return 0.0f;
+    }
+}
 
-    // merge the bisected and non-bisected axes for now
-    fixBisectedAxis(_actionStates[toInt(Action::TRANSLATE_X)], _actionStates[toInt(Action::LATERAL_LEFT)], _actionStates[toInt(Action::LATERAL_RIGHT)]);
-    fixBisectedAxis(_actionStates[toInt(Action::TRANSLATE_Y)], _actionStates[toInt(Action::VERTICAL_DOWN)], _actionStates[toInt(Action::VERTICAL_UP)]);
-    fixBisectedAxis(_actionStates[toInt(Action::TRANSLATE_Z)], _actionStates[toInt(Action::LONGITUDINAL_FORWARD)], _actionStates[toInt(Action::LONGITUDINAL_BACKWARD)]);
-    fixBisectedAxis(_actionStates[toInt(Action::TRANSLATE_CAMERA_Z)], _actionStates[toInt(Action::BOOM_IN)], _actionStates[toInt(Action::BOOM_OUT)]);
-    fixBisectedAxis(_actionStates[toInt(Action::ROTATE_Y)], _actionStates[toInt(Action::YAW_LEFT)], _actionStates[toInt(Action::YAW_RIGHT)]);
-    fixBisectedAxis(_actionStates[toInt(Action::ROTATE_X)], _actionStates[toInt(Action::PITCH_UP)], _actionStates[toInt(Action::PITCH_DOWN)]);
+// Invalid poses never compare equal, so only report a pose becoming invalid once
+static bool poseChanged(const Pose& pose, const Pose& lastPose) {
+    return (pose.isValid() || lastPose.isValid()) && pose != lastPose;
+}
 
-    fixBisectedAxis(_actionStates[toInt(Action::RETICLE_X)], _actionStates[toInt(Action::RETICLE_LEFT)], _actionStates[toInt(Action::RETICLE_RIGHT)]);
-    fixBisectedAxis(_actionStates[toInt(Action::RETICLE_Y)], _actionStates[toInt(Action::RETICLE_UP)], _actionStates[toInt(Action::RETICLE_DOWN)]);
+void UserInputMapper::publishDelta() {
+    // Only the update thread publishes snapshots, so it can read the latest one directly
+    const auto& snapshot = _snapshots.latest();
+    auto delta = _deltaPool.acquire();
+    delta->frame = snapshot.frame;
 
     static const float EPSILON = 0.01f;
     for (auto i = 0; i < toInt(Action::NUM_ACTIONS); i++) {
-        _actionStates[i] *= _actionScales[i];
-        // Emit only on change, and emit when moving back to 0
-        if (fabsf(_actionStates[i] - _lastActionStates[i]) > EPSILON) {
-            _lastActionStates[i] = _actionStates[i];
-            emit actionEvent(i, _actionStates[i]);
+        // Report only changes, including moving back to 0
+        if (fabsf(snapshot.actionStates[i] - _lastActionStates[i]) > EPSILON) {
+            _lastActionStates[i] = snapshot.actionStates[i];
+            delta->actions.push_back({ (uint32_t)i, snapshot.actionStates[i] });
+        }
+        const auto& pose = snapshot.poseStates[i];
+        auto& lastPose = _lastPoseStates[i];
+        if (poseChanged(pose, lastPose)) {
+            lastPose = pose;
+            delta->poses.push_back({ (uint32_t)i, pose });
         }
-        // TODO: emit signal for pose changes
     }
 
-    auto standardInputs = getStandardInputs();
-    if ((int)_lastStandardStates.size() != standardInputs.size()) {
-        _lastStandardStates.resize(standardInputs.size());
-        for (auto& lastValue : _lastStandardStates) {
-            lastValue = 0;
+    for (const auto& channel : _standardChannels) {
+        if (channel.slot == ChannelTable::INVALID_SLOT) {
+            continue;
+        }
+        const auto& input = channel.input;
+        switch (input.getType()) {
+            case ChannelType::BUTTON:
+            case ChannelType::AXIS: {
+                bool button = input.getType() == ChannelType::BUTTON;
+                float value = (button ? snapshot.standard.buttons : snapshot.standard.axes)[channel.slot];
+                float& lastValue = (button ? _lastStandardState.buttons : _lastStandardState.axes)[channel.slot];
+                if (value != lastValue) {
+                    lastValue = value;
+                    delta->inputs.push_back({ input.getID(), value });
+                }
+                break;
+            }
+            case ChannelType::POSE: {
+                const auto& pose = snapshot.standard.poses[channel.slot];
+                auto& lastPose = _lastStandardState.poses[channel.slot];
+                if (poseChanged(pose, lastPose)) {
+                    lastPose = pose;
+                    delta->inputPoses.push_back({ input.getID(), pose });
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (delta->empty()) {
+        return;
+    }
+
+    _publishSubscriptions.clear();
+    {
+        std::unique_lock<std::mutex> lock(_subscriptionLock);
+        auto itr = _subscriptions.begin();
+        while (itr != _subscriptions.end()) {
+            auto subscription = itr->lock();
+            if (subscription) {
+                _publishSubscriptions.push_back(subscription);
+                ++itr;
+            } else {
+                itr = _subscriptions.erase(itr);
+            }
         }
     }
 
-    for (int i = 0; i < standardInputs.size(); ++i) {
-        const auto& input = standardInputs[i].first;
-        float value = getValue(input);
-        float& oldValue = _lastStandardStates[i];
-        if (value != oldValue) {
-            oldValue = value;
-            emit inputEvent(input.id, value);
+    for (const auto& subscription : _publishSubscriptions) {
+        auto filtered = _deltaPool.acquire();
+        if (subscription->getFilter().apply(*delta, *filtered)) {
+            emit subscription->changed(filtered);
         }
     }
+    // Don't keep subscriptions alive until the next change
+    _publishSubscriptions.clear();
+
+    emit inputChanges(delta);
+}
+
+InputSubscription::Pointer UserInputMapper::subscribe(const InputDeltaFilter& filter) {
+    auto result = std::make_shared<InputSubscription>(filter);
+    std::unique_lock<std::mutex> lock(_subscriptionLock);
+    _subscriptions.push_back(result);
+    return result;
+}
+
+float UserInputMapper::getActionState(Action action) const {
+    return _snapshots.read([&](const InputSnapshot& snapshot) {
+        return snapshot.actionStates[toInt(action)];
+    });
+}
+
+Pose UserInputMapper::getPoseState(Action action) const {
+    return _snapshots.read([&](const InputSnapshot& snapshot) {
+        return snapshot.poseStates[toInt(action)];
+    });
 }
 
 Input::NamedVector UserInputMapper::getAvailableInputs(uint16 deviceID) const {
@@ -413,20 +640,17 @@ void UserInputMapper::runMappings() {
     if (debugRoutes) {
         qCDebug(controllers) << "Beginning mapping frame";
     }
-    for (auto endpointEntry : this->_endpointsByInput) {
+    for (const auto& endpointEntry : this->_endpointsByInput) {
         endpointEntry.second->reset();
     }
 
     if (debugRoutes) {
-        qCDebug(controllers) << "Processing device routes";
+        qCDebug(controllers) << "Processing" << _compiledRoutes.size() << "routes";
     }
-    // Now process the current values for each level of the stack
-    applyRoutes(_deviceRoutes);
-
-    if (debugRoutes) {
-        qCDebug(controllers) << "Processing standard routes";
+    // The routes are already in dependency order, so a single pass is enough
+    for (const auto& route : _compiledRoutes) {
+        applyRoute(route);
     }
-    applyRoutes(_standardRoutes);
 
     if (debugRoutes) {
         qCDebug(controllers) << "Done with mappings";
@@ -434,92 +658,190 @@ void UserInputMapper::runMappings() {
     debugRoutes = false;
 }
 
-// Encapsulate the logic that routes should not be read before they are written
-void UserInputMapper::applyRoutes(const Route::List& routes) {
-    Route::List deferredRoutes;
+// Routes should not read a standard endpoint before it has been written, so
+// order them such that every route writing to a standard endpoint comes before
+// the routes reading from it.  Device routes precede standard routes, and the
+// original order is kept wherever the dependencies allow it.
+void UserInputMapper::compileRoutes() {
+    Locker locker(_lock);
+    std::vector<Route::Pointer> routes;
+    routes.reserve(_deviceRoutes.size() + _standardRoutes.size());
+    for (const auto* list : { &_deviceRoutes, &_standardRoutes }) {
+        for (const auto& route : *list) {
+            // A route whose destination failed to create can never be applied
+            if (route && route->source && route->destination) {
+                routes.push_back(route);
+            }
+        }
+    }
 
-    for (const auto& route : routes) {
-        if (!route) {
-            continue;
+    using InputIds = std::vector<uint32_t>;
+    auto addStandardInput = [](const Endpoint::Pointer& endpoint, InputIds& ids) {
+        const auto& input = endpoint->getInput();
+        if (input.device == STANDARD_DEVICE) {
+            ids.push_back(input.getID());
+        }
+    };
+
+    const uint32_t count = (uint32_t)routes.size();
+    std::vector<InputIds> reads(count);
+    std::unordered_map<uint32_t, InputIds> writers;
+    InputIds written;
+    for (uint32_t i = 0; i < count; ++i) {
+        const auto& route = routes[i];
+        auto anySource = std::dynamic_pointer_cast<AnyEndpoint>(route->source);
+        if (anySource) {
+            for (const auto& child : anySource->_children) {
+                addStandardInput(child, reads[i]);
+            }
+        } else {
+            addStandardInput(route->source, reads[i]);
         }
 
-        // Try all the deferred routes
-        deferredRoutes.remove_if([](Route::Pointer route) {
-            return UserInputMapper::applyRoute(route);
-        });
+        written.clear();
+        auto arrayDestination = std::dynamic_pointer_cast<ArrayEndpoint>(route->destination);
+        if (arrayDestination) {
+            for (const auto& child : arrayDestination->_children) {
+                addStandardInput(child, written);
+            }
+        } else {
+            addStandardInput(route->destination, written);
+        }
+        for (auto id : written) {
+            writers[id].push_back(i);
+        }
+    }
 
-        if (!applyRoute(route)) {
-            deferredRoutes.push_back(route);
+    std::vector<InputIds> dependents(count);
+    std::vector<uint32_t> pending(count, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        for (auto id : reads[i]) {
+            auto itr = writers.find(id);
+            if (writers.end() == itr) {
+                continue;
+            }
+            for (auto writer : itr->second) {
+                if (writer != i) {
+                    dependents[writer].push_back(i);
+                    ++pending[i];
+                }
+            }
         }
     }
 
-    bool force = true;
-    for (const auto& route : deferredRoutes) {
-        UserInputMapper::applyRoute(route, force);
+    // Kahn's algorithm, always taking the earliest ready route to keep the order stable
+    std::priority_queue<uint32_t, InputIds, std::greater<uint32_t>> ready;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!pending[i]) {
+            ready.push(i);
+        }
+    }
+    std::vector<bool> emitted(count, false);
+    InputIds order;
+    order.reserve(count);
+    uint32_t nextUnemitted = 0;
+    size_t cycles = 0;
+    while (order.size() < count) {
+        if (ready.empty()) {
+            // Routes feeding each other in a loop, force the earliest one
+            while (emitted[nextUnemitted]) {
+                ++nextUnemitted;
+            }
+            pending[nextUnemitted] = 0;
+            ready.push(nextUnemitted);
+            ++cycles;
+        }
+        auto i = ready.top();
+        ready.pop();
+        emitted[i] = true;
+        order.push_back(i);
+        for (auto dependent : dependents[i]) {
+            if (pending[dependent] && 0 == --pending[dependent]) {
+                ready.push(dependent);
+            }
+        }
     }
-}
 
+    _compiledRoutes.clear();
+    _compiledRoutes.reserve(count);
+    _filterProgram.clear();
+    bool debuggable = false;
+    for (auto i : order) {
+        const auto& route = routes[i];
+        CompiledRoute compiled;
+        compiled.route = route.get();
+        compiled.source = route->source.get();
+        compiled.destination = route->destination.get();
+        compiled.conditional = route->conditional.get();
+        compiled.filters = _filterProgram.compile(route->filters);
+        compiled.filterList = &route->filters;
+        compiled.sourceDevice = nullptr;
+        compiled.isPose = route->source->isPose();
+        if (compiled.isPose) {
+            auto inputEntry = _inputsByEndpoint.find(route->source);
+            if (_inputsByEndpoint.end() != inputEntry) {
+                auto deviceID = inputEntry->second.getDevice();
+                if (deviceID != STANDARD_DEVICE && deviceID != ACTIONS_DEVICE && deviceID != STATE_DEVICE) {
+                    auto deviceEntry = _registeredDevices.find(deviceID);
+                    if (_registeredDevices.end() != deviceEntry) {
+                        compiled.sourceDevice = deviceEntry->second.get();
+                    }
+                }
+            }
+        }
+        debuggable = debuggable || route->debug;
+        _compiledRoutes.push_back(compiled);
+    }
+    debuggableRoutes = debuggable;
 
-bool UserInputMapper::applyRoute(const Route::Pointer& route, bool force) {
-    if (debugRoutes && route->debug) {
-        qCDebug(controllers) << "Applying route " << route->json;
+    if (cycles) {
+        qCWarning(controllers) << "Mapping routes contain" << cycles << "dependency cycles through standard endpoints";
     }
+}
 
-    // If the source hasn't been written yet, defer processing of this route
-    auto source = route->source;
-    auto sourceInput = source->getInput();
-    if (sourceInput.device == STANDARD_DEVICE && !force && source->writeable()) {
-        if (debugRoutes && route->debug) {
-            qCDebug(controllers) << "Source not yet written, deferring";
-        }
-        return false;
+void UserInputMapper::applyRoute(const CompiledRoute& compiled) const {
+    const auto& route = *compiled.route;
+    const bool debug = debugRoutes && route.debug;
+    if (debug) {
+        qCDebug(controllers) << "Applying route " << route.json;
     }
 
-    if (route->conditional) {
+    if (compiled.conditional) {
         // FIXME for endpoint conditionals we need to check if they've been written
-        if (!route->conditional->satisfied()) {
-            if (debugRoutes && route->debug) {
+        if (!compiled.conditional->satisfied()) {
+            if (debug) {
                 qCDebug(controllers) << "Conditional failed";
             }
-            return true;
+            return;
         }
     }
 
-
     // Most endpoints can only be read once (though a given mapping can route them to 
     // multiple places).  Consider... If the default is to wire the A button to JUMP
     // and someone else wires it to CONTEXT_MENU, I don't want both to occur when 
     // I press the button.  The exception is if I'm wiring a control back to itself
     // in order to adjust my interface, like inverting the Y axis on an analog stick
-    if (!route->peek && !source->readable()) {
-        if (debugRoutes && route->debug) {
+    auto source = compiled.source;
+    if (!route.peek && !source->readable()) {
+        if (debug) {
             qCDebug(controllers) << "Source unreadable";
         }
-        return true;
-    }
-
-    auto destination = route->destination;
-    // THis could happen if the route destination failed to create
-    // FIXME: Maybe do not create the route if the destination failed and avoid this case ?
-    if (!destination) {
-        if (debugRoutes && route->debug) {
-            qCDebug(controllers) << "Bad Destination";
-        }
-        return true;
+        return;
     }
 
+    auto destination = compiled.destination;
     if (!destination->writeable()) {
-        if (debugRoutes && route->debug) {
+        if (debug) {
             qCDebug(controllers) << "Destination unwritable";
         }
-        return true;
+        return;
     }
 
     // Fetch the value, may have been overriden by previous loopback routes
-    if (source->isPose()) {
-        Pose value = getPose(source, route->peek);
+    if (compiled.isPose) {
+        Pose value = route.peek ? source->peekPose() : source->pose();
         static const Pose IDENTITY_POSE { vec3(), quat() };
-        if (debugRoutes && route->debug) {
+        if (debug) {
             if (!value.valid) {
                 qCDebug(controllers) << "Applying invalid pose";
             } else if (value == IDENTITY_POSE) {
@@ -528,27 +850,38 @@ bool UserInputMapper::applyRoute(const Route::Pointer& route, bool force) {
                 qCDebug(controllers) << "Applying valid pose";
             }
         }
-        // no filters yet for pose
-        destination->apply(value, source);
+        if (!compiled.filterList->empty()) {
+            // Predict from when the source was sampled, rather than when we read it
+            FilterTiming timing;
+            timing.deltaTime = _deltaTime;
+            uint64_t sampleTime = compiled.sourceDevice ? compiled.sourceDevice->getSampleTime() : 0;
+            if (!sampleTime) {
+                sampleTime = _updateTime;
+            }
+            uint64_t targetTime = _poseTargetTime.load(std::memory_order_relaxed);
+            if (targetTime > sampleTime) {
+                timing.predictionInterval = (float)(targetTime - sampleTime) / USECS_PER_SECOND;
+            }
+            for (const auto& filter : *compiled.filterList) {
+                value = filter->apply(value, timing);
+            }
+        }
+        destination->apply(value, route.source);
     } else {
-        // Fetch the value, may have been overriden by previous loopback routes
-        float value = getValue(source, route->peek);
+        float value = route.peek ? source->peek() : source->value();
 
-        if (debugRoutes && route->debug) {
+        if (debug) {
             qCDebug(controllers) << "Value was " << value;
         }
-        // Apply each of the filters.
-        for (const auto& filter : route->filters) {
-            value = filter->apply(value);
-        }
+        // Apply the compiled filter chain
+        value = _filterProgram.run(compiled.filters, value, _frameTime);
 
-        if (debugRoutes && route->debug) {
+        if (debug) {
             qCDebug(controllers) << "Filtered value was " << value;
         }
 
-        destination->apply(value, source);
+        destination->apply(value, route.source);
     }
-    return true;
 }
 
 Endpoint::Pointer UserInputMapper::endpointFor(const QJSValue& endpoint) {
@@ -660,6 +993,15 @@ float UserInputMapper::getValue(const Endpoint::Pointer& endpoint, bool peek) {
 }
 
 float UserInputMapper::getValue(const Input& input) const {
+    if (input.device == STANDARD_DEVICE) {
+        return _snapshots.read([&](const InputSnapshot& snapshot) {
+            return standardValue(snapshot, _standardTable, input);
+        });
+    }
+    if (input.device == ACTIONS_DEVICE && input.getType() != ChannelType::POSE && input.getChannel() < toInt(Action::NUM_ACTIONS)) {
+        return getActionState(Action(input.getChannel()));
+    }
+
     Locker locker(_lock);
     auto endpoint = endpointFor(input);
     if (!endpoint) {
@@ -676,6 +1018,19 @@ Pose UserInputMapper::getPose(const Endpoint::Pointer& endpoint, bool peek) {
 }
 
 Pose UserInputMapper::getPose(const Input& input) const {
+    if (input.device == STANDARD_DEVICE && input.getType() == ChannelType::POSE) {
+        auto slot = _standardTable.slot(ChannelType::POSE, input.getChannel());
+        if (slot == ChannelTable::INVALID_SLOT) {
+            return Pose();
+        }
+        return _snapshots.read([&](const InputSnapshot& snapshot) {
+            return snapshot.standard.poses[slot];
+        });
+    }
+    if (input.device == ACTIONS_DEVICE && input.getType() == ChannelType::POSE && input.getChannel() < toInt(Action::NUM_ACTIONS)) {
+        return getPoseState(Action(input.getChannel()));
+    }
+
     Locker locker(_lock);
     auto endpoint = endpointFor(input);
     if (!endpoint) {
@@ -695,16 +1050,18 @@ Mapping::Pointer UserInputMapper::loadMapping(const QString& jsonFile, bool enab
         return Mapping::Pointer();
     }
     loaded.insert(jsonFile);
-    QString json;
+    QByteArray json;
     {
         QFile file(jsonFile);
-        if (file.open(QFile::ReadOnly | QFile::Text)) {
-            json = QTextStream(&file).readAll();
+        if (file.open(QFile::ReadOnly)) {
+            json = file.readAll();
         }
         file.close();
     }
-    auto result = parseMapping(json);
-    if (enable) {
+    auto document = _mappingCache.load(json);
+    // Parse the text again to report what's wrong with it
+    auto result = document.isObject() ? parseMapping(document.object()) : parseMapping(QString::fromUtf8(json));
+    if (result && enable) {
         enableMapping(result->name);
     }
     return result;
@@ -1063,17 +1420,6 @@ Mapping::Pointer UserInputMapper::parseMapping(const QString& json) {
     return parseMapping(doc.object());
 }
 
-template <typename T>
-bool hasDebuggableRoute(const T& routes) {
-    for (auto route : routes) {
-        if (route->debug) {
-            return true;
-        }
-    }
-    return false;
-}
-
-
 void UserInputMapper::enableMapping(const Mapping::Pointer& mapping) {
     Locker locker(_lock);
     // New routes for a device get injected IN FRONT of existing routes.  Routes
@@ -1092,9 +1438,7 @@ void UserInputMapper::enableMapping(const Mapping::Pointer& mapping) {
     });
     _deviceRoutes.insert(_deviceRoutes.begin(), deviceRoutes.begin(), deviceRoutes.end());
 
-    if (!debuggableRoutes) {
-        debuggableRoutes = hasDebuggableRoute(_deviceRoutes) || hasDebuggableRoute(_standardRoutes);
-    }
+    compileRoutes();
 }
 
 void UserInputMapper::disableMapping(const Mapping::Pointer& mapping) {
@@ -1108,9 +1452,7 @@ void UserInputMapper::disableMapping(const Mapping::Pointer& mapping) {
         return routeSet.count(value) != 0;
     });
 
-    if (debuggableRoutes) {
-        debuggableRoutes = hasDebuggableRoute(_deviceRoutes) || hasDebuggableRoute(_standardRoutes);
-    }
+    compileRoutes();
 }
 
 }
@@ -12,6 +12,8 @@
 
 #include <glm/glm.hpp>
 
+#include <atomic>
+#include <map>
 #include <unordered_set>
 #include <functional>
 #include <memory>
@@ -24,11 +26,16 @@
 #include "Forward.h"
 #include "Pose.h"
 #include "Input.h"
+#include "InputDelta.h"
 #include "InputDevice.h"
+#include "InputRecorder.h"
+#include "InputSnapshot.h"
 #include "DeviceProxy.h"
 #include "StandardControls.h"
 #include "Actions.h"
 #include "StateController.h"
+#include "impl/FilterProgram.h"
+#include "impl/MappingCache.h"
 
 namespace controller {
 
@@ -78,15 +85,20 @@ namespace controller {
 
         QVector<Action> getAllActions() const;
         QString getActionName(Action action) const;
-        float getActionState(Action action) const { return _actionStates[toInt(action)]; }
-        Pose getPoseState(Action action) const { return _poseStates[toInt(action)]; }
+        // The action and standard states are read from the last published update, so
+        // they're safe to read from any thread without taking the mapper lock
+        float getActionState(Action action) const;
+        Pose getPoseState(Action action) const;
         int findAction(const QString& actionName) const;
         QVector<QString> getActionNames() const;
         Input inputFromAction(Action action) const { return getActionInputs()[toInt(action)].first; }
 
-        void setActionState(Action action, float value) { _actionStates[toInt(action)] = value; }
-        void deltaActionState(Action action, float delta) { _actionStates[toInt(action)] += delta; }
-        void setActionState(Action action, const Pose& value) { _poseStates[toInt(action)] = value; }
+        // The states are cleared at the start of each update and only become visible to
+        // the getters above once it publishes, so a value set from outside an update is
+        // never seen.  The action endpoints write them without locking, see below.
+        void setActionState(Action action, float value);
+        void deltaActionState(Action action, float delta);
+        void setActionState(Action action, const Pose& value);
 
         static Input makeStandardInput(controller::StandardButtonChannel button);
         static Input makeStandardInput(controller::StandardAxisChannel axis);
@@ -97,6 +109,15 @@ namespace controller {
         // Update means go grab all the device input channels and update the output channel values
         void update(float deltaTime);
 
+        // The time, in usecs since the epoch, pose prediction filters extrapolate to.  Display
+        // plugins set this to when the frame being rendered is expected to be displayed.
+        void setPoseTargetTime(uint64_t usecs) { _poseTargetTime.store(usecs, std::memory_order_relaxed); }
+
+        // Records the state of every input device, as each update sees it, until stopped.
+        // Play the recording back through an InputPlayer.
+        bool startRecording(const QString& path);
+        void stopRecording();
+
         const DevicesMap& getDevices() { return _registeredDevices; }
         uint16 getStandardDeviceID() const { return STANDARD_DEVICE; }
         InputDevice::Pointer getStandardDevice() { return _registeredDevices[getStandardDeviceID()]; }
@@ -112,9 +133,12 @@ namespace controller {
         float getValue(const Input& input) const;
         Pose getPose(const Input& input) const;
 
+        // The subscription receives the changes selected by the filter, until it's released
+        InputSubscription::Pointer subscribe(const InputDeltaFilter& filter);
+
     signals:
-        void actionEvent(int action, float state);
-        void inputEvent(int input, float state);
+        // Every change of an update, emitted once per update with any changes
+        void inputChanges(controller::InputDelta::Pointer delta);
         void hardwareChanged();
 
     protected:
@@ -128,21 +152,73 @@ namespace controller {
         std::vector<float> _actionScales = std::vector<float>(toInt(Action::NUM_ACTIONS), 1.0f);
         std::vector<float> _lastActionStates = std::vector<float>(toInt(Action::NUM_ACTIONS), 0.0f);
         std::vector<Pose> _poseStates = std::vector<Pose>(toInt(Action::NUM_ACTIONS));
-        std::vector<float> _lastStandardStates = std::vector<float>();
+        std::vector<Pose> _lastPoseStates = std::vector<Pose>(toInt(Action::NUM_ACTIONS));
+        // The standard channel values last reported by publishDelta
+        ChannelState _lastStandardState;
+
+        // Standard channels in the order of getStandardInputs(), with their endpoints
+        // and their slots in the published standard state
+        struct StandardChannel {
+            Input input;
+            Endpoint* endpoint;
+            uint16_t slot;
+        };
+        std::vector<StandardChannel> _standardChannels;
+        ChannelTable _standardTable;
+        SnapshotRing _snapshots;
+        uint64_t _updateCount { 0 };
+
+        void publishSnapshot();
+        void publishDelta();
+
+        std::mutex _subscriptionLock;
+        std::vector<std::weak_ptr<InputSubscription>> _subscriptions;
+        // Reused by publishDelta, which only runs on the update thread
+        std::vector<InputSubscription::Pointer> _publishSubscriptions;
+        InputDeltaPool _deltaPool;
 
         int recordDeviceOfType(const QString& deviceName);
         QHash<const QString&, int> _deviceCounts;
 
+        // Full input names ("Device.Input") of every registered device.  Where names
+        // collide the device with the lowest ID wins, then the first input it lists.
+        void indexDeviceInputs(const InputDevice::Pointer& device);
+        void rebuildInputIndex();
+        QHash<QString, Input> _inputsByName;
+        MappingCache _mappingCache;
+
         static float getValue(const EndpointPointer& endpoint, bool peek = false);
         static Pose getPose(const EndpointPointer& endpoint, bool peek = false);
 
         friend class RouteBuilderProxy;
         friend class MappingBuilderProxy;
 
+        // Used by the action endpoints as the routes run, which update() already holds the lock for
+        void deltaActionStateInUpdate(Action action, float delta) { _actionStates[toInt(action)] += delta; }
+        void setPoseStateInUpdate(Action action, const Pose& value) { _poseStates[toInt(action)] = value; }
+        friend class ActionEndpoint;
+
+        // A route flattened for execution by runMappings.  The pointers are owned
+        // by the route, which is kept alive by the device and standard route lists.
+        struct CompiledRoute {
+            const Route* route;
+            Endpoint* source;
+            Endpoint* destination;
+            Conditional* conditional;
+            FilterProgram::Kernel filters;
+            // Pose filters run the route's filters directly
+            const Filter::List* filterList;
+            // The device the source reads from, if it samples its own state
+            const InputDevice* sourceDevice;
+            bool isPose;
+        };
+        using CompiledRouteList = std::vector<CompiledRoute>;
+
         void runMappings();
 
-        static void applyRoutes(const RouteList& route);
-        static bool applyRoute(const RoutePointer& route, bool force = false);
+        // Rebuilds _compiledRoutes from the device and standard route lists
+        void compileRoutes();
+        void applyRoute(const CompiledRoute& route) const;
         void enableMapping(const MappingPointer& mapping);
         void disableMapping(const MappingPointer& mapping);
         EndpointPointer endpointFor(const QJSValue& endpoint);
@@ -172,6 +248,16 @@ namespace controller {
 
         RouteList _deviceRoutes;
         RouteList _standardRoutes;
+        // Device and standard routes in dependency order, so that routes reading a
+        // standard endpoint run after every route writing to it
+        CompiledRouteList _compiledRoutes;
+        FilterProgram _filterProgram;
+        // Seconds of update time, given to the time based filters
+        double _frameTime { 0.0 };
+        float _deltaTime { 0.0f };
+        uint64_t _updateTime { 0 };
+        std::atomic<uint64_t> _poseTargetTime { 0 };
+        InputRecorder::Pointer _recorder;
 
         using Locker = std::unique_lock<std::recursive_mutex>;
 
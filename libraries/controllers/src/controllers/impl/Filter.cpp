@@ -16,14 +16,19 @@
 
 #include <SharedUtil.h>
 
+#include "FilterProgram.h"
 #include "filters/ClampFilter.h"
 #include "filters/ConstrainToIntegerFilter.h"
 #include "filters/ConstrainToPositiveIntegerFilter.h"
+#include "filters/DeadBandFilter.h"
 #include "filters/DeadZoneFilter.h"
+#include "filters/ExponentialSmoothingFilter.h"
 #include "filters/HysteresisFilter.h"
 #include "filters/InvertFilter.h"
+#include "filters/OneEuroFilter.h"
 #include "filters/PulseFilter.h"
 #include "filters/ScaleFilter.h"
+#include "filters/VelocityExtrapolationFilter.h"
 
 using namespace controller;
 
@@ -37,11 +42,19 @@ REGISTER_FILTER_CLASS_INSTANCE(HysteresisFilter, "hysteresis")
 REGISTER_FILTER_CLASS_INSTANCE(InvertFilter, "invert")
 REGISTER_FILTER_CLASS_INSTANCE(ScaleFilter, "scale")
 REGISTER_FILTER_CLASS_INSTANCE(PulseFilter, "pulse")
+REGISTER_FILTER_CLASS_INSTANCE(DeadBandFilter, "deadBand")
+REGISTER_FILTER_CLASS_INSTANCE(ExponentialSmoothingFilter, "exponentialSmoothing")
+REGISTER_FILTER_CLASS_INSTANCE(OneEuroFilter, "oneEuro")
+REGISTER_FILTER_CLASS_INSTANCE(VelocityExtrapolationFilter, "velocityExtrapolation")
 
 const QString JSON_FILTER_TYPE = QStringLiteral("type");
 const QString JSON_FILTER_PARAMS = QStringLiteral("params");
 
 
+void Filter::compile(FilterProgram& program) const {
+    program.call(*this);
+}
+
 Filter::Pointer Filter::parse(const QJsonValue& json) {
     Filter::Pointer filter;
     if (json.isString()) {
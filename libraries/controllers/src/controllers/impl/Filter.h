@@ -21,10 +21,22 @@
 
 #include <QtCore/QEasingCurve>
 
+#include "../Pose.h"
+
 class QJsonValue;
 
 namespace controller {
 
+    class FilterProgram;
+
+    // Timing given to pose filters, in seconds
+    struct FilterTiming {
+        // Since the previous update
+        float deltaTime { 0.0f };
+        // From when the pose was sampled to when it's expected to be displayed
+        float predictionInterval { 0.0f };
+    };
+
     // Encapsulates part of a filter chain
     class Filter {
     public:
@@ -34,6 +46,10 @@ namespace controller {
         using Factory = hifi::SimpleFactory<Filter, QString>;
 
         virtual float apply(float value) const = 0;
+        // Filters which only act on values pass poses through unchanged
+        virtual Pose apply(const Pose& value, const FilterTiming& timing) const { return value; }
+        // Emits the filter into a compiled chain, by default as a call to apply()
+        virtual void compile(FilterProgram& program) const;
         // Factory features
         virtual bool parseParameters(const QJsonValue& parameters) { return true; }
 
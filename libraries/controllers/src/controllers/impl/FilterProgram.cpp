@@ -0,0 +1,131 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "FilterProgram.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "filters/HysteresisFilter.h"
+#include "filters/PulseFilter.h"
+
+using namespace controller;
+
+void FilterProgram::clear() {
+    _ops.clear();
+    _kernelStart = 0;
+}
+
+FilterProgram::Kernel FilterProgram::compile(const Filter::List& filters) {
+    Kernel result;
+    _kernelStart = (uint32_t)_ops.size();
+    for (const auto& filter : filters) {
+        filter->compile(*this);
+    }
+    result.first = _kernelStart;
+    result.count = (uint32_t)_ops.size() - _kernelStart;
+    _kernelStart = (uint32_t)_ops.size();
+    return result;
+}
+
+FilterProgram::Op* FilterProgram::previous() {
+    return _ops.size() > _kernelStart ? &_ops.back() : nullptr;
+}
+
+void FilterProgram::emit(OpCode code, float a, float b, const Filter* filter) {
+    _ops.push_back({ code, a, b, filter });
+}
+
+void FilterProgram::deadZone(float min) {
+    emit(DEAD_ZONE, min, 1.0f / (1.0f - min));
+}
+
+void FilterProgram::scale(float scale) {
+    auto op = previous();
+    if (op && op->code == SCALE) {
+        op->a *= scale;
+    } else if (op && op->code == DEAD_ZONE) {
+        // The dead zone already scales its output, and zero stays zero
+        op->b *= scale;
+    } else {
+        emit(SCALE, scale);
+    }
+}
+
+void FilterProgram::clamp(float min, float max) {
+    auto op = previous();
+    // Nested clamps are only the intersection of their ranges if they overlap
+    if (op && op->code == CLAMP && op->a <= op->b && min <= max && std::max(op->a, min) <= std::min(op->b, max)) {
+        op->a = std::max(op->a, min);
+        op->b = std::min(op->b, max);
+    } else {
+        emit(CLAMP, min, max);
+    }
+}
+
+void FilterProgram::sign() {
+    emit(SIGN);
+}
+
+void FilterProgram::step() {
+    emit(STEP);
+}
+
+void FilterProgram::hysteresis(const HysteresisFilter& filter) {
+    emit(HYSTERESIS, 0.0f, 0.0f, &filter);
+}
+
+void FilterProgram::pulse(const PulseFilter& filter) {
+    emit(PULSE, 0.0f, 0.0f, &filter);
+}
+
+void FilterProgram::call(const Filter& filter) {
+    emit(CALL, 0.0f, 0.0f, &filter);
+}
+
+float FilterProgram::execute(const Kernel& kernel, float value, double now) const {
+    auto op = _ops.data() + kernel.first;
+    const auto end = op + kernel.count;
+    for (; op != end; ++op) {
+        switch (op->code) {
+            case DEAD_ZONE:
+                value = (std::abs(value) < op->a) ? 0.0f : (value - op->a) * op->b;
+                break;
+
+            case SCALE:
+                value *= op->a;
+                break;
+
+            case CLAMP:
+                value = glm::clamp(value, op->a, op->b);
+                break;
+
+            case SIGN:
+                value = glm::sign(value);
+                break;
+
+            case STEP:
+                value = (value <= 0.0f) ? 0.0f : 1.0f;
+                break;
+
+            case HYSTERESIS:
+                // Qualified calls, to skip the virtual dispatch
+                value = static_cast<const HysteresisFilter*>(op->filter)->HysteresisFilter::apply(value);
+                break;
+
+            case PULSE:
+                value = static_cast<const PulseFilter*>(op->filter)->apply(value, now);
+                break;
+
+            case CALL:
+                value = op->filter->apply(value);
+                break;
+        }
+    }
+    return value;
+}
@@ -0,0 +1,88 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_Controllers_FilterProgram_h
+#define hifi_Controllers_FilterProgram_h
+
+#include <stdint.h>
+#include <vector>
+
+#include "Filter.h"
+
+namespace controller {
+
+    class HysteresisFilter;
+    class PulseFilter;
+
+    // The filter chains of every active route, compiled into one flat array of
+    // operations when the routes are compiled.
+    //
+    // Each built in filter emits its own operation, and adjacent operations are
+    // folded where the result is the same (a scale following a dead zone or
+    // another scale, nested clamps), so the common deadZone -> scale -> clamp
+    // chain runs as two operations without any virtual calls.  Filters which
+    // can't be compiled are called through Filter::apply.  Time based filters
+    // are given the frame time rather than reading the clock themselves.
+    class FilterProgram {
+    public:
+        enum OpCode : uint8_t {
+            DEAD_ZONE = 0,
+            SCALE,
+            CLAMP,
+            SIGN,
+            STEP,
+            HYSTERESIS,
+            PULSE,
+            CALL,
+        };
+
+        struct Op {
+            OpCode code;
+            float a;
+            float b;
+            // The filter holding the state for HYSTERESIS and PULSE, or the one to CALL
+            const Filter* filter;
+        };
+
+        // A range of the operations, for a single chain
+        struct Kernel {
+            uint32_t first { 0 };
+            uint32_t count { 0 };
+        };
+
+        void clear();
+        Kernel compile(const Filter::List& filters);
+        float run(const Kernel& kernel, float value, double now) const {
+            return kernel.count ? execute(kernel, value, now) : value;
+        }
+        size_t size() const { return _ops.size(); }
+
+        // Used by Filter::compile
+        void deadZone(float min);
+        void scale(float scale);
+        void clamp(float min, float max);
+        void sign();
+        void step();
+        void hysteresis(const HysteresisFilter& filter);
+        void pulse(const PulseFilter& filter);
+        void call(const Filter& filter);
+
+    private:
+        float execute(const Kernel& kernel, float value, double now) const;
+        // The previous operation of the chain being compiled, if any
+        Op* previous();
+        void emit(OpCode code, float a = 0.0f, float b = 0.0f, const Filter* filter = nullptr);
+
+        std::vector<Op> _ops;
+        uint32_t _kernelStart { 0 };
+    };
+
+}
+
+#endif
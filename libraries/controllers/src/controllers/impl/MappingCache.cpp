@@ -0,0 +1,64 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "MappingCache.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QStandardPaths>
+
+#include "../Logging.h"
+
+using namespace controller;
+
+// Bump to discard the existing entries
+static const QByteArray CACHE_VERSION = "1";
+
+MappingCache::MappingCache() {
+    auto cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cacheLocation.isEmpty()) {
+        _directory = cacheLocation + "/controllers";
+    }
+}
+
+QJsonDocument MappingCache::load(const QByteArray& json) {
+    if (_directory.isEmpty()) {
+        return QJsonDocument::fromJson(json);
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(CACHE_VERSION);
+    hash.addData(json);
+    const QString path = _directory + "/" + QString::fromLatin1(hash.result().toHex()) + ".qbjs";
+
+    {
+        QFile file(path);
+        if (file.open(QFile::ReadOnly)) {
+            auto document = QJsonDocument::fromBinaryData(file.readAll(), QJsonDocument::Validate);
+            if (!document.isNull()) {
+                return document;
+            }
+            qCDebug(controllers) << "Discarding invalid mapping cache entry" << path;
+        }
+    }
+
+    auto document = QJsonDocument::fromJson(json);
+    if (document.isNull()) {
+        return document;
+    }
+
+    QDir().mkpath(_directory);
+    QFile file(path);
+    if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+        file.write(document.toBinaryData());
+    } else {
+        qCDebug(controllers) << "Unable to write mapping cache entry" << path;
+    }
+    return document;
+}
@@ -0,0 +1,36 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_Controllers_MappingCache_h
+#define hifi_Controllers_MappingCache_h
+
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QString>
+
+namespace controller {
+
+    // Keeps the mapping files that have been parsed in Qt's binary JSON form, keyed
+    // by a hash of their text, so they load on later runs without parsing the text.
+    // Endpoint names in the documents are resolved on each load, so the entries
+    // remain valid whichever devices are registered.
+    class MappingCache {
+    public:
+        MappingCache();
+
+        // Returns a null document if the text isn't valid JSON
+        QJsonDocument load(const QByteArray& json);
+
+    private:
+        QString _directory;
+    };
+
+}
+
+#endif
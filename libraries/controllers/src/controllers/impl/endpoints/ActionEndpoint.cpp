@@ -18,7 +18,7 @@ void ActionEndpoint::apply(float newValue, const Pointer& source) {
     _currentValue += newValue;
     if (_input != Input::INVALID_INPUT) {
         auto userInputMapper = DependencyManager::get<UserInputMapper>();
-        userInputMapper->deltaActionState(Action(_input.getChannel()), newValue);
+        userInputMapper->deltaActionStateInUpdate(Action(_input.getChannel()), newValue);
     }
 }
 
@@ -29,7 +29,7 @@ void ActionEndpoint::apply(const Pose& value, const Pointer& source) {
     }
     if (_input != Input::INVALID_INPUT) {
         auto userInputMapper = DependencyManager::get<UserInputMapper>();
-        userInputMapper->setActionState(Action(_input.getChannel()), _currentPose);
+        userInputMapper->setPoseStateInUpdate(Action(_input.getChannel()), _currentPose);
     }
 }
 
@@ -11,6 +11,8 @@
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
 
+#include "../FilterProgram.h"
+
 using namespace controller;
 
 bool ClampFilter::parseParameters(const QJsonValue& parameters) {
@@ -36,3 +38,7 @@ bool ClampFilter::parseParameters(const QJsonValue& parameters) {
     }
     return true;
 }
+
+void ClampFilter::compile(FilterProgram& program) const {
+    program.clamp(_min, _max);
+}
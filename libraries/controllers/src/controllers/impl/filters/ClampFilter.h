@@ -22,6 +22,7 @@ public:
         return glm::clamp(value, _min, _max);
     }
     virtual bool parseParameters(const QJsonValue& parameters) override;
+    virtual void compile(FilterProgram& program) const override;
 protected:
     float _min = 0.0f;
     float _max = 1.0f;
@@ -6,10 +6,12 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
-// NOTE: we don't need to include this header unless/until we add additional symbols.
-//       By removing this header we prevent these warnings on windows:
-//
-//           warning LNK4221: This object file does not define any previously undefined public symbols, 
-//           so it will not be used by any link operation that consumes this library
-//
-//#include "ConstrainToIntegerFilter.h"
+#include "ConstrainToIntegerFilter.h"
+
+#include "../FilterProgram.h"
+
+using namespace controller;
+
+void ConstrainToIntegerFilter::compile(FilterProgram& program) const {
+    program.sign();
+}
@@ -22,6 +22,7 @@ public:
     virtual float apply(float value) const override {
         return glm::sign(value);
     }
+    virtual void compile(FilterProgram& program) const override;
 protected:
 };
 
@@ -22,6 +22,7 @@ public:
     virtual float apply(float value) const override {
         return (value <= 0.0f) ? 0.0f : 1.0f;
     }
+    virtual void compile(FilterProgram& program) const override;
 protected:
 };
 
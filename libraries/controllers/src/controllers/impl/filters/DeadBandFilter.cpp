@@ -0,0 +1,53 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "DeadBandFilter.h"
+
+#include <QtCore/QJsonObject>
+
+using namespace controller;
+
+Pose DeadBandFilter::apply(const Pose& value, const FilterTiming& timing) const {
+    if (!value.isValid() || !_previous.isValid()) {
+        _previous = value;
+        return value;
+    }
+
+    Pose result = value;
+    result.translation = _previous.translation;
+    vec3 offset = value.translation - _previous.translation;
+    float distance = glm::length(offset);
+    if (distance > _translation) {
+        result.translation = value.translation - offset * (_translation / distance);
+    }
+
+    result.rotation = _previous.rotation;
+    float cosHalfAngle = glm::min(fabsf(glm::dot(_previous.rotation, value.rotation)), 1.0f);
+    float angle = 2.0f * acosf(cosHalfAngle);
+    if (angle > _rotation) {
+        result.rotation = safeMix(_previous.rotation, value.rotation, 1.0f - _rotation / angle);
+    }
+
+    _previous = result;
+    return result;
+}
+
+bool DeadBandFilter::parseParameters(const QJsonValue& parameters) {
+    static const QString JSON_TRANSLATION = QStringLiteral("translation");
+    static const QString JSON_ROTATION = QStringLiteral("rotation");
+    if (parameters.isObject()) {
+        auto obj = parameters.toObject();
+        if (obj.contains(JSON_TRANSLATION)) {
+            _translation = obj[JSON_TRANSLATION].toDouble();
+        }
+        if (obj.contains(JSON_ROTATION)) {
+            _rotation = obj[JSON_ROTATION].toDouble();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_Controllers_Filters_DeadBand_h
+#define hifi_Controllers_Filters_DeadBand_h
+
+#include "PoseFilter.h"
+
+namespace controller {
+
+// Holds the pose still against small movements, such as tracking jitter on a
+// controller at rest.  Once the pose moves further than the band, the output
+// is dragged along at the edge of the band, so it never jumps.
+class DeadBandFilter : public PoseFilter {
+    REGISTER_FILTER_CLASS(DeadBandFilter);
+public:
+    using PoseFilter::apply;
+    DeadBandFilter() {}
+
+    virtual Pose apply(const Pose& value, const FilterTiming& timing) const override;
+    virtual bool parseParameters(const QJsonValue& parameters) override;
+
+private:
+    // Meters
+    float _translation { 0.001f };
+    // Radians
+    float _rotation { 0.005f };
+    mutable Pose _previous;
+};
+
+}
+
+#endif
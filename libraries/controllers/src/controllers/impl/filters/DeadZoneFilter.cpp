@@ -11,6 +11,8 @@
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
 
+#include "../FilterProgram.h"
+
 using namespace controller;
 float DeadZoneFilter::apply(float value) const {
     float scale = 1.0f / (1.0f - _min);
@@ -24,3 +26,7 @@ bool DeadZoneFilter::parseParameters(const QJsonValue& parameters) {
     static const QString JSON_MIN = QStringLiteral("min");
     return parseSingleFloatParameter(parameters, JSON_MIN, _min);
 }
+
+void DeadZoneFilter::compile(FilterProgram& program) const {
+    program.deadZone(_min);
+}
@@ -21,6 +21,7 @@ public:
 
     virtual float apply(float value) const override;
     virtual bool parseParameters(const QJsonValue& parameters) override;
+    virtual void compile(FilterProgram& program) const override;
 protected:
     float _min = 0.0f;
 };
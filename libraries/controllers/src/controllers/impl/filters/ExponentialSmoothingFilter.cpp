@@ -0,0 +1,57 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "ExponentialSmoothingFilter.h"
+
+#include <QtCore/QJsonObject>
+
+using namespace controller;
+
+// The rate the constants are given for
+static const float REFERENCE_INTERVAL = 1.0f / 90.0f;
+
+// Weight of the new value over the interval, for a weight given per reference interval
+static float blendWeight(float constant, float interval) {
+    // No time has passed, so the value can't have moved on from the previous one
+    if (interval <= 0.0f) {
+        return 0.0f;
+    }
+    constant = glm::clamp(constant, 0.0f, 1.0f);
+    if (constant >= 1.0f) {
+        return constant;
+    }
+    return 1.0f - powf(1.0f - constant, interval / REFERENCE_INTERVAL);
+}
+
+Pose ExponentialSmoothingFilter::apply(const Pose& value, const FilterTiming& timing) const {
+    if (!value.isValid() || !_previous.isValid()) {
+        _previous = value;
+        return value;
+    }
+
+    Pose result = value;
+    result.translation = glm::mix(_previous.translation, value.translation, blendWeight(_translationConstant, timing.deltaTime));
+    result.rotation = safeMix(_previous.rotation, value.rotation, blendWeight(_rotationConstant, timing.deltaTime));
+    _previous = result;
+    return result;
+}
+
+bool ExponentialSmoothingFilter::parseParameters(const QJsonValue& parameters) {
+    static const QString JSON_TRANSLATION = QStringLiteral("translation");
+    static const QString JSON_ROTATION = QStringLiteral("rotation");
+    if (parameters.isObject()) {
+        auto obj = parameters.toObject();
+        if (obj.contains(JSON_TRANSLATION)) {
+            _translationConstant = obj[JSON_TRANSLATION].toDouble();
+        }
+        if (obj.contains(JSON_ROTATION)) {
+            _rotationConstant = obj[JSON_ROTATION].toDouble();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_Controllers_Filters_ExponentialSmoothing_h
+#define hifi_Controllers_Filters_ExponentialSmoothing_h
+
+#include "PoseFilter.h"
+
+namespace controller {
+
+// Blends each pose with the previous output.  The constants are the weight of
+// the new pose at 90 updates per second, and are adjusted for the actual update
+// interval.  The velocities are passed through, so prediction still works after.
+class ExponentialSmoothingFilter : public PoseFilter {
+    REGISTER_FILTER_CLASS(ExponentialSmoothingFilter);
+public:
+    using PoseFilter::apply;
+    ExponentialSmoothingFilter() {}
+    ExponentialSmoothingFilter(float translationConstant, float rotationConstant) :
+        _translationConstant(translationConstant), _rotationConstant(rotationConstant) {}
+
+    virtual Pose apply(const Pose& value, const FilterTiming& timing) const override;
+    virtual bool parseParameters(const QJsonValue& parameters) override;
+
+private:
+    float _translationConstant { 0.1f };
+    float _rotationConstant { 0.1f };
+    mutable Pose _previous;
+};
+
+}
+
+#endif
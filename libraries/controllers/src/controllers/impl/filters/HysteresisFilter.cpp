@@ -11,6 +11,8 @@
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
 
+#include "../FilterProgram.h"
+
 using namespace controller;
 
 HysteresisFilter::HysteresisFilter(float min, float max) : _min(min), _max(max) {
@@ -62,3 +64,7 @@ bool HysteresisFilter::parseParameters(const QJsonValue& parameters) {
     }
     return true;
 }
+
+void HysteresisFilter::compile(FilterProgram& program) const {
+    program.hysteresis(*this);
+}
@@ -20,6 +20,7 @@ public:
     HysteresisFilter(float min = 0.25, float max = 0.75);
     virtual float apply(float value) const override;
     virtual bool parseParameters(const QJsonValue& parameters) override;
+    virtual void compile(FilterProgram& program) const override;
 protected:
     float _min;
     float _max;
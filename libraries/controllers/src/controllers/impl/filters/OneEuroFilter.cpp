@@ -0,0 +1,74 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "OneEuroFilter.h"
+
+#include <QtCore/QJsonObject>
+
+#include <NumericalConstants.h>
+
+using namespace controller;
+
+static float smoothingFactor(float cutoff, float interval) {
+    float timeConstant = 1.0f / (TWO_PI * cutoff);
+    return 1.0f / (1.0f + timeConstant / interval);
+}
+
+Pose OneEuroFilter::apply(const Pose& value, const FilterTiming& timing) const {
+    const float interval = timing.deltaTime;
+    if (!value.isValid() || !_previous.isValid()) {
+        _previous = value;
+        _velocity = vec3();
+        _angularSpeed = 0.0f;
+        return value;
+    }
+    if (interval <= 0.0f) {
+        return _previous;
+    }
+
+    const float derivativeFactor = smoothingFactor(_derivativeCutoff, interval);
+    Pose result = value;
+
+    vec3 velocity = (value.translation - _previous.translation) / interval;
+    _velocity = glm::mix(_velocity, velocity, derivativeFactor);
+    float cutoff = _minCutoff + _beta * glm::length(_velocity);
+    result.translation = glm::mix(_previous.translation, value.translation, smoothingFactor(cutoff, interval));
+
+    float cosHalfAngle = glm::min(fabsf(glm::dot(_previous.rotation, value.rotation)), 1.0f);
+    float angularSpeed = 2.0f * acosf(cosHalfAngle) / interval;
+    _angularSpeed = glm::mix(_angularSpeed, angularSpeed, derivativeFactor);
+    cutoff = _minCutoff + _rotationBeta * _angularSpeed;
+    result.rotation = safeMix(_previous.rotation, value.rotation, smoothingFactor(cutoff, interval));
+
+    _previous = result;
+    return result;
+}
+
+bool OneEuroFilter::parseParameters(const QJsonValue& parameters) {
+    static const QString JSON_MIN_CUTOFF = QStringLiteral("minCutoff");
+    static const QString JSON_DERIVATIVE_CUTOFF = QStringLiteral("derivativeCutoff");
+    static const QString JSON_BETA = QStringLiteral("beta");
+    static const QString JSON_ROTATION_BETA = QStringLiteral("rotationBeta");
+    if (parameters.isObject()) {
+        auto obj = parameters.toObject();
+        if (obj.contains(JSON_MIN_CUTOFF)) {
+            _minCutoff = obj[JSON_MIN_CUTOFF].toDouble();
+        }
+        if (obj.contains(JSON_DERIVATIVE_CUTOFF)) {
+            _derivativeCutoff = obj[JSON_DERIVATIVE_CUTOFF].toDouble();
+        }
+        if (obj.contains(JSON_BETA)) {
+            _beta = obj[JSON_BETA].toDouble();
+        }
+        if (obj.contains(JSON_ROTATION_BETA)) {
+            _rotationBeta = obj[JSON_ROTATION_BETA].toDouble();
+        }
+    }
+    // A zero cutoff would never move
+    return _minCutoff > 0.0f && _derivativeCutoff > 0.0f;
+}
@@ -0,0 +1,46 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_Controllers_Filters_OneEuro_h
+#define hifi_Controllers_Filters_OneEuro_h
+
+#include "PoseFilter.h"
+
+namespace controller {
+
+// Speed adaptive low pass filter (Casiez et al, "1 Euro Filter").  The cutoff
+// frequency rises with the filtered speed, so slow movement is smoothed heavily
+// for stability and fast movement lightly for latency.  Translation and rotation
+// are filtered separately, the rotation by its angular speed.
+class OneEuroFilter : public PoseFilter {
+    REGISTER_FILTER_CLASS(OneEuroFilter);
+public:
+    using PoseFilter::apply;
+    OneEuroFilter() {}
+
+    virtual Pose apply(const Pose& value, const FilterTiming& timing) const override;
+    virtual bool parseParameters(const QJsonValue& parameters) override;
+
+private:
+    // Hz
+    float _minCutoff { 1.0f };
+    float _derivativeCutoff { 1.0f };
+    // Hz per meter per second
+    float _beta { 5.0f };
+    // Hz per radian per second
+    float _rotationBeta { 1.0f };
+
+    mutable Pose _previous;
+    mutable vec3 _velocity { 0.0f };
+    mutable float _angularSpeed { 0.0f };
+};
+
+}
+
+#endif
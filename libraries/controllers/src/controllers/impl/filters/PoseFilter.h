@@ -0,0 +1,29 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_Controllers_Filters_PoseFilter_h
+#define hifi_Controllers_Filters_PoseFilter_h
+
+#include "../Filter.h"
+
+namespace controller {
+
+// Base for filters which only act on poses, values pass through them unchanged.
+// Filters with state reset it whenever the pose becomes invalid.
+class PoseFilter : public Filter {
+public:
+    using Filter::apply;
+    virtual float apply(float value) const override { return value; }
+    // Nothing to run for values
+    virtual void compile(FilterProgram& program) const override {}
+};
+
+}
+
+#endif
@@ -11,16 +11,21 @@
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
 
+#include "../FilterProgram.h"
+
 using namespace controller;
 
-const float PulseFilter::DEFAULT_LAST_EMIT_TIME = -::std::numeric_limits<float>::max();
+const double PulseFilter::DEFAULT_LAST_EMIT_TIME = -::std::numeric_limits<double>::max();
 
 float PulseFilter::apply(float value) const {
+    return apply(value, secTimestampNow());
+}
+
+float PulseFilter::apply(float value, double now) const {
     float result = 0.0f;
 
     if (0.0f != value) {
-        float now = secTimestampNow();
-        float delta = now - _lastEmitTime;
+        double delta = now - _lastEmitTime;
         if (delta >= _interval) {
             _lastEmitTime = now;
             result = value;
@@ -44,3 +49,6 @@ bool PulseFilter::parseParameters(const QJsonValue& parameters) {
     return parseSingleFloatParameter(parameters, JSON_INTERVAL, _interval);
 }
 
+void PulseFilter::compile(FilterProgram& program) const {
+    program.pulse(*this);
+}
@@ -22,12 +22,15 @@ public:
     PulseFilter(float interval) : _interval(interval) {}
 
     virtual float apply(float value) const override;
+    // Pulses against the given time in seconds, rather than reading the clock
+    float apply(float value, double now) const;
 
     virtual bool parseParameters(const QJsonValue& parameters) override;
+    virtual void compile(FilterProgram& program) const override;
 
 private:
-    static const float DEFAULT_LAST_EMIT_TIME;
-    mutable float _lastEmitTime { DEFAULT_LAST_EMIT_TIME };
+    static const double DEFAULT_LAST_EMIT_TIME;
+    mutable double _lastEmitTime { DEFAULT_LAST_EMIT_TIME };
     bool _resetOnZero { false };
     float _interval { 1.0f };
 };
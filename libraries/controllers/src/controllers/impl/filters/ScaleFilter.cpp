@@ -11,9 +11,15 @@
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
 
+#include "../FilterProgram.h"
+
 using namespace controller;
 
 bool ScaleFilter::parseParameters(const QJsonValue& parameters) {
     static const QString JSON_SCALE = QStringLiteral("scale");
     return parseSingleFloatParameter(parameters, JSON_SCALE, _scale);
 }
+
+void ScaleFilter::compile(FilterProgram& program) const {
+    program.scale(_scale);
+}
@@ -24,6 +24,7 @@ public:
         return value * _scale;
     }
     virtual bool parseParameters(const QJsonValue& parameters) override;
+    virtual void compile(FilterProgram& program) const override;
 
 private:
     float _scale = 1.0f;
@@ -0,0 +1,46 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "VelocityExtrapolationFilter.h"
+
+#include <QtCore/QJsonObject>
+
+#include <NumericalConstants.h>
+
+using namespace controller;
+
+Pose VelocityExtrapolationFilter::apply(const Pose& value, const FilterTiming& timing) const {
+    float interval = glm::clamp(timing.predictionInterval * _scale, 0.0f, _maxInterval);
+    if (!value.isValid() || interval <= 0.0f) {
+        return value;
+    }
+
+    Pose result = value;
+    result.translation += value.velocity * interval;
+    float angularSpeed = glm::length(value.angularVelocity);
+    if (angularSpeed > EPSILON) {
+        // Angular velocity is an axis scaled by the speed in radians per second
+        result.rotation = glm::normalize(glm::angleAxis(angularSpeed * interval, value.angularVelocity / angularSpeed) * value.rotation);
+    }
+    return result;
+}
+
+bool VelocityExtrapolationFilter::parseParameters(const QJsonValue& parameters) {
+    static const QString JSON_SCALE = QStringLiteral("scale");
+    static const QString JSON_MAX = QStringLiteral("max");
+    if (parameters.isObject()) {
+        auto obj = parameters.toObject();
+        if (obj.contains(JSON_SCALE)) {
+            _scale = obj[JSON_SCALE].toDouble();
+        }
+        if (obj.contains(JSON_MAX)) {
+            _maxInterval = obj[JSON_MAX].toDouble();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,36 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_Controllers_Filters_VelocityExtrapolation_h
+#define hifi_Controllers_Filters_VelocityExtrapolation_h
+
+#include "PoseFilter.h"
+
+namespace controller {
+
+// Predicts the pose forward to when it will be displayed, from its linear and
+// angular velocity.  The interval can be scaled down, and is capped so that
+// a late frame doesn't throw the pose far off.
+class VelocityExtrapolationFilter : public PoseFilter {
+    REGISTER_FILTER_CLASS(VelocityExtrapolationFilter);
+public:
+    using PoseFilter::apply;
+    VelocityExtrapolationFilter() {}
+
+    virtual Pose apply(const Pose& value, const FilterTiming& timing) const override;
+    virtual bool parseParameters(const QJsonValue& parameters) override;
+
+private:
+    float _scale { 1.0f };
+    float _maxInterval { 0.1f };
+};
+
+}
+
+#endif
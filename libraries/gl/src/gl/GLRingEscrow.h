@@ -0,0 +1,360 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_GLRingEscrow_h
+#define hifi_GLRingEscrow_h
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include <QtCore/QDebug>
+
+#include <SharedUtil.h>
+#include <NumericalConstants.h>
+
+#include "Config.h"
+
+// A GLEscrow for exactly one producer context and one consumer context, which
+// passes resources between them through fixed size lock free rings rather than
+// locked queues.  Neither side ever waits on the other and nothing is allocated
+// per submission.
+//
+// Submissions flow from the producer to the consumer through one ring, and
+// resources the consumer is done with flow back to the producer through another,
+// to be recycled by the producer once their fences have signaled.  As fences on
+// a context signal in order, the consumer only ever fetches the newest signaled
+// submission, and every older one is sent straight back as wasted work.
+//
+// submit() must only be called by the producer.  The fetch functions and
+// release() must only be called by the consumer, or at least never concurrently
+// with each other.
+template <typename T, size_t CAPACITY = 8>
+class GLRingEscrow {
+    static_assert(CAPACITY && !(CAPACITY & (CAPACITY - 1)), "Capacity must be a power of two");
+public:
+    static const uint64_t MAX_UNSIGNALED_TIME = USECS_PER_SECOND / 2;
+    using Recycler = std::function<void(T t)>;
+
+    struct Stats {
+        uint64_t submitted { 0 };
+        uint64_t fetched { 0 };
+        // Submissions superseded by a later one before being fetched, or dropped
+        // because the consumer had stopped fetching and the ring was full
+        uint64_t wasted { 0 };
+        // From submission until the consumer found the write fence signaled, in usecs,
+        // summed over the submissions fetched once signaled
+        uint64_t fenceWaitUsecs { 0 };
+        uint64_t lastFenceWaitUsecs { 0 };
+        uint64_t maxFenceWaitUsecs { 0 };
+    };
+
+    GLRingEscrow() {
+        _overflow.reserve(CAPACITY);
+    }
+
+    const T& invalid() const {
+        static const T INVALID_RESULT {};
+        return INVALID_RESULT;
+    }
+
+    void setRecycler(Recycler recycler) {
+        _recycler = recycler;
+    }
+
+    // Submissions not yet fetched, may be stale by the time it returns
+    size_t depth() const {
+        return _submits.size();
+    }
+
+    Stats getStats() const {
+        Stats result;
+        result.submitted = _submitted.load(std::memory_order_relaxed);
+        result.fetched = _fetched.load(std::memory_order_relaxed);
+        result.wasted = _wasted.load(std::memory_order_relaxed);
+        result.fenceWaitUsecs = _fenceWaitUsecs.load(std::memory_order_relaxed);
+        result.lastFenceWaitUsecs = _lastFenceWaitUsecs.load(std::memory_order_relaxed);
+        result.maxFenceWaitUsecs = _maxFenceWaitUsecs.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    // Consumer only, when the most recently fetched resource was submitted, in usecs
+    uint64_t lastFetchedSubmitTime() const {
+        return _lastFetchedSubmitTime;
+    }
+
+    // Submit a new resource from the producer context, and recycle the resources the
+    // consumer has released.  Returns the number of submissions found to be wasted.
+    size_t submit(T t, GLsync writeSync = 0) {
+        if (!writeSync) {
+            writeSync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+        }
+
+        size_t wasted = 0;
+        Item item(t, writeSync);
+        if (_submits.push(item)) {
+            _submitted.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // The consumer has stopped fetching, so drop the new submission rather than wait.
+            // It can be recycled straight away, any reuse is on this context after the writes.
+            _wasted.fetch_add(1, std::memory_order_relaxed);
+            recycle(item);
+            ++wasted;
+        }
+        return wasted + recycleReleases();
+    }
+
+    // Populates t with the newest submission whose write fence has signaled, if any
+    bool fetchSignaled(T& t) {
+        flushOverflow();
+        const size_t count = _submits.size();
+        size_t newest = count;
+        for (size_t i = count; i-- > 0; ) {
+            if (signaled(_submits.at(i))) {
+                newest = i;
+                break;
+            }
+        }
+        if (newest == count) {
+            return false;
+        }
+
+        auto& item = _submits.at(newest);
+        auto fenceWait = item.signaledAt - item.created;
+        _fenceWaitUsecs.fetch_add(fenceWait, std::memory_order_relaxed);
+        _lastFenceWaitUsecs.store(fenceWait, std::memory_order_relaxed);
+        if (fenceWait > _maxFenceWaitUsecs.load(std::memory_order_relaxed)) {
+            _maxFenceWaitUsecs.store(fenceWait, std::memory_order_relaxed);
+        }
+        take(newest, t);
+        if (item.sync) {
+            glDeleteSync(item.sync);
+        }
+        _submits.pop(newest + 1);
+        return true;
+    }
+
+    // Populates t with the newest submission and sync with a fence that will be
+    // signaled when all its write commands have completed.  The caller owns the fence.
+    bool fetchWithFence(T& t, GLsync& sync) {
+        flushOverflow();
+        const size_t count = _submits.size();
+        if (!count) {
+            return false;
+        }
+        take(count - 1, t);
+        sync = _submits.at(count - 1).sync;
+        _submits.pop(count);
+        return true;
+    }
+
+    bool fetchWithGpuWait(T& t) {
+        GLsync sync { 0 };
+        if (fetchWithFence(t, sync)) {
+            // Texture was updated, inject a wait into the GL command stream to ensure
+            // commands on this context until the commands to generate t are finished.
+            if (sync != 0) {
+                glWaitSync(sync, 0, GL_TIMEOUT_IGNORED);
+                glDeleteSync(sync);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Also releases any previous resource held by the caller
+    bool fetchSignaledAndRelease(T& value) {
+        T originalValue = value;
+        if (fetchSignaled(value)) {
+            if (originalValue != invalid()) {
+                release(originalValue);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    bool fetchAndReleaseWithGpuWait(T& value) {
+        T originalValue = value;
+        if (fetchWithGpuWait(value)) {
+            if (originalValue != invalid()) {
+                release(originalValue);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Hands a fetched resource back to the producer, to be recycled once the read fence has signaled
+    void release(const T& t, GLsync readSync = 0) {
+        if (!readSync) {
+            readSync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+        }
+        sendBack(Item(t, readSync));
+    }
+
+private:
+    struct Item {
+        T value {};
+        GLsync sync { 0 };
+        uint64_t created { 0 };
+        // Consumer side, when the write fence was first seen signaled
+        uint64_t signaledAt { 0 };
+        bool wasted { false };
+
+        Item() {}
+        Item(const T& value, GLsync sync) : value(value), sync(sync), created(usecTimestampNow()) {}
+    };
+
+    // Single producer, single consumer ring of items.  Slots between the head and
+    // the tail belong to the consumer, the rest to the producer.
+    template <size_t SIZE>
+    class Ring {
+    public:
+        // Producer only, returns false if the ring is full
+        bool push(const Item& item) {
+            auto tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _head.load(std::memory_order_acquire) == SIZE) {
+                return false;
+            }
+            _items[tail & (SIZE - 1)] = item;
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t size() const {
+            return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+        }
+
+        // Consumer only, the oldest item is at 0
+        Item& at(size_t index) {
+            return _items[(_head.load(std::memory_order_relaxed) + index) & (SIZE - 1)];
+        }
+
+        // Consumer only, clears the items so they don't keep resources alive
+        void pop(size_t count = 1) {
+            auto head = _head.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < count; ++i) {
+                _items[(head + i) & (SIZE - 1)] = Item();
+            }
+            _head.store(head + count, std::memory_order_release);
+        }
+
+    private:
+        std::array<Item, SIZE> _items;
+        // Padded so the two sides don't contend for a cache line
+        std::atomic<size_t> _head { 0 };
+        char _padding[64];
+        std::atomic<size_t> _tail { 0 };
+    };
+
+    // Consumer side
+    bool signaled(Item& item) {
+        if (item.signaledAt) {
+            return true;
+        }
+        if (item.sync) {
+            auto result = glClientWaitSync(item.sync, 0, 0);
+            if (GL_TIMEOUT_EXPIRED == result || GL_WAIT_FAILED == result) {
+                return false;
+            }
+        }
+        item.signaledAt = usecTimestampNow();
+        return true;
+    }
+
+    // Consumer side, takes the submission at index and sends every older one back as wasted
+    void take(size_t index, T& t) {
+        for (size_t i = 0; i < index; ++i) {
+            auto item = _submits.at(i);
+            item.wasted = true;
+            sendBack(item);
+        }
+        _wasted.fetch_add(index, std::memory_order_relaxed);
+        _fetched.fetch_add(1, std::memory_order_relaxed);
+        t = _submits.at(index).value;
+        _lastFetchedSubmitTime = _submits.at(index).created;
+    }
+
+    // Consumer side.  The release ring only fills if the producer stops submitting, in
+    // which case releases wait in a local list until there's room.
+    void sendBack(const Item& item) {
+        flushOverflow();
+        if (!_overflow.empty() || !_releases.push(item)) {
+            _overflow.push_back(item);
+        }
+    }
+
+    void flushOverflow() {
+        size_t sent = 0;
+        while (sent < _overflow.size() && _releases.push(_overflow[sent])) {
+            ++sent;
+        }
+        if (sent) {
+            _overflow.erase(_overflow.begin(), _overflow.begin() + sent);
+        }
+    }
+
+    // Producer side
+    size_t recycleReleases() {
+        size_t wasted = 0;
+        while (_releases.size()) {
+            Item item = _releases.at(0);
+            if (item.sync) {
+                auto result = glClientWaitSync(item.sync, 0, 0);
+                if (GL_TIMEOUT_EXPIRED == result || GL_WAIT_FAILED == result) {
+                    auto age = usecTimestampNow() - item.created;
+                    if (age < MAX_UNSIGNALED_TIME) {
+                        // Releases are recycled in order, the rest can wait for the next submission
+                        break;
+                    }
+                    qWarning() << "Long unsignaled sync " << item.sync << " unsignaled for " << age;
+                }
+            }
+            _releases.pop();
+            if (item.wasted) {
+                ++wasted;
+            }
+            recycle(item);
+        }
+        return wasted;
+    }
+
+    void recycle(const Item& item) {
+        if (item.sync) {
+            glDeleteSync(item.sync);
+        }
+        if (item.value != invalid() && _recycler) {
+            _recycler(item.value);
+        }
+    }
+
+    Recycler _recycler;
+    // Items coming from the submission / writer context
+    Ring<CAPACITY> _submits;
+    // Items going back to the submission context, fetched items as well as wasted ones
+    Ring<CAPACITY * 2> _releases;
+    std::vector<Item> _overflow;
+    uint64_t _lastFetchedSubmitTime { 0 };
+
+    std::atomic<uint64_t> _submitted { 0 };
+    std::atomic<uint64_t> _fetched { 0 };
+    std::atomic<uint64_t> _wasted { 0 };
+    std::atomic<uint64_t> _fenceWaitUsecs { 0 };
+    std::atomic<uint64_t> _lastFenceWaitUsecs { 0 };
+    std::atomic<uint64_t> _maxFenceWaitUsecs { 0 };
+};
+
+using GLTextureRingEscrow = GLRingEscrow<GLuint>;
+
+#endif
@@ -0,0 +1,131 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "GLTraceRange.h"
+
+#include <deque>
+#include <vector>
+
+#include <QtGui/QOpenGLContext>
+
+#include <NumericalConstants.h>
+
+#include "Config.h"
+
+namespace {
+    // Ranges waiting on their queries are capped, in case the GPU stops making progress
+    const size_t MAX_PENDING_RANGES = 1024;
+    const uint64_t CALIBRATION_INTERVAL_NSECS = USECS_PER_SECOND * NSECS_PER_USEC;
+
+    // The queries for one thread, which are only valid on one context
+    struct ThreadQueries {
+        struct Pending {
+            const char* name;
+            uint64_t payload;
+            uint8_t flags;
+            GLuint begin;
+            GLuint end;
+        };
+
+        QOpenGLContext* context { nullptr };
+        std::vector<GLuint> free;
+        std::deque<Pending> pending;
+        int64_t gpuToTracerNsecs { 0 };
+        uint64_t lastCalibration { 0 };
+
+        GLuint acquire() {
+            GLuint query = 0;
+            if (free.empty()) {
+                glGenQueries(1, &query);
+            } else {
+                query = free.back();
+                free.pop_back();
+            }
+            return query;
+        }
+
+        void calibrate() {
+            auto now = Tracer::nowNsecs();
+            if (lastCalibration && now - lastCalibration < CALIBRATION_INTERVAL_NSECS) {
+                return;
+            }
+            GLint64 gpuNow = 0;
+            glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+            gpuToTracerNsecs = (int64_t)now - gpuNow;
+            lastCalibration = now;
+        }
+
+        // Records every range whose queries have completed, oldest first
+        void collect() {
+            while (!pending.empty()) {
+                const auto& range = pending.front();
+                GLuint available = 0;
+                glGetQueryObjectuiv(range.end, GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available) {
+                    break;
+                }
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(range.begin, GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(range.end, GL_QUERY_RESULT, &end);
+                Tracer::record(range.name, (uint64_t)((int64_t)begin + gpuToTracerNsecs),
+                    (uint64_t)((int64_t)end + gpuToTracerNsecs), range.payload, range.flags | Tracer::GPU);
+                free.push_back(range.begin);
+                free.push_back(range.end);
+                pending.pop_front();
+            }
+        }
+    };
+
+    thread_local ThreadQueries* threadQueries { nullptr };
+
+    ThreadQueries* getThreadQueries() {
+        auto context = QOpenGLContext::currentContext();
+        if (!context) {
+            return nullptr;
+        }
+        if (!threadQueries) {
+            threadQueries = new ThreadQueries();
+        }
+        // Queries from another context can't be read or deleted here, so they're abandoned
+        if (threadQueries->context != context) {
+            *threadQueries = ThreadQueries();
+            threadQueries->context = context;
+        }
+        return threadQueries;
+    }
+}
+
+GLTraceRange::GLTraceRange(const char* name, uint64_t payload, uint8_t flags) :
+    _name(name), _payload(payload), _flags(flags) {
+    if (!Tracer::isEnabled()) {
+        return;
+    }
+    auto queries = getThreadQueries();
+    if (!queries) {
+        return;
+    }
+    queries->collect();
+    if (queries->pending.size() >= MAX_PENDING_RANGES) {
+        return;
+    }
+    queries->calibrate();
+    _context = queries->context;
+    _beginQuery = queries->acquire();
+    glQueryCounter(_beginQuery, GL_TIMESTAMP);
+}
+
+GLTraceRange::~GLTraceRange() {
+    // Abandoned if the context changed within the range
+    if (!_beginQuery || QOpenGLContext::currentContext() != _context) {
+        return;
+    }
+    auto queries = getThreadQueries();
+    GLuint endQuery = queries->acquire();
+    glQueryCounter(endQuery, GL_TIMESTAMP);
+    queries->pending.push_back({ _name, _payload, _flags, _beginQuery, endQuery });
+}
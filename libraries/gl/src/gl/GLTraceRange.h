@@ -0,0 +1,42 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_gl_GLTraceRange_h
+#define hifi_gl_GLTraceRange_h
+
+#include <stdint.h>
+
+#include <shared/Tracer.h>
+
+class QOpenGLContext;
+
+// Records the GPU time taken by the GL commands issued in the enclosing scope,
+// as a range on the Tracer's GPU track for the calling thread.
+//
+// Timestamp queries are read back once available, on a later range from the same
+// thread, so tracing never stalls on the GPU.  GPU timestamps are mapped onto the
+// tracer's clock with an offset that is recalibrated every second.  Must be used
+// with a context current, and does nothing while tracing is disabled.
+class GLTraceRange {
+public:
+    GLTraceRange(const char* name, uint64_t payload = 0, uint8_t flags = Tracer::NONE);
+    ~GLTraceRange();
+
+private:
+    const char* _name;
+    uint64_t _payload;
+    uint8_t _flags;
+    QOpenGLContext* _context { nullptr };
+    uint32_t _beginQuery { 0 };
+};
+
+#define PROFILE_GPU_RANGE(name) GLTraceRange gpuRangeThis(name);
+#define PROFILE_GPU_RANGE_EX(name, payload) GLTraceRange gpuRangeThis(name, (uint64_t)payload, Tracer::HAS_PAYLOAD);
+
+#endif
@@ -15,6 +15,7 @@
 
 #include <QtCore/QSize>
 #include <QtCore/QPoint>
+#include <QtCore/QVariantMap>
 
 #include <GLMHelpers.h>
 
@@ -147,6 +148,18 @@ public:
     virtual float newFramePresentRate() const { return -1.0f; }
     // Rate at which rendered frames are being skipped
     virtual float droppedFrameRate() const { return -1.0f; }
+    // Rate at which rendered frames are superseded before they can be presented
+    virtual float wastedFrameRate() const { return -1.0f; }
+    // How long the last presented frame waited for its rendering to complete on the GPU
+    virtual float fenceWaitMsecs() const { return -1.0f; }
+    // Rate at which presents reused the previous composite, as nothing it depends on had changed
+    virtual float skippedCompositeRate() const { return -1.0f; }
+    // Smoothed variation between consecutive present intervals
+    virtual float presentJitterMsecs() const { return -1.0f; }
+    // Percentiles of the frame interval, latency and so on over the last few seconds, empty if not tracked
+    virtual QVariantMap presentStats(uint32_t windowSeconds = 1) const { return QVariantMap(); }
+    // The full distributions behind presentStats(), for offline analysis
+    virtual bool savePresentStats(const QString& path) const { return false; }
     uint32_t presentCount() const { return _presentedFrameIndex; }
 
     virtual void cycleDebugOutput() {}
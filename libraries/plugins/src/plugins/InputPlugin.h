@@ -23,5 +23,9 @@ public:
     virtual void pluginFocusOutEvent() = 0;
 
     virtual void pluginUpdate(float deltaTime, const controller::InputCalibrationData& inputCalibrationData, bool jointsCaptured) = 0;
+
+    // Plugins which can be updated from the input sampler thread, rather than in
+    // the simulation update.  Their devices must only be written from pluginUpdate.
+    virtual bool supportsThreadedSampling() const { return false; }
 };
 
@@ -0,0 +1,69 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "InputSampler.h"
+
+#include <algorithm>
+#include <thread>
+
+#include <NumericalConstants.h>
+#include <SharedUtil.h>
+
+#include "InputPlugin.h"
+
+InputSampler::InputSampler(const InputPluginList& plugins, int sampleRate) {
+    setObjectName("Input Sampler");
+    for (const auto& plugin : plugins) {
+        if (plugin->supportsThreadedSampling()) {
+            _plugins.push_back(plugin);
+        }
+    }
+    setSampleRate(sampleRate);
+}
+
+void InputSampler::setSampleRate(int sampleRate) {
+    _intervalUsecs = (int)(USECS_PER_SECOND / std::max(sampleRate, 1));
+}
+
+void InputSampler::setCalibration(const controller::InputCalibrationData& calibration) {
+    QMutexLocker locker(&_mutex);
+    _calibration = calibration;
+}
+
+void InputSampler::withSamplingPaused(const std::function<void()>& function) {
+    QMutexLocker locker(&_mutex);
+    function();
+}
+
+bool InputSampler::process() {
+    auto now = Clock::now();
+    if (now < _nextSample) {
+        std::this_thread::sleep_until(_nextSample);
+    }
+
+    {
+        QMutexLocker locker(&_mutex);
+        auto sampleTime = usecTimestampNow();
+        float deltaTime = _lastSampleTime ? (float)(sampleTime - _lastSampleTime) / USECS_PER_SECOND : 0.0f;
+        _lastSampleTime = sampleTime;
+        for (const auto& plugin : _plugins) {
+            if (plugin->isActive()) {
+                plugin->pluginUpdate(deltaTime, _calibration, false);
+            }
+        }
+    }
+
+    // Don't try to catch up on missed samples, only the latest one is used
+    auto interval = std::chrono::microseconds(_intervalUsecs.load());
+    _nextSample += interval;
+    now = Clock::now();
+    if (_nextSample < now) {
+        _nextSample = now + interval;
+    }
+    return true;
+}
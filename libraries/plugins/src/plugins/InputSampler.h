@@ -0,0 +1,53 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_plugins_InputSampler_h
+#define hifi_plugins_InputSampler_h
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include <GenericThread.h>
+
+#include <controllers/Input.h>
+
+#include "Forward.h"
+
+// Polls the input plugins which support threaded sampling at a fixed rate,
+// independent of the simulation rate.  Each poll publishes a new timestamped
+// state from the plugin's devices, and the mapper takes the latest one at its
+// next update.
+class InputSampler : public GenericThread {
+public:
+    static const int DEFAULT_SAMPLE_RATE = 250;
+
+    InputSampler(const InputPluginList& plugins, int sampleRate = DEFAULT_SAMPLE_RATE);
+
+    void setSampleRate(int sampleRate);
+    void setCalibration(const controller::InputCalibrationData& calibration);
+    bool hasPlugins() const { return !_plugins.empty(); }
+
+    // Runs the function between polls, for activating or deactivating plugins
+    void withSamplingPaused(const std::function<void()>& function);
+
+protected:
+    bool process() override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    InputPluginList _plugins;
+    controller::InputCalibrationData _calibration;
+    std::atomic<int> _intervalUsecs;
+    Clock::time_point _nextSample;
+    uint64_t _lastSampleTime { 0 };
+};
+
+#endif
@@ -19,6 +19,7 @@
 #include <glm/gtx/vector_angle.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <QtCore/QDateTime>
 #include <QtCore/QDebug>
 #include <QtCore/QObject>
 #include <QtCore/QUrl>
@@ -26,6 +27,7 @@
 #include <QtCore/QAbstractNativeEventFilter>
 #include <QtCore/QMimeData>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QStandardPaths>
 
 #include <QtGui/QScreen>
 #include <QtGui/QImage>
@@ -58,6 +60,7 @@
 
 #include "DisplayPlugin.h"
 #include "InputPlugin.h"
+#include "InputSampler.h"
 #include "PluginManager.h"
 #include "impl/display/CompositorHelper.h"
 #include "impl/display/OpenGLDisplayPlugin.h"
@@ -68,6 +71,8 @@ static const int THROTTLED_SIM_FRAME_PERIOD_MS = MSECS_PER_SECOND / THROTTLED_SI
 static const unsigned int CAPPED_SIM_FRAMERATE = 60;
 static const int CAPPED_SIM_FRAME_PERIOD_MS = MSECS_PER_SECOND / CAPPED_SIM_FRAMERATE;
 
+static Setting::Handle<int> INPUT_SAMPLE_RATE("inputSampleRate", InputSampler::DEFAULT_SAMPLE_RATE);
+
 
 PluginApplication::PluginApplication(int& argc, char** argv)
     : UiApplication(argc, argv) {
@@ -89,9 +94,21 @@ PluginApplication::PluginApplication(int& argc, char** argv)
     auto userInputMapper = DependencyManager::get<UserInputMapper>();
     userInputMapper->registerDevice(_applicationStateDevice);
     userInputMapper->loadDefaultMapping(userInputMapper->getStandardDeviceID());
+
+    _inputSampler = new InputSampler(PluginManager::getInstance()->getInputPlugins(), INPUT_SAMPLE_RATE.get());
+    if (_inputSampler->hasPlugins()) {
+        _inputSampler->initialize(true, QThread::HighPriority);
+    }
 }
 
 void PluginApplication::cleanupBeforeQuit() {
+    if (_inputSampler) {
+        if (_inputSampler->hasPlugins()) {
+            _inputSampler->terminate();
+        }
+        delete _inputSampler;
+        _inputSampler = nullptr;
+    }
     getActiveDisplayPlugin()->deactivate();
     _applicationStateDevice.reset();
 }
@@ -159,7 +176,7 @@ void PluginApplication::submitGL() {
         return;
     }
 
-    PROFILE_RANGE(__FUNCTION__ "/pluginOutput");
+    PROFILE_RANGE("PluginApplication::submitGL/pluginOutput");
     _fboCache.lockTexture(finalTexture);
     _currentFramebuffer = nullptr;
     // deliver final scene to the display plugin
@@ -184,7 +201,7 @@ void PluginApplication::submitGL() {
         });
 
 
-        PROFILE_RANGE(__FUNCTION__ "/pluginSubmitScene");
+        PROFILE_RANGE("PluginApplication::submitGL/pluginSubmitScene");
         const auto size = _fboCache.getSize();
         displayPlugin->submitSceneTexture(getFrameCount(), finalTexture);
     }
@@ -238,9 +255,6 @@ void PluginApplication::idle() {
         return;
     }
 
-    // We're going to execute idle processing, so restart the last idle timer
-    _lastTimeUpdated.start();
-
     {
         getActiveDisplayPlugin()->idle();
         auto inputPlugins = PluginManager::getInstance()->getInputPlugins();
@@ -250,24 +264,26 @@ void PluginApplication::idle() {
             }
         }
     }
+    // Runs the simulation update with the clamped time since the last one, and restarts the idle timer
     UiApplication::idle();
 }
 
 void PluginApplication::update(float deltaTime) {
+    // Plugins which can't be sampled on their own thread are polled at the simulation rate
+    bool jointsCaptured = false;
+    for (auto inputPlugin : PluginManager::getInstance()->getInputPlugins()) {
+        if (inputPlugin->isActive() && !inputPlugin->supportsThreadedSampling()) {
+            inputPlugin->pluginUpdate(deltaTime, _inputCalibration, jointsCaptured);
+        }
+    }
+    if (_inputSampler) {
+        _inputSampler->setCalibration(_inputCalibration);
+    }
+
+    // Takes the latest sample published by each device
     auto userInputMapper = DependencyManager::get<UserInputMapper>();
     userInputMapper->update(deltaTime);
 
-    bool jointsCaptured = false;
-    static controller::InputCalibrationData calibration;
-    //for (auto inputPlugin : PluginManager::getInstance()->getInputPlugins()) {
-    //    if (inputPlugin->isActive()) {
-    //        inputPlugin->pluginUpdate(deltaTime, calibration, jointsCaptured);
-    //        if (inputPlugin->isJointController()) {
-    //            jointsCaptured = true;
-    //        }
-    //    }
-    //}
-
     controller::Pose leftHand = userInputMapper->getPoseState(controller::Action::LEFT_HAND);
     controller::Pose rightHand = userInputMapper->getPoseState(controller::Action::RIGHT_HAND);
     quint64 now = usecTimestampNow();
@@ -396,16 +412,24 @@ void PluginApplication::updateInputModes() {
         //}
     }
 
-    // A plugin was checked
-    if (newInputPlugins.size() > 0) {
-        foreach(auto newInputPlugin, newInputPlugins) {
-            newInputPlugin->activate();
+    // The sampler may be polling the plugins, so only change them between polls
+    auto updatePlugins = [&] {
+        // A plugin was checked
+        if (newInputPlugins.size() > 0) {
+            foreach(auto newInputPlugin, newInputPlugins) {
+                newInputPlugin->activate();
+            }
         }
-    }
-    if (removedInputPlugins.size() > 0) { // A plugin was unchecked
-        foreach(auto removedInputPlugin, removedInputPlugins) {
-            removedInputPlugin->deactivate();
+        if (removedInputPlugins.size() > 0) { // A plugin was unchecked
+            foreach(auto removedInputPlugin, removedInputPlugins) {
+                removedInputPlugin->deactivate();
+            }
         }
+    };
+    if (_inputSampler) {
+        _inputSampler->withSamplingPaused(updatePlugins);
+    } else {
+        updatePlugins();
     }
 }
 
@@ -420,6 +444,21 @@ void PluginApplication::setActiveDisplayPlugin(QString pluginName) {
     updateDisplayMode();
 }
 
+void PluginApplication::saveDisplayStats(const QString& path) {
+    auto displayPlugin = getActiveDisplayPlugin();
+    if (!displayPlugin) {
+        return;
+    }
+    QString statsPath = path;
+    if (statsPath.isEmpty()) {
+        auto desktop = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation);
+        statsPath = desktop + "/present-stats-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".json";
+    }
+    if (displayPlugin->savePresentStats(statsPath)) {
+        qDebug() << "Saved present stats to" << statsPath;
+    }
+}
+
 void PluginApplication::releaseSceneTexture(uint32_t texture) {
     _fboCache.releaseTexture(texture);
 }
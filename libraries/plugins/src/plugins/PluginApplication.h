@@ -28,8 +28,10 @@
 
 #include <gl/FboCache.h>
 #include <UiApplication.h>
+#include <controllers/Input.h>
 
 class OffscreenGLCanvas;
+class InputSampler;
 
 namespace controller {
     class StateController;
@@ -74,6 +76,8 @@ public slots:
     void resetSensors(bool andReload = false);
     void idle() override;
     void setActiveDisplayPlugin(QString);
+    // Saves the active display plugin's present statistics, by default to the desktop
+    void saveDisplayStats(const QString& path = QString());
 
 protected slots:
     void updateDisplayMode();
@@ -96,6 +100,9 @@ protected:
     DisplayPluginPointer _newDisplayPlugin;
     FboCache _fboCache;
     bool _pendingPaint { false };
+    // Polls the tracked controllers at their own rate, off the main thread
+    InputSampler* _inputSampler { nullptr };
+    controller::InputCalibrationData _inputCalibration;
 };
 
 #if defined(qApp)
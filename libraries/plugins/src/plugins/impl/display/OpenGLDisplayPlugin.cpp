@@ -7,9 +7,14 @@
 //
 #include "OpenGLDisplayPlugin.h"
 
+#include <chrono>
 #include <condition_variable>
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
 #include <QtCore/QThread>
 #include <QtCore/QTimer>
 
@@ -19,10 +24,11 @@
 #include <QOpenGLContext>
 
 #include <NumericalConstants.h>
+#include <SharedUtil.h>
 #include <DependencyManager.h>
 #include <shared/NsightHelpers.h>
 #include <gl/Config.h>
-#include <gl/GLEscrow.h>
+#include <gl/GLRingEscrow.h>
 #include <GLMHelpers.h>
 #include <CursorManager.h>
 #include "CompositorHelper.h"
@@ -30,15 +36,15 @@
 
 #include <gl/QOpenGLContextWrapper.h>
 #include <gl/Config.h>
-#include <gl/GLEscrow.h>
+#include <gl/GLRingEscrow.h>
+#include <gl/GLTraceRange.h>
 #include <gl/GLWindow.h>
 
 
 #if THREADED_PRESENT
 
-// FIXME, for display plugins that don't block on something like vsync, just 
-// cap the present rate at 200
-// const static unsigned int MAX_PRESENT_RATE = 200;
+// With no new frames, still present this often so the overlay and cursor stay live
+static const uint64_t MAX_IDLE_PRESENT_INTERVAL = USECS_PER_SECOND / 10;
 
 #include "../../PluginApplication.h"
 
@@ -66,6 +72,7 @@ public:
 
             Lock lock(_mutex);
             _shutdown = true;
+            wakeForControl();
             _condition.wait(lock, [&] { return !_shutdown;  });
             qDebug() << "Present thread shutdown";
         }
@@ -76,6 +83,7 @@ public:
         Lock lock(_mutex);
         if (isRunning()) {
             _newPluginQueue.push(plugin);
+            wakeForControl();
             _condition.wait(lock, [=]()->bool { return _newPluginQueue.empty(); });
         }
     }
@@ -85,6 +93,15 @@ public:
         _window->context()->moveToThread(this);
     }
 
+    // Called from the submitting thread whenever a plugin is handed a new texture
+    void frameSubmitted() {
+        {
+            Lock lock(_wakeMutex);
+            _framePending = true;
+        }
+        _wakeCondition.notify_one();
+    }
+
 
     virtual void run() override {
         OpenGLDisplayPlugin* currentPlugin{ nullptr };
@@ -142,13 +159,24 @@ public:
                 lock.unlock();
             }
 
-            // If there's no active plugin, just sleep
+            // If there's no active plugin, sleep until there's something to do
             if (currentPlugin == nullptr) {
-                // Minimum sleep ends up being about 2 ms anyway
-                QThread::msleep(1);
+                waitUntil(UINT64_MAX, false);
                 continue;
             }
 
+            // Plugins whose swap blocks on their runtime present as fast as it lets them,
+            // the rest wait for a new frame and then for the pacer
+            if (!currentPlugin->isSelfPaced()) {
+                auto now = usecTimestampNow();
+                if (!currentPlugin->hasPendingFrame() && !waitUntil(now + MAX_IDLE_PRESENT_INTERVAL, true)) {
+                    continue;
+                }
+                if (!waitUntil(currentPlugin->nextPresentTime(usecTimestampNow()), false)) {
+                    continue;
+                }
+            }
+
             // take the latest texture and present it
             _window->makeCurrent();
             if (QOpenGLContext::currentContext() == _window->context()->getContext()) {
@@ -175,6 +203,7 @@ public:
         Lock lock(_mutex);
         _pendingMainThreadOperation = true;
         _finishedMainThreadOperation = false;
+        wakeForControl();
         _condition.wait(lock, [&] { return !_pendingMainThreadOperation; });
 
         _window->makeCurrent();
@@ -196,6 +225,38 @@ private:
     void makeCurrent();
     void doneCurrent();
 
+    // Called with _mutex held, when the run loop has to handle a plugin change, a main
+    // thread operation or shutdown
+    void wakeForControl() {
+        {
+            Lock lock(_wakeMutex);
+            _controlPending = true;
+        }
+        _wakeCondition.notify_one();
+    }
+
+    // Sleeps until the deadline, a control wakeup, or if wakeForFrame is set, a new frame.
+    // Returns false if woken for control, in which case the caller should loop around.
+    bool waitUntil(uint64_t deadline, bool wakeForFrame) {
+        Lock lock(_wakeMutex);
+        auto woken = [&] { return _controlPending || (wakeForFrame && _framePending); };
+        auto now = usecTimestampNow();
+        if (deadline > now) {
+            if (deadline == UINT64_MAX) {
+                _wakeCondition.wait(lock, woken);
+            } else {
+                auto wakeTime = std::chrono::steady_clock::now() + std::chrono::microseconds(deadline - now);
+                _wakeCondition.wait_until(lock, wakeTime, woken);
+            }
+        }
+        _framePending = false;
+        if (_controlPending) {
+            _controlPending = false;
+            return false;
+        }
+        return true;
+    }
+
     bool _shutdown { false };
     Mutex _mutex;
     // Used to allow the main thread to perform context operations
@@ -203,6 +264,12 @@ private:
     bool _pendingMainThreadOperation { false };
     bool _finishedMainThreadOperation { false };
     QThread* _mainThread { nullptr };
+
+    // Wakes the run loop, only ever locked on its own or after _mutex
+    Mutex _wakeMutex;
+    Condition _wakeCondition;
+    bool _framePending { false };
+    bool _controlPending { false };
     std::queue<OpenGLDisplayPlugin*> _newPluginQueue;
     GLWindow* _window { nullptr };
     bool _hasShutdown { false };
@@ -335,6 +402,7 @@ void OpenGLDisplayPlugin::customizeContext() {
 
     _compositeFramebuffer = std::make_shared<BasicFramebufferWrapper>();
     _compositeFramebuffer->Init(getRecommendedRenderSize());
+    _compositeDirty = true;
 }
 
 void OpenGLDisplayPlugin::uncustomizeContext() {
@@ -401,6 +469,8 @@ void OpenGLDisplayPlugin::submitSceneTexture(uint32_t frameIndex, const gpu::Tex
     _sceneTextureEscrow.submit(sceneTexture);
 
 #if THREADED_PRESENT
+    static auto presentThread = DependencyManager::get<PresentThread>();
+    presentThread->frameSubmitted();
 #else
     static auto widget = _container->getPrimaryWidget();
     widget->makeCurrent();
@@ -412,20 +482,35 @@ void OpenGLDisplayPlugin::submitSceneTexture(uint32_t frameIndex, const gpu::Tex
 void OpenGLDisplayPlugin::submitOverlayTexture(const gpu::TexturePointer& overlayTexture) {
     // Submit it to the presentation thread via escrow
     _overlayTextureEscrow.submit(overlayTexture);
+#if THREADED_PRESENT
+    static auto presentThread = DependencyManager::get<PresentThread>();
+    presentThread->frameSubmitted();
+#endif
 }
 
 void OpenGLDisplayPlugin::updateTextures() {
+    _escrowDepthHistogram.record(_sceneTextureEscrow.depth());
     // FIXME intrduce a GPU wait instead of a CPU/GPU sync point?
 #if THREADED_PRESENT
     if (_sceneTextureEscrow.fetchSignaledAndRelease(_currentSceneTexture)) {
 #else
     if (_sceneTextureEscrow.fetchAndReleaseWithGpuWait(_currentSceneTexture)) {
 #endif
+        _newFrameSubmitTime = _sceneTextureEscrow.lastFetchedSubmitTime();
+        _compositeDirty = true;
         updateFrameData();
         _newFrameRate.increment();
     } 
 
-    _overlayTextureEscrow.fetchSignaledAndRelease(_currentOverlayTexture);
+    auto wastedFrameCount = _sceneTextureEscrow.getStats().wasted;
+    if (wastedFrameCount != _wastedFrameCount) {
+        _wastedFrameRate.increment(wastedFrameCount - _wastedFrameCount);
+        _wastedFrameCount = wastedFrameCount;
+    }
+
+    if (_overlayTextureEscrow.fetchSignaledAndRelease(_currentOverlayTexture)) {
+        _compositeDirty = true;
+    }
 }
 
 void OpenGLDisplayPlugin::updateFrameData() {
@@ -496,6 +581,25 @@ void OpenGLDisplayPlugin::compositeScene() {
     drawUnitQuad();
 }
 
+bool OpenGLDisplayPlugin::CompositeState::operator==(const CompositeState& other) const {
+    return renderSize == other.renderSize && surfaceSize == other.surfaceSize &&
+        overlayAlpha == other.overlayAlpha && reticleVisible == other.reticleVisible &&
+        reticlePosition == other.reticlePosition && reticleDepth == other.reticleDepth &&
+        cursorIcon == other.cursorIcon && presentPose == other.presentPose &&
+        presentReprojection == other.presentReprojection;
+}
+
+void OpenGLDisplayPlugin::updateCompositeState(CompositeState& state) {
+    auto compositorHelper = DependencyManager::get<CompositorHelper>();
+    state.renderSize = getRecommendedRenderSize();
+    state.surfaceSize = getSurfacePixels();
+    state.overlayAlpha = compositorHelper->getAlpha();
+    state.reticleVisible = compositorHelper->getReticleVisible();
+    state.reticlePosition = compositorHelper->getReticlePosition();
+    state.reticleDepth = compositorHelper->getReticleDepth();
+    state.cursorIcon = Cursor::Manager::instance().getCursor()->getIcon();
+}
+
 void OpenGLDisplayPlugin::compositeLayers() {
     using namespace oglplus;
     auto targetRenderSize = getRecommendedRenderSize();
@@ -544,12 +648,48 @@ void OpenGLDisplayPlugin::internalPresent() {
 void OpenGLDisplayPlugin::present() {
     incrementPresentCount();
     PROFILE_RANGE_EX(__FUNCTION__, 0xff00ff00, (uint64_t)presentCount())
+    _pacer.setTargetFrameRate(getTargetFrameRate());
+    _pacer.beginPresent(usecTimestampNow());
     updateTextures();
     if (_currentSceneTexture) {
-        // Write all layers to a local framebuffer
-        compositeLayers();
-        // Take the composite framebuffer and send it to the output device
-        internalPresent();
+        PROFILE_GPU_RANGE_EX("OpenGLDisplayPlugin::present", presentCount())
+        CompositeState compositeState;
+        updateCompositeState(compositeState);
+        bool presentSkipped = false;
+        if (_compositeDirty || !(compositeState == _compositeState)) {
+            // Write all layers to a local framebuffer
+            auto compositeStart = usecTimestampNow();
+            compositeLayers();
+            _compositeHistogram.record(usecTimestampNow() - compositeStart);
+            _compositeState = compositeState;
+            _compositeDirty = false;
+        } else {
+            ++_skippedCompositeCount;
+            _skippedCompositeRate.increment();
+            // The window already shows this composite.  HMD runtimes expect a
+            // submission every frame, so they're still handed the previous one.
+            presentSkipped = !isHmd();
+        }
+        bool vsynced = false;
+        if (presentSkipped) {
+            ++_skippedPresentCount;
+        } else {
+            // Take the composite framebuffer and send it to the output device
+            internalPresent();
+            vsynced = isVsyncEnabled();
+        }
+        // A skipped present still ends here, so the pacing and the stats see every frame.
+        // Nothing was swapped though, so it tells the pacer nothing about vsync.
+        auto now = usecTimestampNow();
+        _pacer.endPresent(now, vsynced);
+        if (_lastPresentTime) {
+            _frameIntervalHistogram.record(now - _lastPresentTime, now);
+        }
+        _lastPresentTime = now;
+        if (_newFrameSubmitTime) {
+            _latencyHistogram.record(now - _newFrameSubmitTime, now);
+            _newFrameSubmitTime = 0;
+        }
         _presentRate.increment();
         _activeProgram.reset();
     }
@@ -563,6 +703,88 @@ float OpenGLDisplayPlugin::droppedFrameRate() const {
     return _droppedFrameRate.rate();
 }
 
+float OpenGLDisplayPlugin::wastedFrameRate() const {
+    return _wastedFrameRate.rate();
+}
+
+float OpenGLDisplayPlugin::fenceWaitMsecs() const {
+    return (float)_sceneTextureEscrow.getStats().lastFenceWaitUsecs / USECS_PER_MSEC;
+}
+
+float OpenGLDisplayPlugin::presentJitterMsecs() const {
+    return _pacer.getJitterUsecs() / USECS_PER_MSEC;
+}
+
+static QVariantMap summarize(const Histogram::Snapshot& snapshot, float scale) {
+    QVariantMap result;
+    result["count"] = (qulonglong)snapshot.count();
+    result["mean"] = snapshot.mean() * scale;
+    result["p50"] = (float)snapshot.percentile(50.0f) * scale;
+    result["p90"] = (float)snapshot.percentile(90.0f) * scale;
+    result["p99"] = (float)snapshot.percentile(99.0f) * scale;
+    result["max"] = (float)snapshot.max() * scale;
+    return result;
+}
+
+QVariantMap OpenGLDisplayPlugin::presentStats(uint32_t windowSeconds) const {
+    static const float MSECS_PER_USEC = 1.0f / USECS_PER_MSEC;
+    auto now = usecTimestampNow();
+    QVariantMap result;
+    result["frameIntervalMsecs"] = summarize(_frameIntervalHistogram.snapshot(windowSeconds, now), MSECS_PER_USEC);
+    result["latencyMsecs"] = summarize(_latencyHistogram.snapshot(windowSeconds, now), MSECS_PER_USEC);
+    result["escrowDepth"] = summarize(_escrowDepthHistogram.snapshot(windowSeconds, now), 1.0f);
+    result["compositeMsecs"] = summarize(_compositeHistogram.snapshot(windowSeconds, now), MSECS_PER_USEC);
+    result["skippedComposites"] = (qulonglong)_skippedCompositeCount;
+    result["skippedPresents"] = (qulonglong)_skippedPresentCount;
+    return result;
+}
+
+bool OpenGLDisplayPlugin::savePresentStats(const QString& path) const {
+    auto now = usecTimestampNow();
+    auto histogramToJson = [&](const Histogram& histogram, const QString& unit) {
+        auto snapshot = histogram.snapshot(Histogram::INTERVALS, now);
+        QJsonObject result;
+        result["unit"] = unit;
+        result["summary"] = QJsonObject::fromVariantMap(summarize(snapshot, 1.0f));
+        result["lastSecond"] = QJsonObject::fromVariantMap(summarize(histogram.snapshot(1, now), 1.0f));
+        // [lowest, highest, count] for every bucket with values
+        QJsonArray buckets;
+        snapshot.forEachBucket([&](uint64_t lowest, uint64_t highest, uint64_t count) {
+            buckets.append(QJsonArray { (double)lowest, (double)highest, (double)count });
+        });
+        result["buckets"] = buckets;
+        return result;
+    };
+
+    QJsonObject root;
+    root["plugin"] = getName();
+    root["windowSeconds"] = (int)(Histogram::INTERVALS * Histogram::INTERVAL_USECS / USECS_PER_SECOND);
+    root["frameInterval"] = histogramToJson(_frameIntervalHistogram, "usecs");
+    root["latency"] = histogramToJson(_latencyHistogram, "usecs");
+    root["escrowDepth"] = histogramToJson(_escrowDepthHistogram, "frames");
+    root["composite"] = histogramToJson(_compositeHistogram, "usecs");
+
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        qWarning() << "Unable to save present stats to" << path;
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson());
+    return true;
+}
+
+float OpenGLDisplayPlugin::skippedCompositeRate() const {
+    return _skippedCompositeRate.rate();
+}
+
+bool OpenGLDisplayPlugin::hasPendingFrame() const {
+    return _sceneTextureEscrow.depth() > 0 || _overlayTextureEscrow.depth() > 0;
+}
+
+uint64_t OpenGLDisplayPlugin::nextPresentTime(uint64_t now) const {
+    return _pacer.nextPresentTime(now);
+}
+
 float OpenGLDisplayPlugin::presentRate() const {
     return _presentRate.rate();
 }
@@ -595,6 +817,7 @@ bool OpenGLDisplayPlugin::isVsyncEnabled() {
 
 void OpenGLDisplayPlugin::swapBuffers() {
     static auto window = qApp->getWindow();
+    _pacer.endWork(usecTimestampNow());
     window->swapBuffers();
 }
 
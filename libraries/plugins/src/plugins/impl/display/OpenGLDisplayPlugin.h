@@ -17,9 +17,12 @@
 
 #include <GLMHelpers.h>
 #include <gl/OglplusHelpers.h>
-#include <gl/GLEscrow.h>
+#include <gl/GLRingEscrow.h>
+#include <shared/Histogram.h>
 #include <shared/RateCounter.h>
 
+#include "PresentPacer.h"
+
 #define THREADED_PRESENT 1
 
 class OpenGLDisplayPlugin : public DisplayPlugin {
@@ -27,7 +30,7 @@ protected:
     using Mutex = std::mutex;
     using Lock = std::unique_lock<Mutex>;
     using Condition = std::condition_variable;
-    using TextureEscrow = GLEscrow<gpu::TexturePointer>;
+    using TextureEscrow = GLRingEscrow<gpu::TexturePointer>;
 public:
     static void shutdownPresentThread();
     OpenGLDisplayPlugin();
@@ -60,6 +63,18 @@ public:
 
     float droppedFrameRate() const override;
 
+    float wastedFrameRate() const override;
+
+    float fenceWaitMsecs() const override;
+
+    float presentJitterMsecs() const override;
+
+    float skippedCompositeRate() const override;
+
+    QVariantMap presentStats(uint32_t windowSeconds = 1) const override;
+
+    bool savePresentStats(const QString& path) const override;
+
 protected:
 #if THREADED_PRESENT
     friend class PresentThread;
@@ -103,6 +118,30 @@ protected:
 
     virtual void updateFrameData();
 
+    // Everything the composite depends on besides the scene and overlay textures,
+    // whose changes are tracked by updateTextures() fetching new ones
+    struct CompositeState {
+        glm::uvec2 renderSize;
+        glm::uvec2 surfaceSize;
+        float overlayAlpha { 0.0f };
+        bool reticleVisible { false };
+        glm::vec2 reticlePosition;
+        float reticleDepth { 0.0f };
+        uint16_t cursorIcon { 0 };
+        glm::mat4 presentPose;
+        glm::mat3 presentReprojection;
+
+        bool operator==(const CompositeState& other) const;
+    };
+    // Fills in the state the next composite would be made with
+    virtual void updateCompositeState(CompositeState& state);
+
+    // Self paced plugins present as soon as the previous present returns, as their swap
+    // blocks on the device runtime.  The rest are paced by _pacer.
+    virtual bool isSelfPaced() const { return false; }
+    bool hasPendingFrame() const;
+    uint64_t nextPresentTime(uint64_t now) const;
+
     ProgramPtr _program;
     int32_t _mvpUniform { -1 };
     int32_t _alphaUniform { -1 };
@@ -110,8 +149,25 @@ protected:
 
     mutable Mutex _mutex;
     RateCounter<> _droppedFrameRate;
+    RateCounter<> _wastedFrameRate;
+    uint64_t _wastedFrameCount { 0 };
     RateCounter<> _newFrameRate;
     RateCounter<> _presentRate;
+    RateCounter<> _skippedCompositeRate;
+    uint64_t _skippedCompositeCount { 0 };
+    uint64_t _skippedPresentCount { 0 };
+    PresentPacer _pacer;
+
+    // Recent distributions, see presentStats().  Times are in usecs.
+    Histogram _frameIntervalHistogram;
+    // From submitSceneTexture() to the end of the swap which presented the frame
+    Histogram _latencyHistogram;
+    // Scene textures waiting in the escrow at each present
+    Histogram _escrowDepthHistogram;
+    Histogram _compositeHistogram;
+    uint64_t _lastPresentTime { 0 };
+    // Set when a present has a new scene texture to measure the latency of
+    uint64_t _newFrameSubmitTime { 0 };
     QMap<gpu::TexturePointer, uint32_t> _sceneTextureToFrameIndexMap;
     uint32_t _currentPresentFrameIndex { 0 };
 
@@ -133,6 +189,9 @@ protected:
 
     std::map<uint16_t, CursorData> _cursorsData;
     BasicFramebufferWrapperPtr _compositeFramebuffer;
+    // The composite framebuffer doesn't match the current textures and state
+    bool _compositeDirty { true };
+    CompositeState _compositeState;
     bool _lockCurrentTexture { false };
 
 private:
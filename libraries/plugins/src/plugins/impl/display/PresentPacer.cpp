@@ -0,0 +1,105 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+#include "PresentPacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <NumericalConstants.h>
+
+// Assumed until swaps show otherwise
+static const float DEFAULT_FRAME_RATE = 60.0f;
+// Start presenting this long before the predicted vsync, on top of how long presents take
+static const float VSYNC_MARGIN_USECS = 1000.0f;
+// Weight of each new sample in the smoothed estimates
+static const float SMOOTHING = 1.0f / 16.0f;
+// Longer intervals mean presentation was idle, and don't count towards the jitter
+static const float MAX_JITTER_INTERVALS = 4.0f;
+
+void PresentPacer::setTargetFrameRate(float targetFrameRate) {
+    if (targetFrameRate <= 0.0f) {
+        targetFrameRate = DEFAULT_FRAME_RATE;
+    }
+    _targetIntervalUsecs = (float)USECS_PER_SECOND / targetFrameRate;
+    if (_vsyncPeriodUsecs <= 0.0f) {
+        _vsyncPeriodUsecs = _targetIntervalUsecs;
+    }
+}
+
+uint64_t PresentPacer::nextVsync(uint64_t now) const {
+    if (!_lastVsync || _vsyncPeriodUsecs <= 0.0f) {
+        return now;
+    }
+    auto periods = std::ceil((float)(now - _lastVsync) / _vsyncPeriodUsecs);
+    return _lastVsync + (uint64_t)(std::max(periods, 1.0f) * _vsyncPeriodUsecs);
+}
+
+uint64_t PresentPacer::nextPresentTime(uint64_t now) const {
+    if (!_lastPresentEnd) {
+        return now;
+    }
+    if (_vsynced) {
+        auto lead = (uint64_t)(_presentUsecs + VSYNC_MARGIN_USECS);
+        auto vsync = nextVsync(now);
+        // Too late for this vsync, the swap would block until the one after anyway
+        if (vsync < now + lead) {
+            vsync = nextVsync(vsync + 1);
+        }
+        return vsync - lead;
+    }
+    return std::max(now, _presentStart + (uint64_t)_targetIntervalUsecs);
+}
+
+void PresentPacer::beginPresent(uint64_t now) {
+    _scheduledStart = nextPresentTime(now);
+    _presentStart = now;
+    _workEnd = 0;
+    if (now > _scheduledStart) {
+        float lateness = (float)(now - _scheduledStart);
+        if (lateness > _maxLatenessUsecs.load(std::memory_order_relaxed)) {
+            _maxLatenessUsecs.store(lateness, std::memory_order_relaxed);
+        }
+    }
+}
+
+void PresentPacer::endWork(uint64_t now) {
+    _workEnd = now;
+}
+
+void PresentPacer::endPresent(uint64_t now, bool vsynced) {
+    // Presents which never reached a swap, such as skipped ones, say nothing about the cost
+    if (_workEnd) {
+        float presentUsecs = (float)(_workEnd - _presentStart);
+        _presentUsecs += (presentUsecs - _presentUsecs) * SMOOTHING;
+    }
+
+    if (_lastPresentEnd) {
+        float interval = (float)(now - _lastPresentEnd);
+        if (vsynced && _vsyncPeriodUsecs > 0.0f) {
+            // The interval spans a whole number of vsyncs
+            float periods = std::max(std::round(interval / _vsyncPeriodUsecs), 1.0f);
+            _vsyncPeriodUsecs += (interval / periods - _vsyncPeriodUsecs) * SMOOTHING;
+        }
+        if (interval > _targetIntervalUsecs * MAX_JITTER_INTERVALS) {
+            _lastIntervalUsecs = 0.0f;
+        } else {
+            if (_lastIntervalUsecs > 0.0f) {
+                float jitter = _jitterUsecs.load(std::memory_order_relaxed);
+                jitter += (std::abs(interval - _lastIntervalUsecs) - jitter) * SMOOTHING;
+                _jitterUsecs.store(jitter, std::memory_order_relaxed);
+            }
+            _lastIntervalUsecs = interval;
+        }
+    }
+
+    _vsynced = vsynced;
+    if (vsynced) {
+        _lastVsync = now;
+    }
+    _lastPresentEnd = now;
+}
@@ -0,0 +1,60 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// Decides when the present thread presents, for display plugins which aren't
+// paced by their own runtime.
+//
+// With vsync the present is put off until just before the predicted vsync, so it
+// picks up the newest frame that can still make that vsync.  The vsync period and
+// phase are predicted from when swaps complete, as a blocking swap returns just
+// after a vsync.  Without vsync, presents are spaced by the target frame rate.
+//
+// All but the stats must be called on the present thread.
+class PresentPacer {
+public:
+    void setTargetFrameRate(float targetFrameRate);
+
+    // The earliest time to start the next present, in usecs
+    uint64_t nextPresentTime(uint64_t now) const;
+
+    void beginPresent(uint64_t now);
+    // Called just before the swap, so the blocking swap doesn't count towards the cost of a present
+    void endWork(uint64_t now);
+    // Called once the swap returns, for the vsync phase and period
+    void endPresent(uint64_t now, bool vsynced);
+
+    // The mean deviation between consecutive present intervals, as in RFC 3550
+    float getJitterUsecs() const { return _jitterUsecs.load(std::memory_order_relaxed); }
+    // How late presents started, compared to when they were scheduled
+    float getMaxLatenessUsecs() const { return _maxLatenessUsecs.load(std::memory_order_relaxed); }
+    float getVsyncPeriodUsecs() const { return _vsyncPeriodUsecs; }
+
+private:
+    uint64_t nextVsync(uint64_t now) const;
+
+    float _targetIntervalUsecs { 0.0f };
+    bool _vsynced { false };
+    // Predicted from swap completions
+    float _vsyncPeriodUsecs { 0.0f };
+    uint64_t _lastVsync { 0 };
+    // How long a present takes before its swap, smoothed
+    float _presentUsecs { 0.0f };
+    // When the current present reached its swap, if it has
+    uint64_t _workEnd { 0 };
+
+    uint64_t _scheduledStart { 0 };
+    uint64_t _presentStart { 0 };
+    uint64_t _lastPresentEnd { 0 };
+    float _lastIntervalUsecs { 0.0f };
+    std::atomic<float> _jitterUsecs { 0.0f };
+    std::atomic<float> _maxLatenessUsecs { 0.0f };
+};
@@ -15,9 +15,12 @@
 #include <QtWidgets/QWidget>
 
 #include <GLMHelpers.h>
+#include <NumericalConstants.h>
+#include <SharedUtil.h>
 #include <CursorManager.h>
 #include <shared/NsightHelpers.h>
 #include <gl/GLWindow.h>
+#include <controllers/UserInputMapper.h>
 
 #include "../CompositorHelper.h"
 #include "../../../PluginApplication.h"
@@ -32,6 +35,14 @@ glm::uvec2 HmdDisplayPlugin::getRecommendedUiSize() const {
     return CompositorHelper::VIRTUAL_SCREEN_SIZE;
 }
 
+void HmdDisplayPlugin::setPoseTargetTime(double secondsFromNow) {
+    auto userInputMapper = DependencyManager::get<controller::UserInputMapper>();
+    if (userInputMapper) {
+        uint64_t now = usecTimestampNow();
+        userInputMapper->setPoseTargetTime(now + (uint64_t)(glm::max(secondsFromNow, 0.0) * USECS_PER_SECOND));
+    }
+}
+
 bool HmdDisplayPlugin::internalActivate() {
     //_monoPreview = _container->getBoolSetting("monoPreview", DEFAULT_MONO_VIEW);
 
@@ -214,9 +225,17 @@ void HmdDisplayPlugin::updatePresentPose() {
     _currentPresentFrameInfo.presentPose = _currentPresentFrameInfo.renderPose;
 }
 
-void HmdDisplayPlugin::compositeScene() {
+// The present pose is sampled once per present, and the composite only redone if it moved
+void HmdDisplayPlugin::updateCompositeState(CompositeState& state) {
     updatePresentPose();
+    Parent::updateCompositeState(state);
+    state.presentPose = _currentPresentFrameInfo.presentPose;
+    if (_enableReprojection) {
+        state.presentReprojection = _currentPresentFrameInfo.presentReprojection;
+    }
+}
 
+void HmdDisplayPlugin::compositeScene() {
     if (!_enableReprojection || glm::mat3() == _currentPresentFrameInfo.presentReprojection) {
         // No reprojection required
         Parent::compositeScene();
@@ -42,6 +42,11 @@ protected:
     void customizeContext() override;
     void uncustomizeContext() override;
     void updateFrameData() override;
+    void updateCompositeState(CompositeState& state) override;
+    // The HMD runtime blocks the swap until it's ready for the next frame
+    bool isSelfPaced() const override { return true; }
+    // Have controller poses predicted to when the frame being rendered will be displayed
+    void setPoseTargetTime(double secondsFromNow);
 
     std::array<glm::mat4, 2> _eyeOffsets;
     std::array<glm::mat4, 2> _eyeProjections;
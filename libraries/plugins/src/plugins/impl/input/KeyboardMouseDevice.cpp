@@ -37,67 +37,67 @@ void KeyboardMouseDevice::pluginUpdate(float deltaTime, const controller::InputC
 }
 
 void KeyboardMouseDevice::InputDevice::update(float deltaTime, const controller::InputCalibrationData& inputCalibrationData, bool jointsCaptured) {
-    _axisStateMap.clear();
+    clearAxes();
+    publishState();
 }
 
 void KeyboardMouseDevice::InputDevice::focusOutEvent() {
-    _buttonPressedMap.clear();
+    clearButtons();
+    publishState();
 }
 
 void KeyboardMouseDevice::keyPressEvent(QKeyEvent* event) {
     auto input = _inputDevice->makeInput((Qt::Key) event->key());
-    auto result = _inputDevice->_buttonPressedMap.insert(input.getChannel());
-    if (!result.second) {
-        // key pressed again ? without catching the release event ?
-    }
+    _inputDevice->setButton(input.getChannel(), true);
+    _inputDevice->publishState();
 }
 
 void KeyboardMouseDevice::keyReleaseEvent(QKeyEvent* event) {
     auto input = _inputDevice->makeInput((Qt::Key) event->key());
-    _inputDevice->_buttonPressedMap.erase(input.getChannel());
+    _inputDevice->setButton(input.getChannel(), false);
+    _inputDevice->publishState();
 }
 
 void KeyboardMouseDevice::mousePressEvent(QMouseEvent* event) {
     auto input = _inputDevice->makeInput((Qt::MouseButton) event->button());
-    auto result = _inputDevice->_buttonPressedMap.insert(input.getChannel());
-    if (!result.second) {
-        // key pressed again ? without catching the release event ?
-    }
+    _inputDevice->setButton(input.getChannel(), true);
     _lastCursor = event->pos();
     _mousePressTime = usecTimestampNow();
     _mouseMoved = false;
 
     eraseMouseClicked();
+    _inputDevice->publishState();
 }
 
 void KeyboardMouseDevice::mouseReleaseEvent(QMouseEvent* event) {
     auto input = _inputDevice->makeInput((Qt::MouseButton) event->button());
-    _inputDevice->_buttonPressedMap.erase(input.getChannel());
+    _inputDevice->setButton(input.getChannel(), false);
 
     // if we pressed and released at the same location within a small time window, then create a "_CLICKED" 
     // input for this button we might want to add some small tolerance to this so if you do a small drag it 
     // till counts as a clicked.
     static const int CLICK_TIME = USECS_PER_MSEC * 500; // 500 ms to click
     if (!_mouseMoved && (usecTimestampNow() - _mousePressTime < CLICK_TIME)) {
-        _inputDevice->_buttonPressedMap.insert(_inputDevice->makeInput((Qt::MouseButton) event->button(), true).getChannel());
+        _inputDevice->setButton(_inputDevice->makeInput((Qt::MouseButton) event->button(), true).getChannel(), true);
     }
+    _inputDevice->publishState();
 }
 
 void KeyboardMouseDevice::eraseMouseClicked() {
-    _inputDevice->_buttonPressedMap.erase(_inputDevice->makeInput(Qt::LeftButton, true).getChannel());
-    _inputDevice->_buttonPressedMap.erase(_inputDevice->makeInput(Qt::MiddleButton, true).getChannel());
-    _inputDevice->_buttonPressedMap.erase(_inputDevice->makeInput(Qt::RightButton, true).getChannel());
+    _inputDevice->setButton(_inputDevice->makeInput(Qt::LeftButton, true).getChannel(), false);
+    _inputDevice->setButton(_inputDevice->makeInput(Qt::MiddleButton, true).getChannel(), false);
+    _inputDevice->setButton(_inputDevice->makeInput(Qt::RightButton, true).getChannel(), false);
 }
 
 void KeyboardMouseDevice::mouseMoveEvent(QMouseEvent* event) {
     QPoint currentPos = event->pos();
     QPoint currentMove = currentPos - _lastCursor;
 
-    _inputDevice->_axisStateMap[MOUSE_AXIS_X_POS] = (currentMove.x() > 0 ? currentMove.x() : 0.0f);
-    _inputDevice->_axisStateMap[MOUSE_AXIS_X_NEG] = (currentMove.x() < 0 ? -currentMove.x() : 0.0f);
+    _inputDevice->setAxis(MOUSE_AXIS_X_POS, (currentMove.x() > 0 ? currentMove.x() : 0.0f));
+    _inputDevice->setAxis(MOUSE_AXIS_X_NEG, (currentMove.x() < 0 ? -currentMove.x() : 0.0f));
      // Y mouse is inverted positive is pointing up the screen
-    _inputDevice->_axisStateMap[MOUSE_AXIS_Y_POS] = (currentMove.y() < 0 ? -currentMove.y() : 0.0f);
-    _inputDevice->_axisStateMap[MOUSE_AXIS_Y_NEG] = (currentMove.y() > 0 ? currentMove.y() : 0.0f);
+    _inputDevice->setAxis(MOUSE_AXIS_Y_POS, (currentMove.y() < 0 ? -currentMove.y() : 0.0f));
+    _inputDevice->setAxis(MOUSE_AXIS_Y_NEG, (currentMove.y() > 0 ? currentMove.y() : 0.0f));
 
     // FIXME - this has the characteristic that it will show large jumps when you move the cursor
     // outside of the application window, because we don't get MouseEvents when the cursor is outside
@@ -106,15 +106,17 @@ void KeyboardMouseDevice::mouseMoveEvent(QMouseEvent* event) {
     _mouseMoved = true;
 
     eraseMouseClicked();
+    _inputDevice->publishState();
 }
 
 void KeyboardMouseDevice::wheelEvent(QWheelEvent* event) {
     auto currentMove = event->angleDelta() / 120.0f;
 
-    _inputDevice->_axisStateMap[_inputDevice->makeInput(MOUSE_AXIS_WHEEL_X_POS).getChannel()] = (currentMove.x() > 0 ? currentMove.x() : 0.0f);
-    _inputDevice->_axisStateMap[_inputDevice->makeInput(MOUSE_AXIS_WHEEL_X_NEG).getChannel()] = (currentMove.x() < 0 ? -currentMove.x() : 0.0f);
-    _inputDevice->_axisStateMap[_inputDevice->makeInput(MOUSE_AXIS_WHEEL_Y_POS).getChannel()] = (currentMove.y() > 0 ? currentMove.y() : 0.0f);
-    _inputDevice->_axisStateMap[_inputDevice->makeInput(MOUSE_AXIS_WHEEL_Y_NEG).getChannel()] = (currentMove.y() < 0 ? -currentMove.y() : 0.0f);
+    _inputDevice->setAxis(_inputDevice->makeInput(MOUSE_AXIS_WHEEL_X_POS).getChannel(), (currentMove.x() > 0 ? currentMove.x() : 0.0f));
+    _inputDevice->setAxis(_inputDevice->makeInput(MOUSE_AXIS_WHEEL_X_NEG).getChannel(), (currentMove.x() < 0 ? -currentMove.x() : 0.0f));
+    _inputDevice->setAxis(_inputDevice->makeInput(MOUSE_AXIS_WHEEL_Y_POS).getChannel(), (currentMove.y() > 0 ? currentMove.y() : 0.0f));
+    _inputDevice->setAxis(_inputDevice->makeInput(MOUSE_AXIS_WHEEL_Y_NEG).getChannel(), (currentMove.y() < 0 ? -currentMove.y() : 0.0f));
+    _inputDevice->publishState();
 }
 
 glm::vec2 evalAverageTouchPoints(const QList<QTouchEvent::TouchPoint>& points) {
@@ -149,14 +151,15 @@ void KeyboardMouseDevice::touchUpdateEvent(const QTouchEvent* event) {
     } else {
         auto currentMove = currentPos - _lastTouch;
     
-        _inputDevice->_axisStateMap[_inputDevice->makeInput(TOUCH_AXIS_X_POS).getChannel()] = (currentMove.x > 0 ? currentMove.x : 0.0f);
-        _inputDevice->_axisStateMap[_inputDevice->makeInput(TOUCH_AXIS_X_NEG).getChannel()] = (currentMove.x < 0 ? -currentMove.x : 0.0f);
+        _inputDevice->setAxis(_inputDevice->makeInput(TOUCH_AXIS_X_POS).getChannel(), (currentMove.x > 0 ? currentMove.x : 0.0f));
+        _inputDevice->setAxis(_inputDevice->makeInput(TOUCH_AXIS_X_NEG).getChannel(), (currentMove.x < 0 ? -currentMove.x : 0.0f));
         // Y mouse is inverted positive is pointing up the screen
-        _inputDevice->_axisStateMap[_inputDevice->makeInput(TOUCH_AXIS_Y_POS).getChannel()] = (currentMove.y < 0 ? -currentMove.y : 0.0f);
-        _inputDevice->_axisStateMap[_inputDevice->makeInput(TOUCH_AXIS_Y_NEG).getChannel()] = (currentMove.y > 0 ? currentMove.y : 0.0f);
+        _inputDevice->setAxis(_inputDevice->makeInput(TOUCH_AXIS_Y_POS).getChannel(), (currentMove.y < 0 ? -currentMove.y : 0.0f));
+        _inputDevice->setAxis(_inputDevice->makeInput(TOUCH_AXIS_Y_NEG).getChannel(), (currentMove.y > 0 ? currentMove.y : 0.0f));
     }
 
     _lastTouch = currentPos;
+    _inputDevice->publishState();
 }
 
 controller::Input KeyboardMouseDevice::InputDevice::makeInput(Qt::Key code) const {
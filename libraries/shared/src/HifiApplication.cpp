@@ -8,11 +8,13 @@
 
 #include "HifiApplication.h"
 
+#include <QtCore/QDateTime>
 #include <QtCore/QDebug>
 #include <QtCore/QObject>
 #include <QtCore/QUrl>
 #include <QtCore/QTimer>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QStandardPaths>
 
 #ifdef Q_OS_WIN
 #include <Windows.h>
@@ -25,6 +27,7 @@
 #include "SettingHandle.h"
 #include "LogHandler.h"
 #include "PathUtils.h"
+#include "shared/Tracer.h"
 
 Q_LOGGING_CATEGORY(interfaceapp, "hifi.interface")
 Q_LOGGING_CATEGORY(interfaceapp_timing, "hifi.interface.timing")
@@ -87,6 +90,11 @@ HifiApplication::HifiApplication(int& argc, char** argv) : QGuiApplication(argc,
 }
 
 void HifiApplication::aboutToQuit() {
+    // HIFI_TRACE can name the file to save the trace to on exit
+    auto tracePath = QString::fromLocal8Bit(qgetenv("HIFI_TRACE"));
+    if (Tracer::isEnabled() && tracePath.endsWith(".json")) {
+        saveTrace(tracePath);
+    }
     emit beforeAboutToQuit();
     _aboutToQuit = true;
     cleanupBeforeQuit();
@@ -142,6 +150,19 @@ void HifiApplication::activeChanged(Qt::ApplicationState state) {
 void HifiApplication::postLambdaEvent(std::function<void()> f) {
 }
 
+void HifiApplication::saveTrace(const QString& path) {
+    if (!Tracer::isEnabled()) {
+        qCDebug(interfaceapp) << "Tracing is disabled, set HIFI_TRACE to enable it";
+        return;
+    }
+    QString tracePath = path;
+    if (tracePath.isEmpty()) {
+        auto desktop = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation);
+        tracePath = desktop + "/trace-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".json";
+    }
+    Tracer::save(tracePath);
+}
+
 void HifiApplication::crashApplication() {
     qCDebug(interfaceapp) << "Intentionally crashed Interface";
     int* value = nullptr;
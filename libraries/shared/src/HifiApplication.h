@@ -52,6 +52,8 @@ signals:
 
 public slots:
     void crashApplication();
+    // Saves the ranges recorded so far as a Chrome trace, by default to the desktop
+    void saveTrace(const QString& path = QString());
 
 protected slots:
     virtual void idle();
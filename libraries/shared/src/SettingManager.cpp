@@ -12,6 +12,7 @@
 #include <QThread>
 #include <QDebug>
 
+#include "shared/NsightHelpers.h"
 #include "SettingInterface.h"
 #include "SettingManager.h"
 
@@ -70,6 +71,7 @@ namespace Setting {
     }
 
     void Manager::saveAll() {
+        PROFILE_RANGE(__FUNCTION__);
         for (auto handle : _handles) {
             saveSetting(handle);
         }
@@ -0,0 +1,114 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "Histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+static uint32_t floorLog2(uint64_t value) {
+    uint32_t result = 0;
+    while (value >>= 1) {
+        ++result;
+    }
+    return result;
+}
+
+uint32_t Histogram::bucketIndex(uint64_t value) {
+    if (value > MAX_VALUE) {
+        value = MAX_VALUE;
+    }
+    if (value < 2 * SUB_BUCKETS) {
+        return (uint32_t)value;
+    }
+    auto shift = floorLog2(value) - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + (uint32_t)(value >> shift) - SUB_BUCKETS;
+}
+
+uint64_t Histogram::lowestValue(uint32_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    auto shift = index / SUB_BUCKETS - 1;
+    return (uint64_t)(index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+}
+
+uint64_t Histogram::highestValue(uint32_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    auto shift = index / SUB_BUCKETS - 1;
+    return lowestValue(index) + (1ull << shift) - 1;
+}
+
+uint64_t Histogram::Snapshot::percentile(float percent) const {
+    if (!_count) {
+        return 0;
+    }
+    auto target = (uint64_t)std::ceil((double)percent / 100.0 * (double)_count);
+    target = std::max<uint64_t>(target, 1);
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < BUCKETS; ++i) {
+        seen += _counts[i];
+        if (seen >= target) {
+            return std::min(highestValue(i), _max);
+        }
+    }
+    return _max;
+}
+
+void Histogram::record(uint64_t value, uint64_t now) {
+    const uint64_t number = now / INTERVAL_USECS + 1;
+    auto& interval = _intervals[number % INTERVALS];
+    auto current = interval.number.load(std::memory_order_acquire);
+    if (current != number) {
+        // Values stamped before the interval in this slot was reused are dropped
+        if (current > number) {
+            return;
+        }
+        // Whoever moves the slot on to the new interval clears it
+        if (interval.number.compare_exchange_strong(current, number, std::memory_order_acq_rel)) {
+            for (auto& count : interval.counts) {
+                count.store(0, std::memory_order_relaxed);
+            }
+            interval.sum.store(0, std::memory_order_relaxed);
+            interval.max.store(0, std::memory_order_relaxed);
+        } else if (current != number) {
+            return;
+        }
+    }
+
+    interval.counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    interval.sum.fetch_add(value, std::memory_order_relaxed);
+    auto max = interval.max.load(std::memory_order_relaxed);
+    while (value > max && !interval.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+Histogram::Snapshot Histogram::snapshot(uint32_t intervals, uint64_t now) const {
+    const uint64_t newest = now / INTERVAL_USECS + 1;
+    intervals = intervals < 1 ? 1 : (intervals > INTERVALS ? INTERVALS : intervals);
+    const uint64_t oldest = newest - intervals + 1;
+
+    Snapshot result;
+    result._counts.resize(BUCKETS, 0);
+    for (const auto& interval : _intervals) {
+        auto number = interval.number.load(std::memory_order_acquire);
+        if (number < oldest || number > newest) {
+            continue;
+        }
+        for (uint32_t i = 0; i < BUCKETS; ++i) {
+            auto count = interval.counts[i].load(std::memory_order_relaxed);
+            result._counts[i] += count;
+            result._count += count;
+        }
+        result._sum += interval.sum.load(std::memory_order_relaxed);
+        result._max = std::max(result._max, interval.max.load(std::memory_order_relaxed));
+    }
+    return result;
+}
@@ -0,0 +1,87 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_Shared_Histogram_h
+#define hifi_Shared_Histogram_h
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#include "../SharedUtil.h"
+#include "../NumericalConstants.h"
+
+// Distribution of recent values, for percentiles rather than just averages.
+//
+// Buckets are laid out as in HdrHistogram: values below 2 * SUB_BUCKETS get a
+// bucket each, and each power of two above that is split into SUB_BUCKETS
+// linear buckets, so any value is reported to within about 3%.  Values are
+// recorded into one of a ring of intervals by the time they were recorded,
+// and snapshots are taken over the most recent of them, giving a sliding
+// window of up to INTERVALS seconds.
+//
+// Recording is lock free and can happen on any thread.  A value recorded
+// concurrently with the first value of a new interval may be lost.
+class Histogram {
+public:
+    static const uint32_t SUB_BUCKET_BITS = 5;
+    static const uint32_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // Larger values are recorded as this
+    static const uint64_t MAX_VALUE = UINT32_MAX;
+    static const uint32_t BUCKETS = (32 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+    static const uint64_t INTERVAL_USECS = USECS_PER_SECOND;
+    static const uint32_t INTERVALS = 10;
+
+    class Snapshot {
+    public:
+        uint64_t count() const { return _count; }
+        uint64_t max() const { return _max; }
+        float mean() const { return _count ? (float)((double)_sum / (double)_count) : 0.0f; }
+        // The highest value in the bucket holding the given percentile, or 0 if nothing was recorded
+        uint64_t percentile(float percent) const;
+
+        // Calls f(lowestValue, highestValue, count) for every bucket with values, in order
+        template <typename F>
+        void forEachBucket(F f) const {
+            for (uint32_t i = 0; i < BUCKETS; ++i) {
+                if (_counts[i]) {
+                    f(lowestValue(i), highestValue(i), _counts[i]);
+                }
+            }
+        }
+
+    private:
+        friend class Histogram;
+        std::vector<uint64_t> _counts;
+        uint64_t _count { 0 };
+        uint64_t _sum { 0 };
+        uint64_t _max { 0 };
+    };
+
+    static uint32_t bucketIndex(uint64_t value);
+    static uint64_t lowestValue(uint32_t index);
+    static uint64_t highestValue(uint32_t index);
+
+    void record(uint64_t value, uint64_t now = usecTimestampNow());
+    // Covers the current interval and the intervals - 1 before it
+    Snapshot snapshot(uint32_t intervals = INTERVALS, uint64_t now = usecTimestampNow()) const;
+
+private:
+    struct Interval {
+        // Which interval since the epoch the counts belong to, plus one so zero is never current
+        std::atomic<uint64_t> number { 0 };
+        std::atomic<uint64_t> sum { 0 };
+        std::atomic<uint64_t> max { 0 };
+        std::atomic<uint32_t> counts[BUCKETS] {};
+    };
+
+    Interval _intervals[INTERVALS];
+};
+
+#endif
@@ -8,16 +8,24 @@
 
 #include "NsightHelpers.h"
 
-#ifdef _WIN32
-#if defined(NSIGHT_FOUND)
+#include "Tracer.h"
+
+#if defined(_WIN32) && defined(NSIGHT_FOUND)
 #include "nvToolsExt.h"
+#endif
 
-ProfileRange::ProfileRange(const char *name) {
+ProfileRange::ProfileRange(const char *name) : _name(name) {
+#if defined(_WIN32) && defined(NSIGHT_FOUND)
     nvtxRangePush(name);
+#endif
+    if (Tracer::isEnabled()) {
+        _begin = Tracer::nowNsecs();
+    }
 }
 
-ProfileRange::ProfileRange(const char *name, uint32_t argbColor, uint64_t payload) {
-
+ProfileRange::ProfileRange(const char *name, uint32_t argbColor, uint64_t payload) :
+    _name(name), _payload(payload), _flags(Tracer::HAS_PAYLOAD) {
+#if defined(_WIN32) && defined(NSIGHT_FOUND)
     nvtxEventAttributes_t eventAttrib = {0};
     eventAttrib.version = NVTX_VERSION;
     eventAttrib.size = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
@@ -29,15 +37,18 @@ ProfileRange::ProfileRange(const char *name, uint32_t argbColor, uint64_t payloa
     eventAttrib.payloadType = NVTX_PAYLOAD_TYPE_UNSIGNED_INT64;
 
     nvtxRangePushEx(&eventAttrib);
+#endif
+    if (Tracer::isEnabled()) {
+        _begin = Tracer::nowNsecs();
+    }
 }
 
 ProfileRange::~ProfileRange() {
+#if defined(_WIN32) && defined(NSIGHT_FOUND)
     nvtxRangePop();
-}
-
-#else
-ProfileRange::ProfileRange(const char *name) {}
-ProfileRange::ProfileRange(const char *name, uint32_t argbColor, uint64_t payload) {}
-ProfileRange::~ProfileRange() {}
 #endif
-#endif // _WIN32
+    // Ranges begun before tracing was enabled aren't recorded
+    if (_begin) {
+        Tracer::record(_name, _begin, Tracer::nowNsecs(), _payload, _flags);
+    }
+}
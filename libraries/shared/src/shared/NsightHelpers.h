@@ -9,21 +9,23 @@
 #ifndef hifi_gl_NsightHelpers_h
 #define hifi_gl_NsightHelpers_h
 
-#ifdef _WIN32
 #include <stdint.h>
 
+// Times the enclosing scope for the built in Tracer, and for Nsight where available
 class ProfileRange {
 public:
     ProfileRange(const char *name);
     ProfileRange(const char *name, uint32_t argbColor, uint64_t payload);
     ~ProfileRange();
+
+private:
+    const char* _name;
+    uint64_t _payload { 0 };
+    uint64_t _begin { 0 };
+    uint8_t _flags { 0 };
 };
 
 #define PROFILE_RANGE(name) ProfileRange profileRangeThis(name);
 #define PROFILE_RANGE_EX(name, argbColor, payload) ProfileRange profileRangeThis(name, argbColor, (uint64_t)payload);
-#else
-#define PROFILE_RANGE(name)
-#define PROFILE_RANGE_EX(name, argbColor, payload)
-#endif
 
 #endif
@@ -0,0 +1,201 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "Tracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QThread>
+
+#include "../SharedLogging.h"
+
+std::atomic<bool> Tracer::_enabled { qEnvironmentVariableIsSet("HIFI_TRACE") };
+
+namespace {
+    struct Event {
+        const char* name { nullptr };
+        uint64_t begin { 0 };
+        uint64_t end { 0 };
+        uint64_t payload { 0 };
+        uint8_t flags { 0 };
+    };
+
+    // Written only by its own thread, read by whichever thread saves the trace
+    struct ThreadBuffer {
+        ThreadBuffer(uint32_t id, const QString& name) : id(id), name(name), events(Tracer::EVENTS_PER_THREAD) {}
+
+        const uint32_t id;
+        const QString name;
+        std::vector<Event> events;
+        std::atomic<uint64_t> written { 0 };
+    };
+
+    using Mutex = std::mutex;
+    using Lock = std::unique_lock<Mutex>;
+
+    // Buffers are kept after their thread exits, so its events still make it into a save
+    Mutex& buffersMutex() {
+        static Mutex mutex;
+        return mutex;
+    }
+
+    std::vector<std::unique_ptr<ThreadBuffer>>& buffers() {
+        static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        return buffers;
+    }
+
+    thread_local ThreadBuffer* threadBuffer { nullptr };
+
+    ThreadBuffer* getThreadBuffer() {
+        if (!threadBuffer) {
+            Lock lock(buffersMutex());
+            auto& allBuffers = buffers();
+            uint32_t id = (uint32_t)allBuffers.size() + 1;
+            QString name = QThread::currentThread()->objectName();
+            if (name.isEmpty()) {
+                name = QString("Thread %1").arg(id);
+            }
+            allBuffers.emplace_back(new ThreadBuffer(id, name));
+            threadBuffer = allBuffers.back().get();
+        }
+        return threadBuffer;
+    }
+
+    // Copies out the events which can't have been overwritten while copying
+    std::vector<Event> copyEvents(const ThreadBuffer& buffer) {
+        static const uint64_t CAPACITY = Tracer::EVENTS_PER_THREAD;
+        std::vector<Event> result;
+        auto end = buffer.written.load(std::memory_order_acquire);
+        auto begin = end > CAPACITY ? end - CAPACITY : 0;
+        result.reserve(end - begin);
+        for (auto i = begin; i < end; ++i) {
+            result.push_back(buffer.events[i & (CAPACITY - 1)]);
+        }
+        // The writer may have wrapped around onto the oldest events, and be part way through another
+        auto written = buffer.written.load(std::memory_order_acquire) + 1;
+        auto overwritten = written > CAPACITY ? written - CAPACITY : 0;
+        if (overwritten > begin) {
+            result.erase(result.begin(), result.begin() + std::min(overwritten - begin, (uint64_t)result.size()));
+        }
+        return result;
+    }
+
+    void appendEscaped(QByteArray& output, const char* name) {
+        for (auto c = name; *c; ++c) {
+            if (*c == '"' || *c == '\\') {
+                output.append('\\');
+            }
+            output.append(*c);
+        }
+    }
+
+    void appendThreadName(QByteArray& output, uint64_t tid, const QString& name) {
+        output.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+        output.append(QByteArray::number((qulonglong)tid));
+        output.append(",\"args\":{\"name\":\"");
+        appendEscaped(output, name.toUtf8().constData());
+        output.append("\"}},\n");
+    }
+}
+
+void Tracer::setEnabled(bool enabled) {
+    _enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t Tracer::nowNsecs() {
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char* name, uint64_t beginNsecs, uint64_t endNsecs, uint64_t payload, uint8_t flags) {
+    auto buffer = getThreadBuffer();
+    auto index = buffer->written.load(std::memory_order_relaxed);
+    auto& event = buffer->events[index & (EVENTS_PER_THREAD - 1)];
+    event.name = name;
+    event.begin = beginNsecs;
+    event.end = std::max(beginNsecs, endNsecs);
+    event.payload = payload;
+    event.flags = flags;
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+bool Tracer::save(const QString& path) {
+    struct ThreadEvents {
+        uint32_t id;
+        QString name;
+        std::vector<Event> events;
+    };
+
+    std::vector<ThreadEvents> threads;
+    {
+        Lock lock(buffersMutex());
+        for (const auto& buffer : buffers()) {
+            threads.push_back({ buffer->id, buffer->name, copyEvents(*buffer) });
+        }
+    }
+
+    // Timestamps are written relative to the earliest event, in fractional microseconds
+    uint64_t epoch = UINT64_MAX;
+    for (const auto& thread : threads) {
+        for (const auto& event : thread.events) {
+            epoch = std::min(epoch, event.begin);
+        }
+    }
+
+    QByteArray output;
+    output.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    size_t count = 0;
+    for (const auto& thread : threads) {
+        // GPU ranges go on their own track, next to the issuing thread
+        const uint64_t cpuTid = thread.id * 2;
+        const uint64_t gpuTid = cpuTid + 1;
+        appendThreadName(output, cpuTid, thread.name);
+        bool hasGpuEvents = false;
+        for (const auto& event : thread.events) {
+            bool gpu = (event.flags & GPU) != 0;
+            hasGpuEvents |= gpu;
+            output.append("{\"name\":\"");
+            appendEscaped(output, event.name);
+            output.append(gpu ? "\",\"cat\":\"gpu\"" : "\",\"cat\":\"cpu\"");
+            output.append(",\"ph\":\"X\",\"pid\":1,\"tid\":");
+            output.append(QByteArray::number((qulonglong)(gpu ? gpuTid : cpuTid)));
+            output.append(",\"ts\":");
+            output.append(QByteArray::number((double)(event.begin - epoch) / 1000.0, 'f', 3));
+            output.append(",\"dur\":");
+            output.append(QByteArray::number((double)(event.end - event.begin) / 1000.0, 'f', 3));
+            if (event.flags & HAS_PAYLOAD) {
+                output.append(",\"args\":{\"frame\":");
+                output.append(QByteArray::number((qulonglong)event.payload));
+                output.append("}");
+            }
+            output.append("},\n");
+        }
+        if (hasGpuEvents) {
+            appendThreadName(output, gpuTid, thread.name + " (GPU)");
+        }
+        count += thread.events.size();
+    }
+    // Trailing metadata entry, so every event above can end with a comma
+    output.append("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"");
+    appendEscaped(output, QCoreApplication::applicationName().toUtf8().constData());
+    output.append("\"}}\n]}\n");
+
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(output) != output.size()) {
+        qCWarning(shared) << "Unable to save trace to" << path;
+        return false;
+    }
+    qCDebug(shared) << "Saved" << count << "trace events from" << threads.size() << "threads to" << path;
+    return true;
+}
@@ -0,0 +1,58 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_Shared_Tracer_h
+#define hifi_Shared_Tracer_h
+
+#include <stdint.h>
+#include <atomic>
+
+#include <QtCore/QString>
+
+// Records timed ranges from any thread, to be saved as a Chrome trace
+// (chrome://tracing, or ui.perfetto.dev) on demand.
+//
+// Each thread writes into its own fixed size ring of events, so recording takes
+// no locks and allocates nothing past a thread's first event.  Once a ring is
+// full the oldest events are overwritten, so a save covers the most recent
+// EVENTS_PER_THREAD ranges of each thread.  Names must outlive the tracer,
+// which in practice means string literals or __FUNCTION__.
+//
+// Recording is off until enabled, either by setEnabled() or by setting the
+// HIFI_TRACE environment variable before startup.
+class Tracer {
+public:
+    static const uint32_t EVENTS_PER_THREAD = 1 << 16;
+
+    enum Flags : uint8_t {
+        NONE = 0,
+        // Shown on a separate track alongside the thread that issued it
+        GPU = 1 << 0,
+        // The payload is saved with the range, typically a frame index
+        HAS_PAYLOAD = 1 << 1,
+    };
+
+    static bool isEnabled() { return _enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+
+    // Monotonic time in nanoseconds, the time base of every recorded range
+    static uint64_t nowNsecs();
+
+    // Records a range on the calling thread
+    static void record(const char* name, uint64_t beginNsecs, uint64_t endNsecs,
+        uint64_t payload = 0, uint8_t flags = NONE);
+
+    // Writes every thread's events as Chrome trace JSON, returns false if the file can't be written
+    static bool save(const QString& path);
+
+private:
+    static std::atomic<bool> _enabled;
+};
+
+#endif
@@ -23,15 +23,16 @@
 
 #include <gl/OglplusHelpers.h>
 #include <gl/OffscreenGLCanvas.h>
-#include <gl/GLEscrow.h>
+#include <gl/GLRingEscrow.h>
 
 #include <DependencyManager.h>
 #include <NumericalConstants.h>
 #include <Finally.h>
 
 #include <gl/OffscreenGLCanvas.h>
-#include <gl/GLEscrow.h>
+#include <gl/GLRingEscrow.h>
 #include <gl/GLHelpers.h>
+#include <gl/GLTraceRange.h>
 
 #define THREADED_QML 1
 
@@ -112,7 +113,7 @@ private:
     FramebufferPtr _fbo;
     RenderbufferPtr _depthStencil;
     TextureRecycler _textures;
-    GLTextureEscrow _escrow;
+    GLTextureRingEscrow _escrow;
 
     uint64_t _lastRenderTime{ 0 };
     uvec2 _size{ 1920, 1080 };
@@ -323,6 +324,7 @@ void OffscreenQmlRenderThread::render() {
 
         {
             PROFILE_RANGE("qml_render->rendercontrol")
+            PROFILE_GPU_RANGE("qml_render->rendercontrol")
             _renderControl->render();
             // FIXME The web browsers seem to be leaving GL in an error state.
             // Need a debug context with sync logging to figure out why.
@@ -566,8 +568,14 @@ void OffscreenQmlSurface::updateQuick() {
         _render = false;
     }
 
+    // Fetches and releases are serialized by the lock, as the escrow requires
     uint32_t newTexture;
-    if (_renderer->_escrow.fetchSignaled(newTexture)) {
+    bool fetched;
+    {
+        Lock lock(_mutex);
+        fetched = _renderer->_escrow.fetchSignaled(newTexture);
+    }
+    if (fetched) {
         emit textureUpdated(newTexture);
 
         Lock lock(_mutex);
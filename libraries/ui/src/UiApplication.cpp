@@ -44,8 +44,6 @@ UiApplication::UiApplication(int& argc, char** argv) : GLApplication(argc, argv)
 
     // Setup the userInputMapper with the actions
     auto userInputMapper = DependencyManager::set<UserInputMapper>();
-    connect(userInputMapper.data(), &UserInputMapper::actionEvent, [this](int action, float state) {
-    });
     //// A new controllerInput device used to reflect current values from the application state
     //_applicationStateDevice = std::make_shared<controller::StateController>();
     //_applicationStateDevice->addInputVariant(QString("InHMD"), controller::StateController::ReadLambda([this]() -> float {
@@ -139,6 +139,7 @@ void OpenVrDisplayPlugin::beginFrameRender(uint32_t frameIndex) {
 #else
     _currentRenderFrameInfo.predictedDisplayTime = frameDuration + vsyncToPhotons;
 #endif
+    setPoseTargetTime(_currentRenderFrameInfo.predictedDisplayTime);
 
     _system->GetDeviceToAbsoluteTrackingPose(vr::TrackingUniverseStanding, _currentRenderFrameInfo.predictedDisplayTime, _trackedDevicePose, vr::k_unMaxTrackedDeviceCount);
 
@@ -138,7 +138,8 @@ void ViveControllerManager::deactivate() {
         _system = nullptr;
     }
 
-    _inputDevice->_poseStateMap.clear();
+    _inputDevice->clearPoses();
+    _inputDevice->publishState();
 
     // unregister with UserInputMapper
     auto userInputMapper = DependencyManager::get<controller::UserInputMapper>();
@@ -160,8 +161,8 @@ void ViveControllerManager::updateRendering(RenderArgs* args, render::ScenePoint
         //pendingChanges.updateItem(_leftHandRenderID, );
 
 
-        controller::Pose leftHand = _inputDevice->_poseStateMap[controller::StandardPoseChannel::LEFT_HAND];
-        controller::Pose rightHand = _inputDevice->_poseStateMap[controller::StandardPoseChannel::RIGHT_HAND];
+        controller::Pose leftHand = _inputDevice->getPendingPose(controller::StandardPoseChannel::LEFT_HAND);
+        controller::Pose rightHand = _inputDevice->getPendingPose(controller::StandardPoseChannel::RIGHT_HAND);
 
         gpu::doInBatch(args->_context, [=](gpu::Batch& batch) {
             auto geometryCache = DependencyManager::get<GeometryCache>();
@@ -212,24 +213,37 @@ void ViveControllerManager::renderHand(const controller::Pose& pose, gpu::Batch&
 
 void ViveControllerManager::pluginUpdate(float deltaTime, const controller::InputCalibrationData& inputCalibrationData, bool jointsCaptured) {
     _inputDevice->update(deltaTime, inputCalibrationData, jointsCaptured);
-    auto userInputMapper = DependencyManager::get<controller::UserInputMapper>();
 
-    if (_inputDevice->_trackedControllers == 0 && _registeredWithInputMapper) {
-        userInputMapper->removeDevice(_inputDevice->_deviceID);
-        _registeredWithInputMapper = false;
-        _inputDevice->_poseStateMap.clear();
+    // This runs on the input sampler thread, but registering and removing the device
+    // loads mappings and signals hardware changes, so that's left to the main thread
+    bool tracked = _inputDevice->_trackedControllers > 0;
+    if (tracked != _registeredWithInputMapper && !_registrationQueued.exchange(true)) {
+        QMetaObject::invokeMethod(this, "updateRegistration", Qt::QueuedConnection, Q_ARG(bool, tracked));
     }
+}
 
-    if (!_registeredWithInputMapper && _inputDevice->_trackedControllers > 0) {
+void ViveControllerManager::updateRegistration(bool tracked) {
+    _registrationQueued = false;
+    // Deactivation may have removed the device since this was queued
+    if (!isActive() || tracked == _registeredWithInputMapper) {
+        return;
+    }
+
+    auto userInputMapper = DependencyManager::get<controller::UserInputMapper>();
+    if (tracked) {
         userInputMapper->registerDevice(_inputDevice);
         _registeredWithInputMapper = true;
         UserActivityLogger::getInstance().connectedDevice("spatial_controller", "steamVR");
+    } else {
+        // The sampler has already published cleared poses, as no controllers are tracked
+        userInputMapper->removeDevice(_inputDevice->_deviceID);
+        _registeredWithInputMapper = false;
     }
 }
 
 void ViveControllerManager::InputDevice::update(float deltaTime, const controller::InputCalibrationData& inputCalibrationData, bool jointsCaptured) {
-    _poseStateMap.clear();
-    _buttonPressedMap.clear();
+    clearPoses();
+    clearButtons();
 
     PerformanceTimer perfTimer("ViveControllerManager::update");
 
@@ -249,6 +263,7 @@ void ViveControllerManager::InputDevice::update(float deltaTime, const controlle
         numTrackedControllers++;
     }
     _trackedControllers = numTrackedControllers;
+    publishState();
 }
 
 void ViveControllerManager::InputDevice::handleHandController(float deltaTime, uint32_t deviceIndex, const controller::InputCalibrationData& inputCalibrationData, bool isLeftHand) {
@@ -282,8 +297,9 @@ void ViveControllerManager::InputDevice::handleHandController(float deltaTime, u
 }
 
 void ViveControllerManager::InputDevice::focusOutEvent() {
-    _axisStateMap.clear();
-    _buttonPressedMap.clear();
+    clearAxes();
+    clearButtons();
+    publishState();
 };
 
 // These functions do translation from the Steam IDs to the standard controller IDs
@@ -299,10 +315,10 @@ void ViveControllerManager::InputDevice::handleAxisEvent(float deltaTime, uint32
         } else {
             stick = _filteredRightStick.process(deltaTime, stick);
         }
-        _axisStateMap[isLeftHand ? LX : RX] = stick.x;
-        _axisStateMap[isLeftHand ? LY : RY] = stick.y;
+        setAxis(isLeftHand ? LX : RX, stick.x);
+        setAxis(isLeftHand ? LY : RY, stick.y);
     } else if (axis == vr::k_EButton_SteamVR_Trigger) {
-        _axisStateMap[isLeftHand ? LT : RT] = x;
+        setAxis(isLeftHand ? LT : RT, x);
     }
 }
 
@@ -321,13 +337,13 @@ void ViveControllerManager::InputDevice::handleButtonEvent(float deltaTime, uint
 
     using namespace controller;
     if (button == vr::k_EButton_ApplicationMenu) {
-        _buttonPressedMap.insert(isLeftHand ? LEFT_APP_MENU : RIGHT_APP_MENU);
+        setButton(isLeftHand ? LEFT_APP_MENU : RIGHT_APP_MENU, true);
     } else if (button == vr::k_EButton_Grip) {
-        _buttonPressedMap.insert(isLeftHand ? LB : RB);
+        setButton(isLeftHand ? LB : RB, true);
     } else if (button == vr::k_EButton_SteamVR_Trigger) {
-        _buttonPressedMap.insert(isLeftHand ? LT : RT);
+        setButton(isLeftHand ? LT : RT, true);
     } else if (button == vr::k_EButton_SteamVR_Touchpad) {
-        _buttonPressedMap.insert(isLeftHand ? LS : RS);
+        setButton(isLeftHand ? LS : RS, true);
     }
 }
 
@@ -413,7 +429,7 @@ void ViveControllerManager::InputDevice::handlePoseEvent(float deltaTime, const
     // handle change in velocity due to translationOffset
     avatarPose.velocity = linearVelocity + glm::cross(angularVelocity, position - extractTranslation(mat));
     avatarPose.angularVelocity = angularVelocity;
-    _poseStateMap[isLeftHand ? controller::LEFT_HAND : controller::RIGHT_HAND] = avatarPose.transform(controllerToAvatar);
+    setPose(isLeftHand ? controller::LEFT_HAND : controller::RIGHT_HAND, avatarPose.transform(controllerToAvatar));
 }
 
 controller::Input::NamedVector ViveControllerManager::InputDevice::getAvailableInputs() const {
@@ -13,6 +13,7 @@
 #define hifi__ViveControllerManager
 
 #include <QObject>
+#include <atomic>
 #include <unordered_set>
 
 #include <GLMHelpers.h>
@@ -35,6 +36,7 @@ public:
     // Plugin functions
     virtual bool isSupported() const override;
     virtual bool isJointController() const override { return true; }
+    virtual bool supportsThreadedSampling() const override { return true; }
     const QString& getName() const override { return NAME; }
 
     virtual bool activate() override;
@@ -47,6 +49,9 @@ public:
 
     void setRenderControllers(bool renderControllers) { _renderControllers = renderControllers; }
 
+private slots:
+    void updateRegistration(bool tracked);
+
 private:
     class InputDevice : public controller::InputDevice {
     public:
@@ -98,7 +103,9 @@ private:
 
     void renderHand(const controller::Pose& pose, gpu::Batch& batch, int sign);
 
-    bool _registeredWithInputMapper { false };
+    // Changed only on the main thread, read by the sampler thread
+    std::atomic<bool> _registeredWithInputMapper { false };
+    std::atomic<bool> _registrationQueued { false };
     bool _modelLoaded { false };
     model::Geometry _modelGeometry;
     gpu::TexturePointer _texture;
@@ -155,22 +155,24 @@ QString OculusControllerManager::RemoteDevice::getDefaultMappingConfig() const {
 }
 
 void OculusControllerManager::RemoteDevice::update(float deltaTime, const controller::InputCalibrationData& inputCalibrationData, bool jointsCaptured) {
-    _buttonPressedMap.clear();
+    clearButtons();
     const auto& inputState = _parent._inputState;
     for (const auto& pair : BUTTON_MAP) {
         if (inputState.Buttons & pair.first) {
-            _buttonPressedMap.insert(pair.second);
+            setButton(pair.second, true);
         }
     }
+    publishState();
 }
 
 void OculusControllerManager::RemoteDevice::focusOutEvent() {
-    _buttonPressedMap.clear();
+    clearButtons();
+    publishState();
 }
 
 void OculusControllerManager::TouchDevice::update(float deltaTime, const controller::InputCalibrationData& inputCalibrationData, bool jointsCaptured) {
-    _poseStateMap.clear();
-    _buttonPressedMap.clear();
+    clearPoses();
+    clearButtons();
 
     if (!jointsCaptured) {
         int numTrackedControllers = 0;
@@ -186,44 +188,47 @@ void OculusControllerManager::TouchDevice::update(float deltaTime, const control
     using namespace controller;
     // Axes
     const auto& inputState = _parent._inputState;
-    _axisStateMap[LX] = inputState.Thumbstick[ovrHand_Left].x;
-    _axisStateMap[LY] = inputState.Thumbstick[ovrHand_Left].y;
-    _axisStateMap[LT] = inputState.IndexTrigger[ovrHand_Left];
-    _axisStateMap[LG] = inputState.HandTrigger[ovrHand_Left];
+    setAxis(LX, inputState.Thumbstick[ovrHand_Left].x);
+    setAxis(LY, inputState.Thumbstick[ovrHand_Left].y);
+    setAxis(LT, inputState.IndexTrigger[ovrHand_Left]);
+    setAxis(LG, inputState.HandTrigger[ovrHand_Left]);
 
-    _axisStateMap[RX] = inputState.Thumbstick[ovrHand_Right].x;
-    _axisStateMap[RY] = inputState.Thumbstick[ovrHand_Right].y;
-    _axisStateMap[RT] = inputState.IndexTrigger[ovrHand_Right];
-    _axisStateMap[RG] = inputState.HandTrigger[ovrHand_Right];
+    setAxis(RX, inputState.Thumbstick[ovrHand_Right].x);
+    setAxis(RY, inputState.Thumbstick[ovrHand_Right].y);
+    setAxis(RT, inputState.IndexTrigger[ovrHand_Right]);
+    setAxis(RG, inputState.HandTrigger[ovrHand_Right]);
 
     // Buttons
     for (const auto& pair : BUTTON_MAP) {
         if (inputState.Buttons & pair.first) {
-            _buttonPressedMap.insert(pair.second);
+            setButton(pair.second, true);
         }
     }
     // Touches
     for (const auto& pair : TOUCH_MAP) {
         if (inputState.Touches & pair.first) {
-            _buttonPressedMap.insert(pair.second);
+            setButton(pair.second, true);
         }
     }
+    publishState();
 }
 
 void OculusControllerManager::TouchDevice::focusOutEvent() {
-    _axisStateMap.clear();
-    _buttonPressedMap.clear();
+    clearAxes();
+    clearButtons();
+    publishState();
 };
 
 void OculusControllerManager::TouchDevice::handlePose(float deltaTime, 
     const controller::InputCalibrationData& inputCalibrationData, ovrHandType hand, 
     const ovrPoseStatef& handPose) {
     auto poseId = hand == ovrHand_Left ? controller::LEFT_HAND : controller::RIGHT_HAND;
-    auto& pose = _poseStateMap[poseId];
+    controller::Pose pose;
     pose.translation = toGlm(handPose.ThePose.Position);
     pose.rotation = toGlm(handPose.ThePose.Orientation);
     pose.angularVelocity = toGlm(handPose.AngularVelocity);
     pose.velocity = toGlm(handPose.LinearVelocity);
+    setPose(poseId, pose);
 }
 
 controller::Input::NamedVector OculusControllerManager::TouchDevice::getAvailableInputs() const {
@@ -25,6 +25,7 @@ public:
     // Plugin functions
     bool isSupported() const override;
     bool isJointController() const override { return true; }
+    bool supportsThreadedSampling() const override { return true; }
     const QString& getName() const override { return NAME; }
 
     bool activate() override;
@@ -0,0 +1,65 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> allocations { 0 };
+static std::atomic<uint64_t> allocatedBytes { 0 };
+
+AllocationCount AllocationCount::now() {
+    AllocationCount result;
+    result.allocations = allocations.load(std::memory_order_relaxed);
+    result.bytes = allocatedBytes.load(std::memory_order_relaxed);
+    return result;
+}
+
+static void* countedAllocate(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void* operator new(size_t size) {
+    void* result = countedAllocate(size);
+    if (!result) {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    free(pointer);
+}
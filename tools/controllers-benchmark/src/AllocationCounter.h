@@ -0,0 +1,31 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_AllocationCounter_h
+#define hifi_AllocationCounter_h
+
+#include <stdint.h>
+
+// Counts every heap allocation made through operator new, on any thread, by
+// replacing the global allocation functions for the whole benchmark.  On Windows
+// the replacement doesn't reach into DLLs, so allocations inside Qt aren't seen.
+struct AllocationCount {
+    uint64_t allocations { 0 };
+    uint64_t bytes { 0 };
+
+    static AllocationCount now();
+    AllocationCount operator-(const AllocationCount& other) const {
+        AllocationCount result;
+        result.allocations = allocations - other.allocations;
+        result.bytes = bytes - other.bytes;
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,65 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "SyntheticDevice.h"
+
+#include <cmath>
+
+#include <GLMHelpers.h>
+
+using namespace controller;
+
+SyntheticDevice::SyntheticDevice(const QString& name, int axes, int buttons, int poses)
+    : InputDevice(name), _axes(axes), _buttons(buttons), _poses(poses) {
+}
+
+Input::NamedVector SyntheticDevice::getAvailableInputs() const {
+    Input::NamedVector availableInputs;
+    for (int axis = 0; axis < _axes; ++axis) {
+        availableInputs.push_back(Input::NamedPair(Input(_deviceID, axis, ChannelType::AXIS), axisName(axis)));
+    }
+    // Buttons are numbered after the axes so every channel is unique
+    for (int button = 0; button < _buttons; ++button) {
+        availableInputs.push_back(Input::NamedPair(Input(_deviceID, _axes + button, ChannelType::BUTTON), buttonName(button)));
+    }
+    for (int pose = 0; pose < _poses; ++pose) {
+        availableInputs.push_back(Input::NamedPair(Input(_deviceID, _axes + _buttons + pose, ChannelType::POSE), poseName(pose)));
+    }
+    return availableInputs;
+}
+
+void SyntheticDevice::update(float deltaTime, const InputCalibrationData& inputCalibrationData, bool jointsCaptured) {
+    _time += deltaTime;
+    ++_frame;
+    for (int axis = 0; axis < _axes; ++axis) {
+        setAxis(axis, sinf(_time * (1.0f + 0.1f * axis)));
+    }
+    for (int button = 0; button < _buttons; ++button) {
+        setButton(_axes + button, ((_frame / (button + 1)) & 1) != 0);
+    }
+    // Hands waving in circles, dropping tracking now and then
+    for (int pose = 0; pose < _poses; ++pose) {
+        float phase = _time * (1.0f + 0.1f * pose);
+        if ((_frame + pose * 7) % 200 < 2) {
+            setPose(_axes + _buttons + pose, Pose());
+            continue;
+        }
+        vec3 translation(0.3f * cosf(phase), 1.0f + 0.3f * sinf(phase), -0.3f);
+        vec3 velocity(-0.3f * sinf(phase), 0.3f * cosf(phase), 0.0f);
+        vec3 angularVelocity(0.0f, 1.0f, 0.0f);
+        setPose(_axes + _buttons + pose, Pose(translation, glm::angleAxis(phase, Vectors::UNIT_Y), velocity, angularVelocity));
+    }
+    publishState();
+}
+
+void SyntheticDevice::focusOutEvent() {
+    clearAxes();
+    clearButtons();
+    clearPoses();
+    publishState();
+}
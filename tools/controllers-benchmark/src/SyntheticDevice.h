@@ -0,0 +1,46 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+#ifndef hifi_SyntheticDevice_h
+#define hifi_SyntheticDevice_h
+
+#include <controllers/InputDevice.h>
+
+// An input device with a configurable number of channels, driven by
+// deterministic waveforms so that runs are repeatable
+class SyntheticDevice : public controller::InputDevice {
+public:
+    using Pointer = std::shared_ptr<SyntheticDevice>;
+
+    SyntheticDevice(const QString& name, int axes, int buttons, int poses = 0);
+
+    int getAxisCount() const { return _axes; }
+    int getButtonCount() const { return _buttons; }
+    int getPoseCount() const { return _poses; }
+    QString axisName(int axis) const { return QString("Axis%1").arg(axis); }
+    QString buttonName(int button) const { return QString("Button%1").arg(button); }
+    QString poseName(int pose) const { return QString("Pose%1").arg(pose); }
+
+    void update(float deltaTime, const controller::InputCalibrationData& inputCalibrationData, bool jointsCaptured) override;
+    void focusOutEvent() override;
+
+protected:
+    controller::Input::NamedVector getAvailableInputs() const override;
+    // No default mapping, the benchmark generates its own
+    QStringList getDefaultMappingConfigs() const override { return QStringList(); }
+
+private:
+    const int _axes;
+    const int _buttons;
+    const int _poses;
+    float _time { 0.0f };
+    uint32_t _frame { 0 };
+};
+
+#endif
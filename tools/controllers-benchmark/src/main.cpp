@@ -0,0 +1,502 @@
+//
+//  Created by Bradley Austin Davis on 2016/03/10
+//  Copyright 2016 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <DependencyManager.h>
+#include <NumericalConstants.h>
+#include <SharedUtil.h>
+
+#include <controllers/InputRecorder.h>
+#include <controllers/UserInputMapper.h>
+
+#include "AllocationCounter.h"
+#include "SyntheticDevice.h"
+
+using namespace controller;
+
+// Bump when the meaning of an existing result changes
+static const int RESULTS_VERSION = 1;
+
+static const int DEFAULT_DEVICES = 1;
+static const int DEFAULT_ROUTES = 4000;
+static const int DEFAULT_UPDATES = 10000;
+static const int DEFAULT_WARMUP_UPDATES = 100;
+static const int DEFAULT_AXES = 48;
+static const int DEFAULT_BUTTONS = 16;
+static const int DEFAULT_POSES = 2;
+static const float UPDATE_INTERVAL = 1.0f / 90.0f;
+static const QString MAPPING_NAME = "Benchmark";
+
+struct Scenario {
+    QString name;
+    int devices;
+    int axes;
+    int buttons;
+    int poses;
+    int routes;
+};
+
+// Run by --suite, keep the names stable so results can be compared between versions
+static const std::vector<Scenario> SUITE {
+    // A gamepad with its default mapping
+    { "gamepad", 1, 8, 16, 0, 60 },
+    // Two tracked hand controllers, a keyboard and mouse
+    { "vr", 3, 8, 24, 2, 300 },
+    // Far more than anyone should ever map
+    { "stress", 4, 48, 16, 4, 4000 },
+};
+
+static int intOption(int argc, const char* argv[], const char* option, int defaultValue) {
+    const char* value = getCmdOption(argc, argv, option);
+    return value ? QString(value).toInt() : defaultValue;
+}
+
+// Nearest rank percentiles of the samples
+static QJsonObject summarize(std::vector<double> samples) {
+    QJsonObject result;
+    if (samples.empty()) {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        size_t rank = (size_t)std::ceil(p * samples.size());
+        return samples[std::min(std::max(rank, (size_t)1), samples.size()) - 1];
+    };
+    double total = 0.0;
+    for (auto sample : samples) {
+        total += sample;
+    }
+    result["mean"] = total / samples.size();
+    result["p50"] = percentile(0.50);
+    result["p90"] = percentile(0.90);
+    result["p99"] = percentile(0.99);
+    result["max"] = samples.back();
+    return result;
+}
+
+// The names of the channels of the given type
+static QStringList channelNames(const Input::NamedVector& inputs, ChannelType type) {
+    QStringList names;
+    for (const auto& input : inputs) {
+        if (input.first.getType() == type) {
+            names << input.second;
+        }
+    }
+    return names;
+}
+
+// The full channel names of one device, by type
+struct DeviceChannels {
+    QStringList axes;
+    QStringList buttons;
+    QStringList poses;
+
+    DeviceChannels(const QString& deviceName, const Input::NamedVector& inputs) {
+        for (const auto& name : channelNames(inputs, ChannelType::AXIS)) {
+            axes << deviceName + "." + name;
+        }
+        for (const auto& name : channelNames(inputs, ChannelType::BUTTON)) {
+            buttons << deviceName + "." + name;
+        }
+        for (const auto& name : channelNames(inputs, ChannelType::POSE)) {
+            poses << deviceName + "." + name;
+        }
+    }
+};
+
+static QJsonObject filter(const QString& type, const QJsonObject& parameters = QJsonObject()) {
+    QJsonObject result = parameters;
+    result["type"] = type;
+    return result;
+}
+
+// Routes from the devices to actions and standard channels, plus standard
+// loopbacks and standard to action routes.  Readers and writers of each standard
+// channel are interleaved, so the mapper has to reorder them.  The routes use
+// every kind of endpoint, conditional and built in filter.
+static QJsonObject generateMapping(const std::vector<DeviceChannels>& devices, const Input::NamedVector& standardInputs,
+                                   const Input::NamedVector& actionInputs, int routeCount) {
+    const auto standardAxes = channelNames(standardInputs, ChannelType::AXIS);
+    const auto standardPoses = channelNames(standardInputs, ChannelType::POSE);
+    const auto actions = channelNames(actionInputs, ChannelType::AXIS);
+
+    QJsonArray channels;
+    for (int i = 0; i < routeCount; ++i) {
+        const auto& device = devices[i % devices.size()];
+        QJsonObject route;
+        auto axis = [&](int offset) { return device.axes[(i + offset) % device.axes.size()]; };
+        auto button = [&](int offset) { return device.buttons[(i + offset) % device.buttons.size()]; };
+        const QString standard = "Standard." + standardAxes[i % standardAxes.size()];
+        const QString action = "Actions." + actions[i % actions.size()];
+        int kind = i % 16;
+        // Devices without poses get value routes instead
+        if (kind >= 14 && device.poses.empty()) {
+            kind -= 14;
+        }
+        switch (kind) {
+            case 0: case 1: case 2: case 3: case 4: case 5: {
+                route["from"] = axis(0);
+                route["to"] = action;
+                QJsonArray filters;
+                filters.append(filter("deadZone", { { "min", 0.1 } }));
+                filters.append(filter("scale", { { "scale", 0.5 + (i % 7) * 0.25 } }));
+                filters.append(filter("clamp", { { "min", -1.0 }, { "max", 1.0 } }));
+                route["filters"] = filters;
+                if (i % 3 == 0) {
+                    route["when"] = (i % 2) ? button(0) : "!" + button(0);
+                }
+                break;
+            }
+
+            case 6: case 7:
+                route["from"] = axis(0);
+                route["to"] = standard;
+                break;
+
+            case 8:
+                route["from"] = standard;
+                route["to"] = action;
+                route["peek"] = true;
+                break;
+
+            case 9: {
+                // Always loop forward through the standard channels, to avoid cycles
+                int index = i % standardAxes.size();
+                if (index + 1 >= standardAxes.size()) {
+                    index = 0;
+                }
+                route["from"] = "Standard." + standardAxes[index];
+                route["to"] = "Standard." + standardAxes[index + 1];
+                route["peek"] = true;
+                QJsonArray filters;
+                filters.append("invert");
+                route["filters"] = filters;
+                break;
+            }
+
+            case 10: {
+                // Composite endpoint
+                route["from"] = QJsonObject { { "makeAxis", QJsonArray { button(0), button(1) } } };
+                route["to"] = action;
+                QJsonArray filters;
+                filters.append(filter("scale", { { "scale", 2.0 } }));
+                route["filters"] = filters;
+                break;
+            }
+
+            case 11: {
+                // Any endpoint
+                route["from"] = QJsonArray { axis(0), axis(1) };
+                route["to"] = action;
+                QJsonArray filters;
+                filters.append(filter("hysteresis", { { "min", 0.25 }, { "max", 0.75 } }));
+                filters.append("constrainToInteger");
+                route["filters"] = filters;
+                break;
+            }
+
+            case 12: {
+                // And of an endpoint and a not conditional
+                route["from"] = button(0);
+                route["to"] = action;
+                route["when"] = QJsonArray { button(1), "!" + button(2) };
+                QJsonArray filters;
+                filters.append(filter("pulse", { { "interval", 0.5 } }));
+                route["filters"] = filters;
+                break;
+            }
+
+            case 13: {
+                // Array destination
+                route["from"] = axis(0);
+                route["to"] = QJsonArray { action, "Actions." + actions[(i + 1) % actions.size()] };
+                QJsonArray filters;
+                filters.append(filter("deadZone", { { "min", 0.2 } }));
+                filters.append("constrainToPositiveInteger");
+                route["filters"] = filters;
+                break;
+            }
+
+            case 14: case 15: {
+                route["from"] = device.poses[i % device.poses.size()];
+                route["to"] = "Standard." + standardPoses[i % standardPoses.size()];
+                QJsonArray filters;
+                if (kind == 14) {
+                    filters.append(filter("exponentialSmoothing", { { "translation", 0.2 }, { "rotation", 0.2 } }));
+                    filters.append(filter("velocityExtrapolation", { { "max", 0.05 } }));
+                } else {
+                    filters.append(filter("oneEuro"));
+                    filters.append(filter("deadBand"));
+                }
+                route["filters"] = filters;
+                break;
+            }
+        }
+        channels.append(route);
+    }
+
+    QJsonObject mapping;
+    mapping["name"] = MAPPING_NAME;
+    mapping["channels"] = channels;
+    return mapping;
+}
+
+// Loads either the given mapping file, or routes generated against the devices
+static bool loadMapping(UserInputMapper& userInputMapper, const std::vector<InputDevice::Pointer>& devices,
+                        const char* mappingPath, int routes, QJsonObject& result) {
+    QElapsedTimer timer;
+    timer.start();
+    if (mappingPath) {
+        // Parsed directly, UserInputMapper::loadMapping only loads each file once per run
+        QFile file(mappingPath);
+        if (!file.open(QFile::ReadOnly)) {
+            qWarning() << "Unable to read the mapping" << mappingPath;
+            return false;
+        }
+        auto json = QString::fromUtf8(file.readAll());
+        timer.restart();
+        auto mapping = userInputMapper.parseMapping(json);
+        if (!mapping) {
+            qWarning() << "Unable to parse the mapping" << mappingPath;
+            return false;
+        }
+        result["parseMsecs"] = (double)timer.nsecsElapsed() / (NSECS_PER_USEC * USECS_PER_MSEC);
+        timer.restart();
+        userInputMapper.enableMapping(mapping->name);
+        result["enableMsecs"] = (double)timer.nsecsElapsed() / (NSECS_PER_USEC * USECS_PER_MSEC);
+        return true;
+    }
+
+    std::vector<DeviceChannels> channels;
+    for (const auto& device : devices) {
+        DeviceChannels deviceChannels(device->getName(), userInputMapper.getAvailableInputs(device->getDeviceID()));
+        if (deviceChannels.axes.empty() || deviceChannels.buttons.empty()) {
+            qWarning() << "Routes can only be generated for devices with axes and buttons, give a mapping";
+            return false;
+        }
+        channels.push_back(deviceChannels);
+    }
+    auto json = QJsonDocument(generateMapping(channels, userInputMapper.getStandardInputs(), userInputMapper.getActionInputs(), routes)).toJson();
+    timer.restart();
+    if (!userInputMapper.parseMapping(QString(json))) {
+        qWarning() << "Unable to parse the generated mapping";
+        return false;
+    }
+    result["parseMsecs"] = (double)timer.nsecsElapsed() / (NSECS_PER_USEC * USECS_PER_MSEC);
+    timer.restart();
+    userInputMapper.enableMapping(MAPPING_NAME);
+    result["enableMsecs"] = (double)timer.nsecsElapsed() / (NSECS_PER_USEC * USECS_PER_MSEC);
+    return true;
+}
+
+// Publishes the device state for an update and gives its deltaTime, returns false when there are no more
+using StepFunction = std::function<bool(float&)>;
+
+static void warmUp(UserInputMapper& userInputMapper, const StepFunction& step, int updates) {
+    for (int i = 0; i < updates; ++i) {
+        float deltaTime = UPDATE_INTERVAL;
+        if (!step(deltaTime)) {
+            break;
+        }
+        userInputMapper.update(deltaTime);
+    }
+}
+
+// Times UserInputMapper::update, with step() called outside of the timing
+static void measureUpdates(UserInputMapper& userInputMapper, const StepFunction& step, int updates, QJsonObject& result) {
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<double> updateTimes;
+    std::vector<double> updateAllocations;
+    std::vector<double> updateBytes;
+    double totalUsecs = 0.0;
+    for (int i = 0; i < updates; ++i) {
+        float deltaTime = UPDATE_INTERVAL;
+        if (!step(deltaTime)) {
+            break;
+        }
+        auto allocationsBefore = AllocationCount::now();
+        timer.restart();
+        userInputMapper.update(deltaTime);
+        double usecs = (double)timer.nsecsElapsed() / NSECS_PER_USEC;
+        auto allocations = AllocationCount::now() - allocationsBefore;
+        totalUsecs += usecs;
+        updateTimes.push_back(usecs);
+        updateAllocations.push_back((double)allocations.allocations);
+        updateBytes.push_back((double)allocations.bytes);
+    }
+
+    result["updates"] = (int)updateTimes.size();
+    result["updateUsecs"] = summarize(updateTimes);
+    result["updatesPerSecond"] = totalUsecs > 0.0 ? (double)updateTimes.size() * USECS_PER_SECOND / totalUsecs : 0.0;
+    result["allocationsPerUpdate"] = summarize(updateAllocations);
+    result["allocatedBytesPerUpdate"] = summarize(updateBytes);
+}
+
+static QJsonObject runScenario(const Scenario& scenario, int warmup, int updates, const char* mappingPath, const char* recordPath) {
+    QJsonObject result;
+    result["name"] = scenario.name;
+    result["devices"] = scenario.devices;
+    result["axes"] = scenario.axes;
+    result["buttons"] = scenario.buttons;
+    result["poses"] = scenario.poses;
+    if (!mappingPath) {
+        result["routes"] = scenario.routes;
+    }
+
+    auto userInputMapper = DependencyManager::set<UserInputMapper>();
+    std::vector<SyntheticDevice::Pointer> devices;
+    std::vector<InputDevice::Pointer> mappedDevices;
+    for (int i = 0; i < scenario.devices; ++i) {
+        auto name = scenario.devices > 1 ? QString("Synthetic%1").arg(i) : QString("Synthetic");
+        auto device = std::make_shared<SyntheticDevice>(name, scenario.axes, scenario.buttons, scenario.poses);
+        userInputMapper->registerDevice(device);
+        devices.push_back(device);
+        mappedDevices.push_back(device);
+    }
+
+    if (loadMapping(*userInputMapper, mappedDevices, mappingPath, scenario.routes, result)) {
+        InputCalibrationData calibration;
+        StepFunction step = [&](float& deltaTime) {
+            for (const auto& device : devices) {
+                device->update(deltaTime, calibration, false);
+            }
+            return true;
+        };
+        warmUp(*userInputMapper, step, warmup);
+        // Only the timed updates are recorded, so replaying the recording repeats them
+        if (recordPath && !userInputMapper->startRecording(recordPath)) {
+            result["error"] = "Unable to record";
+        } else {
+            measureUpdates(*userInputMapper, step, updates, result);
+            userInputMapper->stopRecording();
+        }
+    } else {
+        result["error"] = "Unable to load the mapping";
+    }
+
+    DependencyManager::destroy<UserInputMapper>();
+    return result;
+}
+
+static QJsonObject runReplay(const char* replayPath, bool realTime, const char* mappingPath, int routes) {
+    QJsonObject result;
+    result["name"] = "replay";
+    result["recording"] = QString(replayPath);
+    if (!mappingPath) {
+        result["routes"] = routes;
+    }
+
+    InputPlayer player;
+    if (!player.open(replayPath) || player.getDevices().empty()) {
+        result["error"] = "Unable to replay the recording";
+        return result;
+    }
+    player.setPacing(realTime ? InputPlayer::Pacing::REAL_TIME : InputPlayer::Pacing::FULL_SPEED);
+
+    auto userInputMapper = DependencyManager::set<UserInputMapper>();
+    std::vector<InputDevice::Pointer> mappedDevices;
+    for (const auto& device : player.getDevices()) {
+        userInputMapper->registerDevice(device);
+        mappedDevices.push_back(device);
+    }
+    result["devices"] = (int)mappedDevices.size();
+
+    if (loadMapping(*userInputMapper, mappedDevices, mappingPath, routes, result)) {
+        measureUpdates(*userInputMapper, [&](float& deltaTime) { return player.step(deltaTime); }, INT_MAX, result);
+    } else {
+        result["error"] = "Unable to load the mapping";
+    }
+
+    DependencyManager::destroy<UserInputMapper>();
+    return result;
+}
+
+// Measures the cost of UserInputMapper::update with generated mappings on synthetic
+// devices, reporting the time and heap allocations of each update as JSON.
+//
+//   --suite             runs the standard scenarios, rather than one configured below
+//   --devices <count>   number of synthetic devices
+//   --axes <count>      axis channels on each synthetic device
+//   --buttons <count>   button channels on each synthetic device
+//   --poses <count>     pose channels on each synthetic device
+//   --routes <count>    number of generated routes
+//   --updates <count>   number of timed updates for each scenario
+//   --warmup <count>    number of untimed updates before the timed ones
+//   --mapping <file>    mapping to run instead of the generated routes
+//   --record <file>     records the timed updates, for a single scenario
+//   --output <file>     writes the results to the file rather than stdout
+//
+// Or replays a recording instead of driving synthetic devices:
+//
+//   --replay <file>     the recording to replay, once, routes are generated
+//                       against the recorded devices unless a mapping is given
+//   --realtime          replays at the recorded rate instead of at full speed
+int main(int argc, const char* argv[]) {
+    QCoreApplication app(argc, const_cast<char**>(argv));
+    const int updates = std::max(intOption(argc, argv, "--updates", DEFAULT_UPDATES), 1);
+    const int warmup = std::max(intOption(argc, argv, "--warmup", DEFAULT_WARMUP_UPDATES), 0);
+    const int routes = std::max(intOption(argc, argv, "--routes", DEFAULT_ROUTES), 1);
+    const char* mappingPath = getCmdOption(argc, argv, "--mapping");
+    const char* recordPath = getCmdOption(argc, argv, "--record");
+    const char* replayPath = getCmdOption(argc, argv, "--replay");
+    const char* outputPath = getCmdOption(argc, argv, "--output");
+
+    QJsonArray scenarios;
+    if (replayPath) {
+        scenarios.append(runReplay(replayPath, cmdOptionExists(argc, argv, "--realtime"), mappingPath, routes));
+    } else if (cmdOptionExists(argc, argv, "--suite")) {
+        for (const auto& scenario : SUITE) {
+            scenarios.append(runScenario(scenario, warmup, updates, mappingPath, nullptr));
+        }
+    } else {
+        Scenario scenario;
+        scenario.name = "custom";
+        scenario.devices = std::max(intOption(argc, argv, "--devices", DEFAULT_DEVICES), 1);
+        scenario.axes = std::max(intOption(argc, argv, "--axes", DEFAULT_AXES), 1);
+        scenario.buttons = std::max(intOption(argc, argv, "--buttons", DEFAULT_BUTTONS), 1);
+        scenario.poses = std::max(intOption(argc, argv, "--poses", DEFAULT_POSES), 0);
+        scenario.routes = routes;
+        scenarios.append(runScenario(scenario, warmup, updates, mappingPath, recordPath));
+    }
+
+    QJsonObject results;
+    results["version"] = RESULTS_VERSION;
+    results["scenarios"] = scenarios;
+    auto json = QJsonDocument(results).toJson(QJsonDocument::Indented);
+    if (outputPath) {
+        QFile output(outputPath);
+        if (!output.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+            qWarning() << "Unable to write the results to" << outputPath;
+            return -1;
+        }
+        output.write(json);
+    } else {
+        printf("%s", json.constData());
+    }
+
+    bool failed = false;
+    for (const auto& scenario : scenarios) {
+        failed = failed || scenario.toObject().contains("error");
+    }
+    return failed ? -1 : 0;
+}